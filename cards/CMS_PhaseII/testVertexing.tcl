@@ -244,6 +244,17 @@ module VertexFinderDA4D VertexFinderDA4D {
   set DzCutOff 40
   set D0CutOff 30
 
+  # evaluate only track-vertex pairs within DzCutOff
+  set UseZWindow 1
+
+  # in mm, anneal tracks separated by larger gaps in z independently (0 = off);
+  # the regions run on OpenMP threads when Delphes is built with OpenMP
+  # (OMP_NUM_THREADS sets their number). Vertices closer than the gap to a
+  # region boundary may be found differently, a gap of several times the
+  # track z resolution (e.g. 10 mm) keeps this negligible, but at high
+  # pile-up the tracks seldom leave such gaps and a single region is used
+  set ZRegionGap 0
+
 }
 
 ##################################
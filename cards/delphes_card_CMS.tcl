@@ -779,7 +779,39 @@ module UniqueObjectFinder UniqueObjectFinder {
 # if needed (for jet constituent or other studies), uncomment the relevant
 # "add Branch ..." lines.
 
+# set Columnar true writes flat per-member branches (Jet.PT[Jet_size], ...)
+# with index references instead of TClonesArray branches with TRef links.
+# BasketSize (bytes), CompressionSettings (100*algorithm + level) and
+# AutoFlush (entries if > 0, bytes if < 0) tune the output tree, the
+# defaults keep the ROOT settings. AutoSave (entries if > 0, bytes if < 0,
+# 0 to disable) sets the autosave interval. CompressionThreads > 0 compresses
+# the baskets in parallel with ROOT implicit multi-threading, which is then
+# enabled for the whole process: the ROOT reader of the input and any other
+# tree also use this pool, and a pool already enabled with another number of
+# threads is kept.
+# set IndexProvenance true writes the Particle(s) and Constituents links as
+# entry indices (Jet.Particles.Begin/End/Index/Branch, ...) instead of
+# TRef/TRefArray, ExRootTreeReader::UseLinks resolves them.
+
+# "add Selection BranchName MinPT MaxAbsEta MaxSize" writes only the objects
+# with PT >= MinPT and |Eta| <= MaxAbsEta (MaxAbsEta 0 for no eta cut, objects
+# along the beam axis pass only then), at most MaxSize of them by decreasing
+# PT (MaxSize 0 for no limit). Selecting generated particles leaves the
+# M1/M2/D1/D2 indices pointing to the full particle list, and the references
+# of other branches to particles that are not written are null (TRef) or -1
+# (IndexProvenance).
+# "add EventFilter InputArray MinPT MaxAbsEta MinSize" writes only the events
+# with at least MinSize objects passing the cuts, all filters must pass.
+
 module TreeWriter TreeWriter {
+  set Columnar false
+  set BasketSize 0
+  set CompressionSettings -1
+  set AutoFlush 0
+  set AutoSave 10000000
+  set CompressionThreads 0
+  set IndexProvenance false
+
 # add Branch InputArray BranchName BranchClass
   add Branch Delphes/allParticles Particle GenParticle
 
@@ -802,4 +834,7 @@ module TreeWriter TreeWriter {
 
   add Branch MissingET/momentum MissingET MissingET
   add Branch ScalarHT/energy ScalarHT ScalarHT
+
+# add Selection Jet 20.0 5.0 0
+# add EventFilter UniqueObjectFinder/jets 30.0 2.5 1
 }
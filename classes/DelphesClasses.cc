@@ -161,7 +161,9 @@ Candidate::Candidate() :
   ExclYmerge45(0),
   ExclYmerge56(0),
   fFactory(0),
-  fArray(0)
+  fArray(0),
+  fLeafBegin(-1),
+  fLeafEnd(-1)
 {
   int i;
   Edges[0] = 0.0;
@@ -197,6 +199,8 @@ void Candidate::AddCandidate(Candidate *object)
 {
   if(!fArray) fArray = fFactory->NewArray();
   fArray->Add(object);
+  fLeafBegin = -1;
+  fLeafEnd = -1;
 }
 
 //------------------------------------------------------------------------------
@@ -209,27 +213,45 @@ TObjArray *Candidate::GetCandidates()
 
 //------------------------------------------------------------------------------
 
-Bool_t Candidate::Overlaps(const Candidate *object) const
+Bool_t Candidate::HasCandidates() const
 {
-  const Candidate *candidate;
+  return fArray && fArray->GetEntriesFast() > 0;
+}
 
-  if(object->GetUniqueID() == GetUniqueID()) return kTRUE;
+//------------------------------------------------------------------------------
 
-  if(fArray)
-  {
-    TIter it(fArray);
-    while((candidate = static_cast<Candidate *>(it.Next())))
-    {
-      if(candidate->Overlaps(object)) return kTRUE;
-    }
-  }
+Int_t Candidate::GetNLeaves()
+{
+  if(fLeafBegin < 0) fFactory->FillLeaves(this);
+  return fLeafEnd - fLeafBegin;
+}
+
+//------------------------------------------------------------------------------
 
-  if(object->fArray)
+Candidate *Candidate::GetLeaf(Int_t i) const
+{
+  return fFactory->GetLeaf(fLeafBegin + i);
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t Candidate::Overlaps(const Candidate *object) const
+{
+  // two trees share a candidate exactly when they share one of its leaves
+  Candidate *candidate = const_cast<Candidate *>(this);
+  Candidate *other = const_cast<Candidate *>(object);
+  Int_t i, j, size, otherSize;
+  UInt_t id;
+
+  size = candidate->GetNLeaves();
+  otherSize = other->GetNLeaves();
+
+  for(i = 0; i < size; ++i)
   {
-    TIter it(object->fArray);
-    while((candidate = static_cast<Candidate *>(it.Next())))
+    id = candidate->GetLeaf(i)->GetUniqueID();
+    for(j = 0; j < otherSize; ++j)
     {
-      if(candidate->Overlaps(this)) return kTRUE;
+      if(other->GetLeaf(j)->GetUniqueID() == id) return kTRUE;
     }
   }
 
@@ -366,6 +388,8 @@ void Candidate::Copy(TObject &obj) const
 
   object.fFactory = fFactory;
   object.fArray = 0;
+  object.fLeafBegin = -1;
+  object.fLeafEnd = -1;
 
   // copy cluster timing info
   copy(ECalEnergyTimePairs.begin(), ECalEnergyTimePairs.end(), back_inserter(object.ECalEnergyTimePairs));
@@ -488,4 +512,7 @@ void Candidate::Clear(Option_t* option)
   NSubJetsSoftDropped = 0;
 
   fArray = 0;
+
+  fLeafBegin = -1;
+  fLeafEnd = -1;
 }
@@ -665,6 +665,15 @@ public:
 
   void AddCandidate(Candidate *object);
   TObjArray *GetCandidates();
+  Bool_t HasCandidates() const;
+
+  // generator-level particles at the leaves of the candidate tree,
+  // found once per event and kept in a pool of the factory.
+  // AddCandidate only resets the leaves of this candidate, not those of the
+  // candidates above it, so the tree below a candidate has to be complete
+  // before its leaves are queried
+  Int_t GetNLeaves();
+  Candidate *GetLeaf(Int_t i) const;
 
   Bool_t Overlaps(const Candidate *object) const;
 
@@ -676,6 +685,8 @@ private:
   DelphesFactory *fFactory; //!
   TObjArray *fArray; //!
 
+  Int_t fLeafBegin, fLeafEnd; //!
+
   void SetFactory(DelphesFactory *factory) { fFactory = factory; }
 
   ClassDef(Candidate, 5)
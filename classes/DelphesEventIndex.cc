@@ -0,0 +1,231 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class DelphesEventIndex
+ *
+ *  Byte offsets of every K-th event of a HepMC or LHEF file.
+ *
+ */
+
+#include "classes/DelphesEventIndex.h"
+
+#include <iostream>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const int kBufferSize = 16384;
+
+static const char *kIndexMagic = "DelphesEventIndex";
+static const int kIndexVersion = 1;
+
+//------------------------------------------------------------------------------
+
+DelphesEventIndex::DelphesEventIndex() :
+  fEvents(0), fStep(1), fSize(0), fTime(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+TString DelphesEventIndex::GetIndexName(const char *inputName)
+{
+  return TString::Format("%s.idx", inputName);
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesEventIndex::Load(const char *inputName, const char *marker, int step)
+{
+  if(Read(inputName) && fStep == step) return true;
+
+  cout << "** Indexing events of " << inputName << endl;
+
+  if(!Build(inputName, marker, step)) return false;
+
+  if(!Write(inputName))
+  {
+    cout << "** WARNING: can't write " << GetIndexName(inputName) << endl;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesEventIndex::Read(const char *inputName)
+{
+  FILE *indexFile;
+  char magic[32];
+  int version, step;
+  long long events, size, time, inputSize, inputTime;
+  size_t entries;
+
+  if(!GetFileInfo(inputName, inputSize, inputTime)) return false;
+
+  indexFile = fopen(GetIndexName(inputName), "rb");
+  if(!indexFile) return false;
+
+  if(fscanf(indexFile, "%31s %d %lld %lld %d %lld", magic, &version, &size, &time, &step, &events) != 6
+    || fgetc(indexFile) != '\n' || strcmp(magic, kIndexMagic) != 0 || version != kIndexVersion
+    || size != inputSize || time != inputTime || step < 1 || events < 0)
+  {
+    fclose(indexFile);
+    return false;
+  }
+
+  entries = events/step + 1;
+  fOffsets.resize(entries);
+  if(fread(&fOffsets[0], sizeof(long long), entries, indexFile) != entries)
+  {
+    fOffsets.clear();
+    fclose(indexFile);
+    return false;
+  }
+
+  fclose(indexFile);
+
+  fEvents = events;
+  fStep = step;
+  fSize = size;
+  fTime = time;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesEventIndex::Build(const char *inputName, const char *marker, int step)
+{
+  FILE *inputFile;
+  char *buffer, *pch;
+  size_t markerSize = strlen(marker);
+  long long position = 0, events = 0;
+  bool lineStart = true;
+
+  if(!GetFileInfo(inputName, fSize, fTime)) return false;
+
+  inputFile = fopen(inputName, "r");
+  if(!inputFile) return false;
+
+  fOffsets.clear();
+
+  buffer = new char[kBufferSize];
+
+  while(fgets(buffer, kBufferSize, inputFile))
+  {
+    // lines longer than the buffer are read in several pieces
+    if(lineStart)
+    {
+      pch = buffer + strspn(buffer, " \t");
+      if(strncmp(pch, marker, markerSize) == 0)
+      {
+        if(events % step == 0) fOffsets.push_back(position);
+        ++events;
+      }
+    }
+
+    position += strlen(buffer);
+    lineStart = (buffer[strlen(buffer) - 1] == '\n');
+  }
+
+  delete[] buffer;
+  fclose(inputFile);
+
+  // the offset after the last event closes the last indexed block
+  if(events % step == 0) fOffsets.push_back(position);
+
+  fEvents = events;
+  fStep = step;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesEventIndex::Write(const char *inputName) const
+{
+  FILE *indexFile;
+  TString indexName = GetIndexName(inputName);
+  TString tmpName = TString::Format("%s.%d", indexName.Data(), getpid());
+  bool rc;
+
+  indexFile = fopen(tmpName, "wb");
+  if(!indexFile) return false;
+
+  rc = fprintf(indexFile, "%s %d %lld %lld %d %lld\n", kIndexMagic, kIndexVersion, fSize, fTime, fStep, fEvents) > 0
+    && fwrite(&fOffsets[0], sizeof(long long), fOffsets.size(), indexFile) == fOffsets.size();
+
+  rc = (fclose(indexFile) == 0) && rc;
+
+  // concurrent jobs only ever see a complete index
+  if(rc) rc = (rename(tmpName, indexName) == 0);
+  if(!rc) unlink(tmpName);
+
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+
+long long DelphesEventIndex::GetIndexedEvent(long long event) const
+{
+  if(event <= 0) return 0;
+  if(event >= fEvents) return fEvents;
+  return (event/fStep)*fStep;
+}
+
+//------------------------------------------------------------------------------
+
+long long DelphesEventIndex::GetOffset(long long event) const
+{
+  if(event >= fEvents) return fSize;
+  return fOffsets[GetIndexedEvent(event)/fStep];
+}
+
+//------------------------------------------------------------------------------
+
+long long DelphesEventIndex::GetPartStart(long long first, long long last, int part, int parts) const
+{
+  long long event;
+
+  if(part <= 0) return first;
+  if(part >= parts) return last;
+
+  event = GetIndexedEvent(first + (last - first)*part/parts);
+
+  return event > first ? event : first;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesEventIndex::GetFileInfo(const char *inputName, long long &size, long long &time) const
+{
+  struct stat info;
+
+  if(stat(inputName, &info) != 0 || !S_ISREG(info.st_mode)) return false;
+
+  size = info.st_size;
+  time = info.st_mtime;
+
+  return true;
+}
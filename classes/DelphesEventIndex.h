@@ -0,0 +1,81 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesEventIndex_h
+#define DelphesEventIndex_h
+
+/** \class DelphesEventIndex
+ *
+ *  Byte offsets of every K-th event of a HepMC or LHEF file, stored in
+ *  a sidecar file next to the input file. The index gives the exact number
+ *  of events of the file and lets the readers seek to an event instead
+ *  of parsing all the events before it.
+ *
+ */
+
+#include "TString.h"
+
+#include <vector>
+
+class DelphesEventIndex
+{
+public:
+
+  DelphesEventIndex();
+
+  // name of the sidecar file of an input file
+  static TString GetIndexName(const char *inputName);
+
+  // reads the sidecar file of the input file, or builds it and tries
+  // to write it when it is missing, outdated or has another step
+  bool Load(const char *inputName, const char *marker, int step);
+
+  // reads the sidecar file, fails if it is missing
+  // or if the input file has changed since it was written
+  bool Read(const char *inputName);
+
+  // scans the input file for the lines starting with marker
+  // and keeps the offset of every step-th event
+  bool Build(const char *inputName, const char *marker, int step);
+
+  bool Write(const char *inputName) const;
+
+  long long GetEvents() const { return fEvents; }
+  int GetStep() const { return fStep; }
+
+  // last indexed event before event, and its byte offset
+  long long GetIndexedEvent(long long event) const;
+  long long GetOffset(long long event) const;
+
+  // first event of part of the events [first, last) split into parts,
+  // the parts start at indexed events
+  long long GetPartStart(long long first, long long last, int part, int parts) const;
+
+private:
+
+  bool GetFileInfo(const char *inputName, long long &size, long long &time) const;
+
+  long long fEvents;
+  int fStep;
+
+  long long fSize, fTime;
+
+  std::vector< long long > fOffsets;
+};
+
+#endif // DelphesEventIndex_h
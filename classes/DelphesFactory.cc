@@ -33,13 +33,18 @@
 
 #include "TClass.h"
 #include "TObjArray.h"
+#include "TProcessID.h"
+
+#include <atomic>
 
 using namespace std;
 
+static atomic< Long64_t > gFactoryCount(0);
+
 //------------------------------------------------------------------------------
 
 DelphesFactory::DelphesFactory(const char *name) :
-  TNamed(name, ""), fObjArrays(0)
+  TNamed(name, ""), fObjArrays(0), fId(++gFactoryCount)
 {
   fObjArrays = new ExRootTreeBranch("PermanentObjArrays", TObjArray::Class(), 0);
 }
@@ -48,12 +53,17 @@ DelphesFactory::DelphesFactory(const char *name) :
 
 DelphesFactory::~DelphesFactory()
 {
+  map< thread::id, TBranchMap >::iterator itThreads;
+  TBranchMap::iterator itBranches;
+
   if(fObjArrays) delete fObjArrays;
 
-  map< const TClass*, ExRootTreeBranch* >::iterator itBranches;
-  for(itBranches = fBranches.begin(); itBranches != fBranches.end(); ++itBranches)
+  for(itThreads = fBranches.begin(); itThreads != fBranches.end(); ++itThreads)
   {
-    delete (itBranches->second);
+    for(itBranches = itThreads->second.begin(); itBranches != itThreads->second.end(); ++itBranches)
+    {
+      delete (itBranches->second);
+    }
   }
 }
 
@@ -61,7 +71,10 @@ DelphesFactory::~DelphesFactory()
 
 void DelphesFactory::Clear(Option_t* option)
 {
+  map< thread::id, TBranchMap >::iterator itThreads;
+  TBranchMap::iterator itBranches;
   set<TObject *>::iterator itPool;
+
   for(itPool = fPool.begin(); itPool != fPool.end(); ++itPool)
   {
     (*itPool)->Clear();
@@ -69,17 +82,41 @@ void DelphesFactory::Clear(Option_t* option)
 
   TProcessID::SetObjectCount(0);
 
-  map< const TClass*, ExRootTreeBranch* >::iterator itBranches;
-  for(itBranches = fBranches.begin(); itBranches != fBranches.end(); ++itBranches)
+  fLeaves.clear();
+
+  for(itThreads = fBranches.begin(); itThreads != fBranches.end(); ++itThreads)
+  {
+    for(itBranches = itThreads->second.begin(); itBranches != itThreads->second.end(); ++itBranches)
+    {
+      itBranches->second->Clear();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+DelphesFactory::TBranchMap *DelphesFactory::GetBranches()
+{
+  // the pools of the last factory used by the thread are cached, the id
+  // of the factory tells apart factories allocated at the same address
+  static thread_local Long64_t cachedId = 0;
+  static thread_local TBranchMap *cachedBranches = 0;
+
+  if(cachedId != fId)
   {
-    itBranches->second->Clear();
+    lock_guard< mutex > lock(fMutex);
+    cachedBranches = &fBranches[this_thread::get_id()];
+    cachedId = fId;
   }
+
+  return cachedBranches;
 }
 
 //------------------------------------------------------------------------------
 
 TObjArray *DelphesFactory::NewPermanentArray()
 {
+  lock_guard< mutex > lock(fMutex);
   TObjArray *array = static_cast<TObjArray *>(fObjArrays->NewEntry());
   fPool.insert(array);
   return array;
@@ -91,7 +128,13 @@ Candidate *DelphesFactory::NewCandidate()
 {
   Candidate *object = New<Candidate>();
   object->SetFactory(this);
-  TProcessID::AssignID(object);
+
+  // the object count of TProcessID is global
+  {
+    lock_guard< mutex > lock(fMutex);
+    TProcessID::AssignID(object);
+  }
+
   return object;
 }
 
@@ -101,16 +144,18 @@ TObject *DelphesFactory::New(TClass *cl)
 {
   TObject *object = 0;
   ExRootTreeBranch *branch = 0;
-  map<const TClass *, ExRootTreeBranch *>::iterator it = fBranches.find(cl);
+  TBranchMap *branches = GetBranches();
+  TBranchMap::iterator it = branches->find(cl);
 
-  if(it != fBranches.end())
+  if(it != branches->end())
   {
     branch = it->second;
   }
   else
   {
+    lock_guard< mutex > lock(fMutex);
     branch = new ExRootTreeBranch(cl->GetName(), cl, 0);
-    fBranches.insert(make_pair(cl, branch));
+    branches->insert(make_pair(cl, branch));
   }
 
   object = branch->NewEntry();
@@ -120,3 +165,52 @@ TObject *DelphesFactory::New(TClass *cl)
 
 //------------------------------------------------------------------------------
 
+void DelphesFactory::FillLeaves(Candidate *candidate)
+{
+  Candidate *constituent, *leaf;
+  Int_t i, begin, end;
+
+  if(candidate->fLeafBegin >= 0) return;
+
+  if(!candidate->HasCandidates())
+  {
+    candidate->fLeafBegin = fLeaves.size();
+    fLeaves.push_back(candidate);
+    candidate->fLeafEnd = fLeaves.size();
+    return;
+  }
+
+  TIter it(candidate->fArray);
+  while((constituent = static_cast<Candidate *>(it.Next())))
+  {
+    FillLeaves(constituent);
+  }
+
+  // a single constituent shares its leaves
+  if(candidate->fArray->GetEntriesFast() == 1)
+  {
+    constituent = static_cast<Candidate *>(candidate->fArray->At(0));
+    candidate->fLeafBegin = constituent->fLeafBegin;
+    candidate->fLeafEnd = constituent->fLeafEnd;
+    return;
+  }
+
+  // leaves reached through several constituents are kept once
+  begin = fLeaves.size();
+  fLeafSet.clear();
+  it.Reset();
+  while((constituent = static_cast<Candidate *>(it.Next())))
+  {
+    end = constituent->fLeafEnd;
+    for(i = constituent->fLeafBegin; i < end; ++i)
+    {
+      leaf = fLeaves[i];
+      if(fLeafSet.insert(leaf).second) fLeaves.push_back(leaf);
+    }
+  }
+
+  candidate->fLeafBegin = begin;
+  candidate->fLeafEnd = fLeaves.size();
+}
+
+//------------------------------------------------------------------------------
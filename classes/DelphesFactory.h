@@ -24,6 +24,10 @@
  *  Class handling creation of Candidate,
  *  TObjArray and all other objects.
  *
+ *  Objects are allocated from pools of the calling thread, so the modules
+ *  of an event can create objects concurrently. The leaves are shared by
+ *  the event, only modules that are not concurrent use them.
+ *
  *  \author P. Demin - UCL, Louvain-la-Neuve
  *
  */
@@ -32,6 +36,13 @@
 
 #include <map>
 #include <set>
+#include <vector>
+#include <unordered_set>
+
+#if !defined(__CINT__) && !defined(__CLING__)
+#include <mutex>
+#include <thread>
+#endif
 
 class TObjArray;
 class Candidate;
@@ -45,6 +56,7 @@ public:
   DelphesFactory(const char *name = "ObjectFactory");
   ~DelphesFactory();
 
+  // clears the objects of all threads, called between events
   virtual void Clear(Option_t* option = "");
  
   TObjArray *NewPermanentArray();
@@ -58,15 +70,31 @@ public:
   template<typename T>
   T *New() { return static_cast<T *>(New(T::Class())); }
 
+  // stores the leaves of a candidate tree in the pool of the event
+  void FillLeaves(Candidate *candidate);
+
+  Candidate *GetLeaf(Int_t i) const { return fLeaves[i]; }
+
 private:
 
   ExRootTreeBranch *fObjArrays; //!
 
 #if !defined(__CINT__) && !defined(__CLING__)
-  std::map< const TClass*, ExRootTreeBranch* > fBranches; //!
+  typedef std::map< const TClass*, ExRootTreeBranch* > TBranchMap;
+
+  TBranchMap *GetBranches();
+
+  std::map< std::thread::id, TBranchMap > fBranches; //!
+
+  std::mutex fMutex; //!
+
+  Long64_t fId; //!
 #endif
 
   std::set< TObject* > fPool; //!
+
+  std::vector< Candidate* > fLeaves; //!
+  std::unordered_set< Candidate* > fLeafSet; //!
   
   ClassDef(DelphesFactory, 1)
 };
@@ -28,14 +28,14 @@ using namespace std;
 //------------------------------------------------------------------------------
 
 DelphesFormula::DelphesFormula() :
-  TFormula()
+  TFormula(), fPending(kFALSE)
 {
 }
 
 //------------------------------------------------------------------------------
 
 DelphesFormula::DelphesFormula(const char *name, const char *expression) :
-  TFormula()
+  TFormula(), fPending(kFALSE)
 {
 }
 
@@ -48,6 +48,23 @@ DelphesFormula::~DelphesFormula()
 //------------------------------------------------------------------------------
 
 Int_t DelphesFormula::Compile(const char *expression)
+{
+  Prepare(expression);
+  CompileExpression();
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesFormula::CompileLater(const char *expression)
+{
+  Prepare(expression);
+  fPending = kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesFormula::Prepare(const char *expression)
 {
   TString buffer;
   const char *it;
@@ -61,17 +78,23 @@ Int_t DelphesFormula::Compile(const char *expression)
   buffer.ReplaceAll("phi", "z");
   buffer.ReplaceAll("energy", "t");
 
+  fExpression = buffer;
+  fPending = kFALSE;
+}
 
+//------------------------------------------------------------------------------
 
+void DelphesFormula::CompileExpression()
+{
   #if ROOT_VERSION_CODE < ROOT_VERSION(6,0,0)
     TFormula::SetMaxima(100000,1000,1000000);
   #endif
   
-  if(TFormula::Compile(buffer) != 0)
+  if(TFormula::Compile(fExpression) != 0)
   {
     throw runtime_error("Invalid formula.");
   }
-  return 0;
+  fPending = kFALSE;
 }
 
 //------------------------------------------------------------------------------
@@ -79,7 +102,15 @@ Int_t DelphesFormula::Compile(const char *expression)
 Double_t DelphesFormula::Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy)
 {
    Double_t x[4] = {pt, eta, phi, energy};
+   if(fPending) CompileExpression();
    return EvalPar(x);
 }
 
 //------------------------------------------------------------------------------
+
+Bool_t DelphesFormula::IsConstant() const
+{
+  return GetNdim() == 0 && GetNpar() == 0;
+}
+
+//------------------------------------------------------------------------------
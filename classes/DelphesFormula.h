@@ -20,6 +20,7 @@
 #define DelphesFormula_h
 
 #include "TFormula.h"
+#include "TString.h"
 
 class DelphesFormula: public TFormula
 {
@@ -33,7 +34,30 @@ public:
 
   Int_t Compile(const char *expression);
 
+  // prepares the expression but compiles it only at the first evaluation,
+  // for formulas that are mostly replaced by tables read from a snapshot
+  void CompileLater(const char *expression);
+
+  // compiles an expression left by CompileLater now
+  void CompilePending() { if(fPending) CompileExpression(); }
+
   Double_t Eval(Double_t pt, Double_t eta = 0, Double_t phi = 0, Double_t energy = 0);
+
+  // true if the formula depends neither on the kinematics nor on parameters,
+  // only valid after Compile
+  Bool_t IsConstant() const;
+
+  // compiled expression, with pt, eta, phi and energy renamed x, y, z and t
+  const TString &GetExpression() const { return fExpression; }
+
+private:
+
+  void Prepare(const char *expression);
+  void CompileExpression();
+
+  TString fExpression;
+
+  Bool_t fPending;
 };
 
 #endif /* DelphesFormula_h */
@@ -55,7 +55,7 @@ static const int kBufferSize = 16384;
 //---------------------------------------------------------------------------
 
 DelphesHepMCReader::DelphesHepMCReader() :
-  fInputFile(0), fBuffer(0), fPDG(0),
+  fInputFile(0), fPosition(0), fEnd(-1), fBuffer(0), fPDG(0),
   fVertexCounter(-1), fInCounter(-1), fOutCounter(-1),
   fParticleCounter(0)
 {
@@ -76,6 +76,28 @@ DelphesHepMCReader::~DelphesHepMCReader()
 void DelphesHepMCReader::SetInputFile(FILE *inputFile)
 {
   fInputFile = inputFile;
+  fPosition = 0;
+  fEnd = -1;
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesHepMCReader::SetInputRange(long long begin, long long end)
+{
+  fPosition = 0;
+  fEnd = end;
+
+  if(begin <= 0)
+  {
+    fseeko(fInputFile, 0, SEEK_SET);
+    return;
+  }
+
+  // the line starting exactly at begin belongs to this range,
+  // the partial line before it to the previous one
+  fseeko(fInputFile, begin - 1, SEEK_SET);
+  fPosition = begin - 1;
+  if(fgets(fBuffer, kBufferSize, fInputFile)) fPosition += strlen(fBuffer);
 }
 
 //---------------------------------------------------------------------------
@@ -116,8 +138,13 @@ bool DelphesHepMCReader::ReadBlock(DelphesFactory *factory,
   int i, rc, state;
   double weight;
 
+  // events are not split between ranges
+  if(fEnd >= 0 && fPosition >= fEnd && fVertexCounter < 0) return kFALSE;
+
   if(!fgets(fBuffer, kBufferSize, fInputFile)) return kFALSE;
 
+  fPosition += strlen(fBuffer);
+
   DelphesStream bufferStream(fBuffer + 1);
 
   key = fBuffer[0];
@@ -47,6 +47,9 @@ public:
 
   void SetInputFile(FILE *inputFile);
 
+  // reads only the events whose first line starts in the byte range [begin, end)
+  void SetInputRange(long long begin, long long end);
+
   void Clear();
   bool EventReady();
 
@@ -71,6 +74,8 @@ private:
 
   FILE *fInputFile;
 
+  long long fPosition, fEnd;
+
   char *fBuffer;
 
   TDatabasePDG *fPDG;
@@ -0,0 +1,520 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class DelphesInputFile
+ *
+ *  Opens the input files of the readers and decompresses
+ *  files compressed with gzip, zstd or xz.
+ *
+ */
+
+#include "classes/DelphesInputFile.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAS_LZMA
+#include <lzma.h>
+#endif
+
+using namespace std;
+
+// size of the stdio buffers and of the compressed input buffers
+static const size_t kBufferSize = 1 << 20;
+
+//------------------------------------------------------------------------------
+
+class DelphesInputDecoder
+{
+public:
+
+  DelphesInputDecoder(FILE *file, const char *prefix, size_t size) :
+    fFile(file), fInput(kBufferSize), fBegin(0), fEnd(size), fPosition(0)
+  {
+    memcpy(&fInput[0], prefix, size);
+  }
+
+  virtual ~DelphesInputDecoder() {}
+
+  virtual bool Init() { return true; }
+
+  // decompresses up to size bytes, returns 0 at the end of the file and -1 on errors
+  virtual long Decode(char *data, size_t size) = 0;
+
+  static long Read(void *cookie, char *data, size_t size);
+  static int Seek(void *cookie, long long *offset, int whence);
+  static int Close(void *cookie);
+
+protected:
+
+  // reads the next block of compressed data when the previous one is used up
+  bool Fill();
+
+  FILE *fFile;
+
+  vector< char > fInput;
+  size_t fBegin, fEnd;
+
+  long long fPosition;
+};
+
+//------------------------------------------------------------------------------
+
+bool DelphesInputDecoder::Fill()
+{
+  if(fBegin < fEnd) return true;
+
+  fBegin = 0;
+  fEnd = fread(&fInput[0], 1, fInput.size(), fFile);
+
+  return fEnd > 0;
+}
+
+//------------------------------------------------------------------------------
+
+long DelphesInputDecoder::Read(void *cookie, char *data, size_t size)
+{
+  DelphesInputDecoder *decoder = static_cast<DelphesInputDecoder *>(cookie);
+  long result = decoder->Decode(data, size);
+
+  if(result > 0) decoder->fPosition += result;
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+
+int DelphesInputDecoder::Seek(void *cookie, long long *offset, int whence)
+{
+  DelphesInputDecoder *decoder = static_cast<DelphesInputDecoder *>(cookie);
+  char buffer[4096];
+  long long target;
+  long result;
+
+  if(whence == SEEK_SET) target = *offset;
+  else if(whence == SEEK_CUR) target = decoder->fPosition + *offset;
+  else target = -1;
+
+  // compressed streams can only be skipped forward
+  if(target < decoder->fPosition)
+  {
+    errno = ESPIPE;
+    return -1;
+  }
+
+  while(decoder->fPosition < target)
+  {
+    result = Read(cookie, buffer, min(target - decoder->fPosition, (long long)sizeof(buffer)));
+    if(result <= 0) break;
+  }
+
+  *offset = decoder->fPosition;
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+int DelphesInputDecoder::Close(void * /* cookie */)
+{
+  // the decoder and the compressed file are deleted by DelphesInputFile
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+
+class DelphesPlainDecoder : public DelphesInputDecoder
+{
+public:
+
+  DelphesPlainDecoder(FILE *file, const char *prefix, size_t size) :
+    DelphesInputDecoder(file, prefix, size) {}
+
+  long Decode(char *data, size_t size)
+  {
+    if(fBegin == fEnd) return fread(data, 1, size, fFile);
+
+    size = min(size, fEnd - fBegin);
+    memcpy(data, &fInput[fBegin], size);
+    fBegin += size;
+
+    return size;
+  }
+};
+
+//------------------------------------------------------------------------------
+
+class DelphesGzipDecoder : public DelphesInputDecoder
+{
+public:
+
+  DelphesGzipDecoder(FILE *file, const char *prefix, size_t size) :
+    DelphesInputDecoder(file, prefix, size), fValid(false)
+  {
+    memset(&fStream, 0, sizeof(fStream));
+  }
+
+  ~DelphesGzipDecoder()
+  {
+    if(fValid) inflateEnd(&fStream);
+  }
+
+  bool Init()
+  {
+    // 15 + 32 accepts gzip and zlib headers
+    fValid = (inflateInit2(&fStream, 15 + 32) == Z_OK);
+    return fValid;
+  }
+
+  long Decode(char *data, size_t size)
+  {
+    int rc;
+
+    fStream.next_out = reinterpret_cast<Bytef *>(data);
+    fStream.avail_out = size;
+
+    while(fStream.avail_out > 0)
+    {
+      if(!Fill()) break;
+
+      fStream.next_in = reinterpret_cast<Bytef *>(&fInput[fBegin]);
+      fStream.avail_in = fEnd - fBegin;
+
+      rc = inflate(&fStream, Z_NO_FLUSH);
+
+      fBegin = fEnd - fStream.avail_in;
+
+      // files written by several gzip calls contain several members
+      if(rc == Z_STREAM_END) inflateReset(&fStream);
+      else if(rc != Z_OK && rc != Z_BUF_ERROR) return -1;
+    }
+
+    return size - fStream.avail_out;
+  }
+
+private:
+
+  z_stream fStream;
+  bool fValid;
+};
+
+//------------------------------------------------------------------------------
+
+#ifdef HAS_ZSTD
+
+class DelphesZstdDecoder : public DelphesInputDecoder
+{
+public:
+
+  DelphesZstdDecoder(FILE *file, const char *prefix, size_t size) :
+    DelphesInputDecoder(file, prefix, size), fStream(0) {}
+
+  ~DelphesZstdDecoder()
+  {
+    if(fStream) ZSTD_freeDStream(fStream);
+  }
+
+  bool Init()
+  {
+    fStream = ZSTD_createDStream();
+    return fStream && !ZSTD_isError(ZSTD_initDStream(fStream));
+  }
+
+  long Decode(char *data, size_t size)
+  {
+    ZSTD_outBuffer output = {data, size, 0};
+    ZSTD_inBuffer input;
+    size_t rc;
+
+    while(output.pos < output.size)
+    {
+      if(!Fill()) break;
+
+      input.src = &fInput[fBegin];
+      input.size = fEnd - fBegin;
+      input.pos = 0;
+
+      rc = ZSTD_decompressStream(fStream, &output, &input);
+
+      fBegin += input.pos;
+
+      if(ZSTD_isError(rc)) return -1;
+    }
+
+    return output.pos;
+  }
+
+private:
+
+  ZSTD_DStream *fStream;
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef HAS_LZMA
+
+class DelphesXzDecoder : public DelphesInputDecoder
+{
+public:
+
+  DelphesXzDecoder(FILE *file, const char *prefix, size_t size) :
+    DelphesInputDecoder(file, prefix, size), fValid(false), fFinished(false)
+  {
+    lzma_stream stream = LZMA_STREAM_INIT;
+    fStream = stream;
+  }
+
+  ~DelphesXzDecoder()
+  {
+    if(fValid) lzma_end(&fStream);
+  }
+
+  bool Init()
+  {
+#if LZMA_VERSION >= 50040002
+    // blocks of files written with xz -T are decompressed in parallel
+    lzma_mt options;
+    memset(&options, 0, sizeof(options));
+    options.flags = LZMA_CONCATENATED;
+    options.threads = lzma_cputhreads();
+    if(options.threads == 0) options.threads = 1;
+    options.memlimit_threading = lzma_physmem()/4;
+    options.memlimit_stop = UINT64_MAX;
+    fValid = (lzma_stream_decoder_mt(&fStream, &options) == LZMA_OK);
+#else
+    fValid = (lzma_stream_decoder(&fStream, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK);
+#endif
+    return fValid;
+  }
+
+  long Decode(char *data, size_t size)
+  {
+    lzma_action action;
+    lzma_ret rc;
+
+    fStream.next_out = reinterpret_cast<uint8_t *>(data);
+    fStream.avail_out = size;
+
+    while(fStream.avail_out > 0 && !fFinished)
+    {
+      action = Fill() ? LZMA_RUN : LZMA_FINISH;
+
+      fStream.next_in = reinterpret_cast<uint8_t *>(&fInput[fBegin]);
+      fStream.avail_in = fEnd - fBegin;
+
+      rc = lzma_code(&fStream, action);
+
+      fBegin = fEnd - fStream.avail_in;
+
+      if(rc == LZMA_STREAM_END) fFinished = true;
+      else if(rc != LZMA_OK) return -1;
+    }
+
+    return size - fStream.avail_out;
+  }
+
+private:
+
+  lzma_stream fStream;
+  bool fValid, fFinished;
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef __APPLE__
+
+static int ReadCookie(void *cookie, char *data, int size)
+{
+  return DelphesInputDecoder::Read(cookie, data, size);
+}
+
+static fpos_t SeekCookie(void *cookie, fpos_t offset, int whence)
+{
+  long long position = offset;
+  if(DelphesInputDecoder::Seek(cookie, &position, whence) != 0) return -1;
+  return position;
+}
+
+#else
+
+static ssize_t ReadCookie(void *cookie, char *data, size_t size)
+{
+  return DelphesInputDecoder::Read(cookie, data, size);
+}
+
+static int SeekCookie(void *cookie, off64_t *offset, int whence)
+{
+  long long position = *offset;
+  if(DelphesInputDecoder::Seek(cookie, &position, whence) != 0) return -1;
+  *offset = position;
+  return 0;
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+
+DelphesInputFile::DelphesInputFile() :
+  fFile(0), fRawFile(0), fLength(-1), fDecoder(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesInputFile::~DelphesInputFile()
+{
+  Close();
+}
+
+//------------------------------------------------------------------------------
+
+FILE *DelphesInputFile::Open(const char *name)
+{
+  struct stat info;
+  unsigned char magic[6];
+  size_t size, prefix;
+
+  Close();
+
+  if(!name || strcmp(name, "-") == 0)
+  {
+    fRawFile = stdin;
+  }
+  else
+  {
+    fRawFile = fopen(name, "rb");
+    if(!fRawFile) return 0;
+
+    if(fstat(fileno(fRawFile), &info) == 0 && S_ISREG(info.st_mode))
+    {
+      fLength = info.st_size;
+    }
+  }
+
+  setvbuf(fRawFile, 0, _IOFBF, kBufferSize);
+
+  size = fread(magic, 1, sizeof(magic), fRawFile);
+
+  // regular files are read again from the beginning,
+  // the first bytes of pipes are passed to the decoder
+  prefix = size;
+  if(fLength >= 0)
+  {
+    fseeko(fRawFile, 0, SEEK_SET);
+    prefix = 0;
+  }
+
+  if(size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+  {
+    fDecoder = new DelphesGzipDecoder(fRawFile, (char *)magic, prefix);
+  }
+  else if(size >= 4 && memcmp(magic, "\x28\xb5\x2f\xfd", 4) == 0)
+  {
+#ifdef HAS_ZSTD
+    fDecoder = new DelphesZstdDecoder(fRawFile, (char *)magic, prefix);
+#else
+    cerr << "** ERROR: " << (name ? name : "standard input") << " is compressed with zstd, ";
+    cerr << "Delphes was built without zstd" << endl;
+    Close();
+    return 0;
+#endif
+  }
+  else if(size >= 6 && memcmp(magic, "\xfd" "7zXZ\0", 6) == 0)
+  {
+#ifdef HAS_LZMA
+    fDecoder = new DelphesXzDecoder(fRawFile, (char *)magic, prefix);
+#else
+    cerr << "** ERROR: " << (name ? name : "standard input") << " is compressed with xz, ";
+    cerr << "Delphes was built without liblzma" << endl;
+    Close();
+    return 0;
+#endif
+  }
+  else if(fLength < 0)
+  {
+    fDecoder = new DelphesPlainDecoder(fRawFile, (char *)magic, prefix);
+  }
+
+  if(!fDecoder)
+  {
+    fFile = fRawFile;
+    return fFile;
+  }
+
+  if(!fDecoder->Init())
+  {
+    Close();
+    return 0;
+  }
+
+#ifdef __APPLE__
+  fFile = funopen(fDecoder, ReadCookie, 0, SeekCookie, DelphesInputDecoder::Close);
+#else
+  cookie_io_functions_t functions = {ReadCookie, 0, SeekCookie, DelphesInputDecoder::Close};
+  fFile = fopencookie(fDecoder, "r", functions);
+#endif
+
+  if(!fFile)
+  {
+    Close();
+    return 0;
+  }
+
+  setvbuf(fFile, 0, _IOFBF, kBufferSize);
+
+  return fFile;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesInputFile::Close()
+{
+  if(fFile && fFile != fRawFile) fclose(fFile);
+  if(fDecoder) delete fDecoder;
+  if(fRawFile && fRawFile != stdin) fclose(fRawFile);
+
+  fFile = 0;
+  fRawFile = 0;
+  fLength = -1;
+  fDecoder = 0;
+}
+
+//------------------------------------------------------------------------------
+
+long long DelphesInputFile::GetPosition() const
+{
+  return fRawFile ? ftello(fRawFile) : -1;
+}
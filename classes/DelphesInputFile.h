@@ -0,0 +1,64 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesInputFile_h
+#define DelphesInputFile_h
+
+/** \class DelphesInputFile
+ *
+ *  Opens the input files of the readers. Files compressed with gzip,
+ *  zstd or xz are recognised by their magic bytes and decompressed while
+ *  they are read, the readers get a FILE stream with the decompressed data.
+ *
+ */
+
+#include <stdio.h>
+
+class DelphesInputDecoder;
+
+class DelphesInputFile
+{
+public:
+
+  DelphesInputFile();
+  ~DelphesInputFile();
+
+  // opens a file, or the standard input if name is 0 or "-",
+  // returns 0 if the file can't be opened or its compression isn't supported
+  FILE *Open(const char *name);
+
+  void Close();
+
+  // plain regular files can be seeked, compressed files and pipes only read
+  bool IsSeekable() const { return fFile && fFile == fRawFile && fLength >= 0; }
+
+  // size of the file and bytes read from it so far, before decompression,
+  // -1 if the size isn't known
+  long long GetLength() const { return fLength; }
+  long long GetPosition() const;
+
+private:
+
+  FILE *fFile, *fRawFile;
+
+  long long fLength;
+
+  DelphesInputDecoder *fDecoder;
+};
+
+#endif // DelphesInputFile_h
@@ -32,6 +32,8 @@
 #include <sstream>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "TObjArray.h"
 #include "TStopwatch.h"
@@ -51,9 +53,45 @@ static const int kBufferSize = 16384;
 
 //---------------------------------------------------------------------------
 
+// returns the quoted value of the attribute 'name' of the tag starting at 'tag'
+// and sets 'end' to its closing quote, or returns 0 if the tag has no such attribute
+
+static char *FindAttribute(char *tag, const char *name, char **end)
+{
+  char *pch, *value;
+  size_t size = strlen(name);
+
+  for(pch = strpbrk(tag, " \t"); pch && *pch != '>' && *pch != '\0'; ++pch)
+  {
+    // values of the other attributes are skipped
+    if(*pch == '"' || *pch == '\'')
+    {
+      pch = strchr(pch + 1, *pch);
+      if(!pch) return 0;
+      continue;
+    }
+
+    if((pch[-1] != ' ' && pch[-1] != '\t') || strncmp(pch, name, size) != 0) continue;
+
+    value = pch + size;
+    while(*value == ' ' || *value == '\t') ++value;
+    if(*value != '=') continue;
+    ++value;
+    while(*value == ' ' || *value == '\t') ++value;
+    if(*value != '"' && *value != '\'') continue;
+
+    *end = strchr(value + 1, *value);
+    return *end ? value + 1 : 0;
+  }
+
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+
 DelphesLHEFReader::DelphesLHEFReader() :
-  fInputFile(0), fBuffer(0), fPDG(0),
-  fEventReady(kFALSE), fEventCounter(-1), fParticleCounter(-1),   fCrossSection(1)
+  fInputFile(0), fPosition(0), fEnd(-1), fBuffer(0), fPDG(0),
+  fEventReady(kFALSE), fCrossSection(1), fSkipWeights(false), fNextWeight(0)
 
 {
   fBuffer = new char[kBufferSize];
@@ -73,6 +111,47 @@ DelphesLHEFReader::~DelphesLHEFReader()
 void DelphesLHEFReader::SetInputFile(FILE *inputFile)
 {
   fInputFile = inputFile;
+  fPosition = 0;
+  fEnd = -1;
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesLHEFReader::SetInputRange(long long begin, long long end)
+{
+  fPosition = 0;
+  fEnd = end;
+
+  fseeko(fInputFile, 0, SEEK_SET);
+
+  if(begin <= 0) return;
+
+  // the cross section and the weight names are only given in the header of the file
+  while(ReadLine())
+  {
+    if(strstr(fBuffer, "<event>") || fPosition >= begin) break;
+    ReadHeader();
+  }
+
+  // the line starting exactly at begin belongs to this range,
+  // the partial line before it to the previous one
+  fseeko(fInputFile, begin - 1, SEEK_SET);
+  fPosition = begin - 1;
+  ReadLine();
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesLHEFReader::SelectWeight(const char *id)
+{
+  fWeightSelection.insert(id);
+}
+
+//---------------------------------------------------------------------------
+
+void DelphesLHEFReader::SkipWeights()
+{
+  fSkipWeights = true;
 }
 
 //---------------------------------------------------------------------------
@@ -80,9 +159,8 @@ void DelphesLHEFReader::SetInputFile(FILE *inputFile)
 void DelphesLHEFReader::Clear()
 {
   fEventReady = kFALSE;
-  fEventCounter = -1;
-  fParticleCounter = -1;
-  fWeightList.clear();
+  fWeightSlots.clear();
+  fNextWeight = 0;
 }
 
 //---------------------------------------------------------------------------
@@ -99,51 +177,53 @@ bool DelphesLHEFReader::ReadBlock(DelphesFactory *factory,
   TObjArray *stableParticleOutputArray,
   TObjArray *partonOutputArray)
 {
-  int rc, id;
+  int rc, i, particles;
   char *pch;
-  double weight, xsec;
 
-  if(!fgets(fBuffer, kBufferSize, fInputFile)) return kFALSE;
+  // events are not split between ranges
+  if(fEnd >= 0 && fPosition >= fEnd) return kFALSE;
 
-  if(strstr(fBuffer, "<event>"))
-  {
-    Clear();
-    fEventCounter = 1;
-  }
-  else if(fEventCounter > 0)
-  {
-    DelphesStream bufferStream(fBuffer);
+  if(!ReadLine()) return kFALSE;
 
-    rc = bufferStream.ReadInt(fParticleCounter)
-      && bufferStream.ReadInt(fProcessID)
-      && bufferStream.ReadDbl(fWeight)
-      && bufferStream.ReadDbl(fScalePDF)
-      && bufferStream.ReadDbl(fAlphaQED)
-      && bufferStream.ReadDbl(fAlphaQCD);
+  if(!strstr(fBuffer, "<event>")) return ReadHeader();
 
-    if(!rc)
-    {
-      cerr << "** ERROR: " << "invalid event format" << endl;
-      return kFALSE;
-    }
+  // the whole event block is read at once
+  Clear();
 
-    --fEventCounter;
+  if(!ReadLine()) return kFALSE;
+
+  DelphesStream eventStream(fBuffer);
+
+  rc = eventStream.ReadInt(particles)
+    && eventStream.ReadInt(fProcessID)
+    && eventStream.ReadDbl(fWeight)
+    && eventStream.ReadDbl(fScalePDF)
+    && eventStream.ReadDbl(fAlphaQED)
+    && eventStream.ReadDbl(fAlphaQCD);
+
+  if(!rc)
+  {
+    cerr << "** ERROR: " << "invalid event format" << endl;
+    return kFALSE;
   }
-  else if(fParticleCounter > 0)
+
+  for(i = 0; i < particles; ++i)
   {
-    DelphesStream bufferStream(fBuffer);
-
-    rc = bufferStream.ReadInt(fPID)
-      && bufferStream.ReadInt(fStatus)
-      && bufferStream.ReadInt(fM1)
-      && bufferStream.ReadInt(fM2)
-      && bufferStream.ReadInt(fC1)
-      && bufferStream.ReadInt(fC2)
-      && bufferStream.ReadDbl(fPx)
-      && bufferStream.ReadDbl(fPy)
-      && bufferStream.ReadDbl(fPz)
-      && bufferStream.ReadDbl(fE)
-      && bufferStream.ReadDbl(fMass);
+    if(!ReadLine()) return kFALSE;
+
+    DelphesStream particleStream(fBuffer);
+
+    rc = particleStream.ReadInt(fPID)
+      && particleStream.ReadInt(fStatus)
+      && particleStream.ReadInt(fM1)
+      && particleStream.ReadInt(fM2)
+      && particleStream.ReadInt(fC1)
+      && particleStream.ReadInt(fC2)
+      && particleStream.ReadDbl(fPx)
+      && particleStream.ReadDbl(fPy)
+      && particleStream.ReadDbl(fPz)
+      && particleStream.ReadDbl(fE)
+      && particleStream.ReadDbl(fMass);
 
     if(!rc)
     {
@@ -153,71 +233,183 @@ bool DelphesLHEFReader::ReadBlock(DelphesFactory *factory,
 
     AnalyzeParticle(factory, allParticleOutputArray,
       stableParticleOutputArray, partonOutputArray);
-
-    --fParticleCounter;
   }
-  else if(strstr(fBuffer, "<wgt"))
+
+  // optional tags up to the end of the event, only weights are read
+  while(ReadLine())
   {
-    pch = strpbrk(fBuffer, "\"'");
-    if(!pch)
+    pch = fBuffer + strspn(fBuffer, " \t");
+    if(*pch != '<') continue;
+
+    if(strncmp(pch, "<wgt", 4) == 0)
     {
-      cerr << "** ERROR: " << "invalid weight format" << endl;
-      return kFALSE;
+      if(!ReadWeight(pch)) return kFALSE;
     }
+    else if(strstr(pch, "</event>"))
+    {
+      fEventReady = kTRUE;
+      return kTRUE;
+    }
+  }
+
+  return kFALSE;
+}
+
+//---------------------------------------------------------------------------
 
-    DelphesStream idStream(pch + 1);
-    rc = idStream.ReadInt(id);
+bool DelphesLHEFReader::ReadLine()
+{
+  if(!fgets(fBuffer, kBufferSize, fInputFile)) return kFALSE;
+
+  fPosition += strlen(fBuffer);
+
+  return kTRUE;
+}
+
+//---------------------------------------------------------------------------
 
-    pch = strchr(fBuffer, '>');
+bool DelphesLHEFReader::ReadHeader()
+{
+  char *pch, *end;
+
+  if(strstr(fBuffer, "<xsecinfo"))
+  {
+    return ReadCrossSection();
+  }
+
+  // weight names of the <initrwgt> block, <weightgroup> is skipped
+  pch = strstr(fBuffer, "<weight");
+  if(pch && (pch[7] == ' ' || pch[7] == '\t'))
+  {
+    pch = FindAttribute(pch, "id", &end);
     if(!pch)
     {
       cerr << "** ERROR: " << "invalid weight format" << endl;
       return kFALSE;
     }
 
-    DelphesStream weightStream(pch + 1);
-    rc = weightStream.ReadDbl(weight);
+    GetWeightIndex(pch, end - pch);
+  }
 
-    if(!rc)
-    {
-      cerr << "** ERROR: " << "invalid weight format" << endl;
-      return kFALSE;
-    }
+  return kTRUE;
+}
+
+//---------------------------------------------------------------------------
+
+bool DelphesLHEFReader::ReadWeight(char *line)
+{
+  char *pch, *end;
+  int index;
+  double weight;
 
-    fWeightList.push_back(make_pair(id, weight));
+  pch = FindAttribute(line, "id", &end);
+  if(!pch)
+  {
+    cerr << "** ERROR: " << "invalid weight format" << endl;
+    return kFALSE;
   }
-  else if(strstr(fBuffer, "<xsecinfo"))
+
+  index = GetWeightIndex(pch, end - pch);
+
+  if(!fWeightSelected[index]) return kTRUE;
+
+  pch = strchr(end, '>');
+  if(!pch)
   {
-    pch = strstr(fBuffer, "totxsec");
-    if(!pch)
-    {
-      cerr << "** ERROR: " << "invalid cross section format" << endl;
-      return kFALSE;
-    }
+    cerr << "** ERROR: " << "invalid weight format" << endl;
+    return kFALSE;
+  }
 
-    pch = strpbrk(pch + 1, "\"'");
-    if(!pch)
-    {
-      cerr << "** ERROR: " << "invalid cross section format" << endl;
-      return kFALSE;
-    }
+  DelphesStream weightStream(pch + 1);
 
-    DelphesStream xsecStream(pch + 1);
-    rc = xsecStream.ReadDbl(xsec);
+  if(!weightStream.ReadDbl(weight))
+  {
+    cerr << "** ERROR: " << "invalid weight format" << endl;
+    return kFALSE;
+  }
 
-    if(!rc)
-    {
-      cerr << "** ERROR: " << "invalid cross section format" << endl;
-      return kFALSE;
-    }
+  fWeightValues[index] = weight;
+  fWeightSlots.push_back(index);
+
+  return kTRUE;
+}
+
+//---------------------------------------------------------------------------
+
+int DelphesLHEFReader::GetWeightIndex(const char *id, size_t size)
+{
+  map< string, int >::iterator itWeightMap;
+  string name;
+  char *end;
+  int index, number;
+
+  // the weights of an event are usually listed in the order of the header
+  if(fNextWeight < int(fWeightNames.size()) && fWeightNames[fNextWeight].size() == size
+    && memcmp(fWeightNames[fNextWeight].data(), id, size) == 0)
+  {
+    return fNextWeight++;
+  }
+
+  name.assign(id, size);
+
+  itWeightMap = fWeightMap.find(name);
+  if(itWeightMap != fWeightMap.end())
+  {
+    index = itWeightMap->second;
+  }
+  else
+  {
+    index = fWeightNames.size();
+
+    // IDs that are not numbers are replaced by their position in the table
+    number = strtol(name.c_str(), &end, 10);
+    if(name.empty() || *end != '\0') number = index;
 
-    fCrossSection = xsec;
+    fWeightNames.push_back(name);
+    fWeightMap[name] = index;
+    fWeightNumbers.push_back(number);
+    fWeightSelected.push_back(!fSkipWeights && (fWeightSelection.empty() || fWeightSelection.count(name) > 0));
+    fWeightValues.push_back(0.0);
   }
-  else if(strstr(fBuffer, "</event>"))
+
+  fNextWeight = index + 1;
+
+  return index;
+}
+
+//---------------------------------------------------------------------------
+
+bool DelphesLHEFReader::ReadCrossSection()
+{
+  int rc;
+  char *pch;
+  double xsec;
+
+  pch = strstr(fBuffer, "totxsec");
+  if(!pch)
   {
-    fEventReady = kTRUE;
+    cerr << "** ERROR: " << "invalid cross section format" << endl;
+    return kFALSE;
   }
 
+  pch = strpbrk(pch + 1, "\"'");
+  if(!pch)
+  {
+    cerr << "** ERROR: " << "invalid cross section format" << endl;
+    return kFALSE;
+  }
+
+  DelphesStream xsecStream(pch + 1);
+  rc = xsecStream.ReadDbl(xsec);
+
+  if(!rc)
+  {
+    cerr << "** ERROR: " << "invalid cross section format" << endl;
+    return kFALSE;
+  }
+
+  fCrossSection = xsec;
+
   return kTRUE;
 }
 
@@ -248,14 +440,14 @@ void DelphesLHEFReader::AnalyzeEvent(ExRootTreeBranch *branch, long long eventNu
 void DelphesLHEFReader::AnalyzeWeight(ExRootTreeBranch *branch)
 {
   LHEFWeight *element;
-  vector< pair< int, double > >::const_iterator itWeightList;
+  vector< int >::const_iterator itWeightSlots;
 
-  for(itWeightList = fWeightList.begin(); itWeightList != fWeightList.end(); ++itWeightList)
+  for(itWeightSlots = fWeightSlots.begin(); itWeightSlots != fWeightSlots.end(); ++itWeightSlots)
   {
     element = static_cast<LHEFWeight *>(branch->NewEntry());
 
-    element->ID = itWeightList->first;
-    element->Weight = itWeightList->second;
+    element->ID = fWeightNumbers[*itWeightSlots];
+    element->Weight = fWeightValues[*itWeightSlots];
   }
 }
 
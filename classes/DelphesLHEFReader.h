@@ -29,8 +29,10 @@
 
 #include <stdio.h>
 
+#include <map>
+#include <set>
+#include <string>
 #include <vector>
-#include <utility>
 
 class TObjArray;
 class TStopwatch;
@@ -47,6 +49,13 @@ public:
 
   void SetInputFile(FILE *inputFile);
 
+  // reads only the events whose <event> line starts in the byte range [begin, end)
+  void SetInputRange(long long begin, long long end);
+
+  // weights with the selected IDs are read, all weights without selection
+  void SelectWeight(const char *id);
+  void SkipWeights();
+
   void Clear();
   bool EventReady();
 
@@ -62,6 +71,14 @@ public:
 
 private:
 
+  bool ReadLine();
+  bool ReadHeader();
+  bool ReadWeight(char *line);
+  bool ReadCrossSection();
+
+  // index of a weight ID in the weight table, new IDs are added to the table
+  int GetWeightIndex(const char *id, size_t size);
+
   void AnalyzeParticle(DelphesFactory *factory,
     TObjArray *allParticleOutputArray,
     TObjArray *stableParticleOutputArray,
@@ -69,21 +86,33 @@ private:
 
   FILE *fInputFile;
 
+  long long fPosition, fEnd;
+
   char *fBuffer;
 
   TDatabasePDG *fPDG;
 
   bool fEventReady;
 
-  int fEventCounter;
-
-  int fParticleCounter, fProcessID;
+  int fProcessID;
   double fCrossSection, fWeight, fScalePDF, fAlphaQCD, fAlphaQED;
 
   int fPID, fStatus, fM1, fM2, fC1, fC2;
   double fPx, fPy, fPz, fE, fMass;
-  
-  std::vector< std::pair< int, double > > fWeightList;
+
+  std::set< std::string > fWeightSelection;
+  bool fSkipWeights;
+
+  // weight table filled from the <initrwgt> header, indexed by position
+  std::vector< std::string > fWeightNames;
+  std::map< std::string, int > fWeightMap;
+  std::vector< int > fWeightNumbers;
+  std::vector< bool > fWeightSelected;
+  std::vector< double > fWeightValues;
+
+  // positions of the weights of the current event
+  std::vector< int > fWeightSlots;
+  int fNextWeight;
 };
 
 #endif // DelphesLHEFReader_h
@@ -46,8 +46,8 @@
 using namespace std;
 
 DelphesModule::DelphesModule() :
-  fTreeWriter(0), fFactory(0), fPlots(0),
-  fPlotFolder(0), fExportFolder(0)
+  fTreeWriter(0), fFactory(0), fSnapshot(0), fPlots(0),
+  fPlotFolder(0), fImportFolder(0), fExportFolder(0)
 {
 }
 
@@ -77,6 +77,12 @@ void DelphesModule::Finish()
 
 //------------------------------------------------------------------------------
 
+void DelphesModule::SaveState(TDirectory *directory)
+{
+}
+
+//------------------------------------------------------------------------------
+
 TObjArray *DelphesModule::ImportArray(const char *name)
 {
   stringstream message;
@@ -90,6 +96,13 @@ TObjArray *DelphesModule::ImportArray(const char *name)
     throw runtime_error(message.str());
   }
 
+  if(!fImportFolder)
+  {
+    fImportFolder = NewFolder("Import");
+  }
+
+  fImportFolder->Add(object);
+
   return object;
 }
 
@@ -114,6 +127,13 @@ TObjArray *DelphesModule::ExportArray(const char *name)
 //------------------------------------------------------------------------------
 
 ExRootTreeBranch *DelphesModule::NewBranch(const char *name, TClass *cl)
+{
+  return GetTreeWriter()->NewBranch(name, cl);
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeWriter *DelphesModule::GetTreeWriter()
 {
   stringstream message;
   if(!fTreeWriter)
@@ -125,7 +145,7 @@ ExRootTreeBranch *DelphesModule::NewBranch(const char *name, TClass *cl)
       throw runtime_error(message.str());
     }
   }
-  return fTreeWriter->NewBranch(name, cl);
+  return fTreeWriter;
 }
 
 //------------------------------------------------------------------------------
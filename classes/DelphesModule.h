@@ -32,12 +32,14 @@
 class TClass;
 class TObject;
 class TFolder;
+class TDirectory;
 class TClonesArray;
 
 class ExRootResult;
 class ExRootTreeBranch;
 class ExRootTreeWriter;
 
+class Candidate;
 class DelphesFactory;
 
 class DelphesModule: public ExRootTask 
@@ -54,21 +56,60 @@ public:
   TObjArray *ImportArray(const char *name);
   TObjArray *ExportArray(const char *name);
 
+  // arrays imported and exported by the module, in the order of the calls,
+  // the folders Import/<module> and Export/<module> hold them for all modules
+  TFolder *GetImportFolder() const { return fImportFolder; }
+  TFolder *GetExportFolder() const { return fExportFolder; }
+
+  // element-wise modules can be fused in a Pipeline, they then process one
+  // candidate at a time between StartEvent and FinishEvent, ProcessCandidate
+  // returns the candidate of the first exported array or 0 if it is dropped
+  virtual Bool_t IsElementWise() const { return kFALSE; }
+  virtual void StartEvent() { }
+  virtual Candidate *ProcessCandidate(Candidate *candidate) { return 0; }
+  virtual void FinishEvent() { }
+
+  // with ::NumberOfThreads > 1, concurrent modules run at the same time as
+  // other modules of the event, the other modules run one at a time.
+  // A module instance is always processed by one thread at a time, so its
+  // members can hold the state of the event. A concurrent module in addition
+  // - creates objects only with the factory,
+  // - modifies only the candidates and arrays it creates,
+  // - doesn't use gRandom, the plots, the tree writer or the leaves of
+  //   candidates (GetNLeaves, GetLeaf, Overlaps)
+  virtual Bool_t IsConcurrent() const { return kFALSE; }
+
+  // modules that set variables of the candidates of their input arrays,
+  // they run after the other modules reading these arrays that come before
+  // them in the card and before those that come after them
+  virtual Bool_t ModifiesInputs() const { return kFALSE; }
+
   ExRootTreeBranch *NewBranch(const char *name, TClass *cl);
 
+  ExRootTreeWriter *GetTreeWriter();
+
   ExRootResult *GetPlots();
   DelphesFactory *GetFactory();
 
+  // writes the state computed by Init to the snapshot of the module chain,
+  // modules read it back in Init from GetSnapshot() (0 without snapshot)
+  virtual void SaveState(TDirectory *directory);
+
+  void SetSnapshot(TDirectory *directory) { fSnapshot = directory; }
+  TDirectory *GetSnapshot() const { return fSnapshot; }
+
 protected:
 
   ExRootTreeWriter *fTreeWriter;
   DelphesFactory *fFactory;
 
+  TDirectory *fSnapshot;
+
 private:
 
   ExRootResult *fPlots;
 
-  TFolder *fPlotFolder, *fExportFolder;
+  TFolder *fPlotFolder, *fImportFolder, *fExportFolder;
 
   ClassDef(DelphesModule, 1)
 };
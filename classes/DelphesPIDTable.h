@@ -0,0 +1,99 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesPIDTable_h
+#define DelphesPIDTable_h
+
+/** \class DelphesPIDTable
+ *
+ *  Lookup table indexed by PDG code, filled when the modules are
+ *  initialised. Codes with |PID| < kDenseSize are found with one indexed
+ *  load, the other codes are kept in a hash table.
+ *
+ */
+
+#include "Rtypes.h"
+
+#include <vector>
+#include <unordered_map>
+
+template< typename T >
+class DelphesPIDTable
+{
+public:
+
+  static const Int_t kDenseSize = 512;
+
+  DelphesPIDTable() : fDense(2*kDenseSize - 1, 0) { }
+
+  void Clear()
+  {
+    fValues.clear();
+    fDense.assign(2*kDenseSize - 1, 0);
+    fSparse.clear();
+  }
+
+  // adds the value of a PDG code or replaces it
+  void Insert(Int_t pid, const T &value)
+  {
+    Int_t &index = (pid > -kDenseSize && pid < kDenseSize) ? fDense[pid + kDenseSize - 1] : fSparse[pid];
+
+    if(index == 0)
+    {
+      fValues.push_back(value);
+      index = fValues.size();
+    }
+    else
+    {
+      fValues[index - 1] = value;
+    }
+  }
+
+  // returns 0 if the PDG code isn't in the table
+  const T *Find(Int_t pid) const
+  {
+    std::unordered_map< Int_t, Int_t >::const_iterator it;
+    Int_t index;
+
+    if(pid > -kDenseSize && pid < kDenseSize)
+    {
+      index = fDense[pid + kDenseSize - 1];
+    }
+    else
+    {
+      it = fSparse.find(pid);
+      index = (it == fSparse.end()) ? 0 : it->second;
+    }
+
+    return index ? &fValues[index - 1] : 0;
+  }
+
+  const T &Get(Int_t pid, const T &value) const
+  {
+    const T *result = Find(pid);
+    return result ? *result : value;
+  }
+
+private:
+
+  std::vector< T > fValues;
+  std::vector< Int_t > fDense;
+  std::unordered_map< Int_t, Int_t > fSparse;
+};
+
+#endif /* DelphesPIDTable_h */
@@ -33,6 +33,8 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "classes/DelphesXDRReader.h"
 
@@ -44,7 +46,7 @@ static const int kRecordSize = 9;
 
 //------------------------------------------------------------------------------
 
-DelphesPileUpReader::DelphesPileUpReader(const char *fileName) :
+DelphesPileUpReader::DelphesPileUpReader(const char *fileName, bool readIndex) :
   fEntries(0), fEntrySize(0), fCounter(0),
   fPileUpFile(0), fIndex(0), fBuffer(0),
   fInputReader(0), fIndexReader(0), fBufferReader(0)
@@ -80,9 +82,7 @@ DelphesPileUpReader::DelphesPileUpReader(const char *fileName) :
     throw runtime_error(message.str());
   }
 
-  // read index of events
-  fseeko(fPileUpFile, -8 - 8*fEntries, SEEK_END);
-  fInputReader->ReadRaw(fIndex, fEntries*8);
+  if(readIndex) ReadIndex();
 }
 
 //------------------------------------------------------------------------------
@@ -99,6 +99,25 @@ DelphesPileUpReader::~DelphesPileUpReader()
 
 //------------------------------------------------------------------------------
 
+void DelphesPileUpReader::ReadIndex()
+{
+  fseeko(fPileUpFile, -8 - 8*fEntries, SEEK_END);
+  fInputReader->ReadRaw(fIndex, fEntries*8);
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesPileUpReader::SetIndex(const uint8_t *index, int64_t size)
+{
+  if(size != 8*fEntries) return false;
+
+  memcpy(fIndex, index, size);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
 bool DelphesPileUpReader::ReadParticle(int32_t &pid,
   float &x, float &y, float &z, float &t,
   float &px, float &py, float &pz, float &e)
@@ -125,6 +144,7 @@ bool DelphesPileUpReader::ReadParticle(int32_t &pid,
 bool DelphesPileUpReader::ReadEntry(int64_t entry)
 {
   int64_t offset;
+  ssize_t size;
 
   if(entry >= fEntries) return false;
 
@@ -132,16 +152,19 @@ bool DelphesPileUpReader::ReadEntry(int64_t entry)
   fIndexReader->SetOffset(8*entry);
   fIndexReader->ReadValue(&offset, 8);
 
-  // read event
-  fseeko(fPileUpFile, offset, SEEK_SET);
-  fInputReader->ReadValue(&fEntrySize, 4);
+  // read event with positional reads, the file offset
+  // is shared with the processes forked after initialisation
+  if(pread(fileno(fPileUpFile), fBuffer, 4, offset) != 4) return false;
+  fBufferReader->SetOffset(0);
+  fBufferReader->ReadValue(&fEntrySize, 4);
 
   if(fEntrySize >= kBufferSize)
   {
     throw runtime_error("too many particles in pile-up event");
   }
 
-  fInputReader->ReadRaw(fBuffer, fEntrySize*kRecordSize*4);
+  size = fEntrySize*kRecordSize*4;
+  if(pread(fileno(fPileUpFile), fBuffer, size, offset + 4) != size) return false;
   fBufferReader->SetOffset(0);
   fCounter = 0;
 
@@ -36,7 +36,9 @@ class DelphesPileUpReader
 {
 public:
 
-  DelphesPileUpReader(const char *fileName);
+  // without readIndex, the index of the events has to be set by ReadIndex
+  // or SetIndex before the events are read
+  DelphesPileUpReader(const char *fileName, bool readIndex = true);
 
   ~DelphesPileUpReader();
 
@@ -48,6 +50,15 @@ public:
 
   int64_t GetEntries() const { return fEntries; }
 
+  void ReadIndex();
+
+  // index of the events, 8 bytes per event
+  const uint8_t *GetIndex() const { return fIndex; }
+  int64_t GetIndexSize() const { return 8*fEntries; }
+
+  // copies an index read before from the same file
+  bool SetIndex(const uint8_t *index, int64_t size);
+
 private:
 
   int64_t fEntries;
@@ -0,0 +1,447 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class DelphesResolutionTable
+ *
+ *  Resolution formulas tabulated in bins of eta.
+ *
+ */
+
+#include "classes/DelphesResolutionTable.h"
+#include "classes/DelphesFormula.h"
+
+#include "TMath.h"
+#include "TString.h"
+#include "TDirectory.h"
+
+#include <algorithm>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+// variables of the compiled expressions: pt, eta, phi and energy
+static const char *kVariables[4] = {"x", "y", "z", "t"};
+
+// functions that keep a formula smooth in their arguments
+static const char *kSmoothFunctions[] = {"sqrt", "pow", "exp", "log", "TMath::Sqrt", "TMath::Power", "TMath::Exp", "TMath::Log"};
+
+// values of the variable where the closed form is checked against the formula
+static const Double_t kCheckValues[] = {0.3, 2.0, 7.0, 25.0, 60.0, 250.0, 1.0e3, 5.0e3, 2.0e4, 1.0e5};
+static const Double_t kTolerance = 1.0e-9;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+
+// uses of the variables and eta thresholds found in an expression
+struct TExpressionInfo
+{
+  Bool_t inComparison[4];
+  Bool_t nonSmooth[4];
+  Bool_t outside[4];
+  Bool_t etaThresholds;
+  vector< Double_t > thresholds;
+};
+
+//------------------------------------------------------------------------------
+
+Bool_t IsNumber(const TString &text, Double_t &value)
+{
+  char *end;
+
+  if(text.Length() == 0) return kFALSE;
+
+  value = strtod(text.Data(), &end);
+
+  return *end == 0;
+}
+
+//------------------------------------------------------------------------------
+
+// end of the operand of a comparison starting at position, going in direction
+Int_t FindOperandEnd(const TString &expression, Int_t position, Int_t direction)
+{
+  Int_t depth = 0;
+  char c;
+
+  for(; position >= 0 && position < expression.Length(); position += direction)
+  {
+    c = expression[position];
+    if(c == '(' || c == '[') depth += direction;
+    else if(c == ')' || c == ']') depth -= direction;
+    if(depth < 0) break;
+    if(depth == 0 && strchr("&|,?:<>=!", c)) break;
+  }
+
+  return position - direction;
+}
+
+//------------------------------------------------------------------------------
+
+void AnalyseExpression(const TString &expression, TExpressionInfo &info)
+{
+  Int_t i, j, k, length = expression.Length(), begin, end, sign, depth;
+  Double_t value;
+  TString left, right, operand, number, name;
+  vector< Bool_t > mask(length, kFALSE), maskNonSmooth(length, kFALSE);
+  Bool_t smooth;
+  char c;
+
+  for(k = 0; k < 4; ++k) info.inComparison[k] = info.nonSmooth[k] = info.outside[k] = kFALSE;
+  info.etaThresholds = kTRUE;
+  info.thresholds.clear();
+
+  // mark the operands of the comparisons and collect the eta thresholds
+  for(i = 0; i < length; ++i)
+  {
+    c = expression[i];
+    if(c != '<' && c != '>' && !((c == '=' || c == '!') && i + 1 < length && expression[i + 1] == '=')) continue;
+
+    j = (i + 1 < length && expression[i + 1] == '=') ? i + 2 : i + 1;
+
+    begin = FindOperandEnd(expression, i - 1, -1);
+    end = FindOperandEnd(expression, j, 1);
+
+    left = expression(begin, i - begin);
+    right = expression(j, end + 1 - j);
+
+    for(k = begin; k <= end; ++k) mask[k] = kTRUE;
+
+    if(!left.Contains("y") && !right.Contains("y")) continue;
+
+    sign = IsNumber(left, value) ? -1 : 1;
+    operand = sign > 0 ? left : right;
+    number = sign > 0 ? right : left;
+
+    if(!IsNumber(number, value))
+    {
+      info.etaThresholds = kFALSE;
+    }
+    else if(operand == "y")
+    {
+      info.thresholds.push_back(value);
+    }
+    else if(operand == "abs(y)" || operand == "fabs(y)" || operand == "TMath::Abs(y)")
+    {
+      info.thresholds.push_back(value);
+      info.thresholds.push_back(-value);
+    }
+    else
+    {
+      info.etaThresholds = kFALSE;
+    }
+
+    i = j - 1;
+  }
+
+  // find the variables, skipping numbers and function names
+  for(i = 0; i < length; ++i)
+  {
+    c = expression[i];
+    if(isdigit(c) || c == '.')
+    {
+      while(i + 1 < length && (isalnum(expression[i + 1]) || expression[i + 1] == '.' ||
+        ((expression[i + 1] == '+' || expression[i + 1] == '-') && (expression[i] == 'e' || expression[i] == 'E')))) ++i;
+      continue;
+    }
+    if(!isalpha(c) && c != '_') continue;
+
+    j = i;
+    while(j + 1 < length && (isalnum(expression[j + 1]) || expression[j + 1] == '_' || expression[j + 1] == ':')) ++j;
+
+    name = expression(i, j + 1 - i);
+
+    if(j + 1 < length && expression[j + 1] == '(')
+    {
+      // arguments of functions like abs, min or floor
+      smooth = kFALSE;
+      for(k = 0; k < Int_t(sizeof(kSmoothFunctions)/sizeof(char *)); ++k)
+      {
+        if(name == kSmoothFunctions[k]) smooth = kTRUE;
+      }
+      depth = 0;
+      for(k = j + 1; !smooth && k < length; ++k)
+      {
+        if(expression[k] == '(') ++depth;
+        else if(expression[k] == ')') --depth;
+        maskNonSmooth[k] = kTRUE;
+        if(depth == 0) break;
+      }
+    }
+    else
+    {
+      for(k = 0; k < 4; ++k)
+      {
+        if(name != kVariables[k]) continue;
+        if(mask[i]) info.inComparison[k] = kTRUE;
+        else info.outside[k] = kTRUE;
+        if(maskNonSmooth[i]) info.nonSmooth[k] = kTRUE;
+      }
+    }
+
+    i = j;
+  }
+
+  // eta used outside of the comparisons
+  if(info.outside[1]) info.etaThresholds = kFALSE;
+
+  sort(info.thresholds.begin(), info.thresholds.end());
+  info.thresholds.erase(unique(info.thresholds.begin(), info.thresholds.end()), info.thresholds.end());
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+
+DelphesResolutionTable::DelphesResolutionTable() :
+  fFormula(0), fVariable(3), fIntervals(kFALSE)
+{
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesResolutionTable::Build(DelphesFormula *formula, const vector< Double_t > &etaValues, Bool_t closedForms)
+{
+  TExpressionInfo info;
+  vector< Double_t >::const_iterator itEta;
+  Double_t x[4];
+  TEntry entry;
+
+  fFormula = formula;
+  fVariable = 3;
+  fIntervals = kFALSE;
+  fEntries.clear();
+  fThresholds.clear();
+
+  AnalyseExpression(formula->GetExpression(), info);
+
+  for(itEta = etaValues.begin(); itEta != etaValues.end(); ++itEta)
+  {
+    x[0] = 0.0;
+    x[1] = *itEta;
+    x[2] = 0.0;
+    entry.eta = *itEta;
+    entry.closed = closedForms && !info.inComparison[3] && !info.nonSmooth[3] && Fit(x, 3, entry);
+    fEntries.push_back(entry);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesResolutionTable::Build(DelphesFormula *formula, Bool_t closedForms)
+{
+  TExpressionInfo info;
+  Double_t x[4];
+  TEntry entry;
+  Int_t i, variables;
+
+  fFormula = formula;
+  fIntervals = kFALSE;
+  fEntries.clear();
+  fThresholds.clear();
+
+  AnalyseExpression(formula->GetExpression(), info);
+
+  if(!closedForms || !info.etaThresholds) return;
+
+  // closed forms only exist for a single variable, which isn't compared
+  variables = 0;
+  fVariable = 3;
+  for(i = 0; i < 4; ++i)
+  {
+    if(i == 1) continue;
+    if(info.inComparison[i] || info.nonSmooth[i]) return;
+    if(!info.outside[i]) continue;
+    fVariable = i;
+    ++variables;
+  }
+  if(variables > 1 || fVariable == 2) return;
+
+  fThresholds = info.thresholds;
+
+  // one entry per interval between the thresholds
+  for(i = 0; i <= Int_t(fThresholds.size()); ++i)
+  {
+    if(fThresholds.empty()) entry.eta = 0.0;
+    else if(i == 0) entry.eta = fThresholds.front() - 1.0;
+    else if(i == Int_t(fThresholds.size())) entry.eta = fThresholds.back() + 1.0;
+    else entry.eta = 0.5*(fThresholds[i - 1] + fThresholds[i]);
+
+    x[0] = x[2] = x[3] = 0.0;
+    x[1] = entry.eta;
+    entry.closed = Fit(x, fVariable, entry);
+    fEntries.push_back(entry);
+  }
+
+  fIntervals = kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesResolutionTable::Write(TDirectory *directory, const char *name) const
+{
+  vector< TEntry >::const_iterator itEntry;
+  vector< Double_t > values;
+
+  // variable, intervals, thresholds and then 5 values per entry
+  values.push_back(fVariable);
+  values.push_back(fIntervals);
+  values.push_back(fThresholds.size());
+  values.insert(values.end(), fThresholds.begin(), fThresholds.end());
+  for(itEntry = fEntries.begin(); itEntry != fEntries.end(); ++itEntry)
+  {
+    values.push_back(itEntry->closed);
+    values.push_back(itEntry->eta);
+    values.push_back(itEntry->p0);
+    values.push_back(itEntry->p1);
+    values.push_back(itEntry->p2);
+  }
+
+  directory->WriteObject(&values, name);
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t DelphesResolutionTable::Read(TDirectory *directory, const char *name, DelphesFormula *formula)
+{
+  vector< Double_t > *values = 0;
+  vector< Double_t >::const_iterator itValue;
+  Long64_t size, thresholds;
+  TEntry entry;
+  Bool_t result = kFALSE, complete = kTRUE;
+
+  if(!directory) return kFALSE;
+
+  directory->GetObject(name, values);
+
+  if(values && values->size() >= 3)
+  {
+    size = values->size();
+    thresholds = Long64_t((*values)[2]);
+    result = thresholds >= 0 && size >= 3 + thresholds && (size - 3 - thresholds) % 5 == 0;
+  }
+
+  if(result)
+  {
+    fFormula = formula;
+    fVariable = Int_t((*values)[0]);
+    fIntervals = (*values)[1] != 0.0;
+    itValue = values->begin() + 3;
+    fThresholds.assign(itValue, itValue + thresholds);
+    fEntries.clear();
+    for(itValue += thresholds; itValue != values->end(); itValue += 5)
+    {
+      entry.closed = itValue[0] != 0.0;
+      entry.eta = itValue[1];
+      entry.p0 = itValue[2];
+      entry.p1 = itValue[3];
+      entry.p2 = itValue[4];
+      fEntries.push_back(entry);
+      if(!entry.closed) complete = kFALSE;
+    }
+
+    // the formula is still evaluated for most values without closed forms
+    if(fEntries.empty() || !complete) formula->CompilePending();
+  }
+
+  delete values;
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesResolutionTable::Eval(Int_t bin, Double_t energy) const
+{
+  const TEntry &entry = fEntries[bin];
+  Double_t value;
+
+  if(!entry.closed || energy < 0.0) return fFormula->Eval(0.0, entry.eta, 0.0, energy);
+
+  value = (entry.p2*energy + entry.p1)*energy + entry.p0;
+  return value > 0.0 ? TMath::Sqrt(value) : 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+Double_t DelphesResolutionTable::Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy) const
+{
+  vector< Double_t >::const_iterator itThreshold;
+  Double_t value, variable;
+
+  if(!fIntervals || TMath::IsNaN(eta)) return fFormula->Eval(pt, eta, phi, energy);
+
+  // the thresholds themselves are left to the formula
+  itThreshold = upper_bound(fThresholds.begin(), fThresholds.end(), eta);
+  if(itThreshold != fThresholds.begin() && *(itThreshold - 1) == eta) return fFormula->Eval(pt, eta, phi, energy);
+
+  const TEntry &entry = fEntries[distance(fThresholds.begin(), itThreshold)];
+  variable = fVariable == 0 ? pt : energy;
+  if(!entry.closed || variable < 0.0) return fFormula->Eval(pt, eta, phi, energy);
+
+  value = (entry.p2*variable + entry.p1)*variable + entry.p0;
+  return value > 0.0 ? TMath::Sqrt(value) : 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+
+Bool_t DelphesResolutionTable::Fit(Double_t *x, Int_t variable, TEntry &entry) const
+{
+  Double_t f0, f1, f2, d1, d2, f, value;
+  UInt_t i;
+
+  // square of the formula at 0, 1 and 100
+  x[variable] = 0.0;
+  f0 = fFormula->Eval(x[0], x[1], x[2], x[3]);
+  x[variable] = 1.0;
+  f1 = fFormula->Eval(x[0], x[1], x[2], x[3]);
+  x[variable] = 100.0;
+  f2 = fFormula->Eval(x[0], x[1], x[2], x[3]);
+
+  if(!TMath::Finite(f0) || !TMath::Finite(f1) || !TMath::Finite(f2)) return kFALSE;
+  if(f0 < 0.0 || f1 < 0.0 || f2 < 0.0) return kFALSE;
+
+  d1 = f1*f1 - f0*f0;
+  d2 = f2*f2 - f0*f0;
+
+  entry.p0 = f0*f0;
+  entry.p2 = (d2 - 100.0*d1)/9900.0;
+  entry.p1 = d1 - entry.p2;
+
+  // the closed form has to reproduce the formula elsewhere
+  for(i = 0; i < sizeof(kCheckValues)/sizeof(Double_t); ++i)
+  {
+    x[variable] = kCheckValues[i];
+    f = fFormula->Eval(x[0], x[1], x[2], x[3]);
+    if(!TMath::Finite(f) || f < 0.0) return kFALSE;
+
+    value = (entry.p2*x[variable] + entry.p1)*x[variable] + entry.p0;
+    value = value > 0.0 ? TMath::Sqrt(value) : 0.0;
+    if(TMath::Abs(value - f) > kTolerance*f) return kFALSE;
+  }
+
+  return kTRUE;
+}
+
+//------------------------------------------------------------------------------
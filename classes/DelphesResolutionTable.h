@@ -0,0 +1,83 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesResolutionTable_h
+#define DelphesResolutionTable_h
+
+/** \class DelphesResolutionTable
+ *
+ *  Resolution formulas tabulated in bins of eta. In each bin where the
+ *  formula has the form sqrt(a^2*v^2 + b^2*v + c^2) of a single variable v
+ *  (energy or pt), it is evaluated in closed form. Otherwise the formula
+ *  itself is evaluated.
+ *
+ */
+
+#include "Rtypes.h"
+
+#include <vector>
+
+class TDirectory;
+class DelphesFormula;
+
+class DelphesResolutionTable
+{
+public:
+
+  DelphesResolutionTable();
+
+  // tabulates the formula at given values of eta as a function of energy,
+  // pt and phi are set to 0 as in the calorimeters
+  void Build(DelphesFormula *formula, const std::vector< Double_t > &etaValues, Bool_t closedForms = kTRUE);
+
+  // tabulates the formula in the eta intervals where it doesn't depend on eta;
+  // without closed forms the formula itself is always evaluated, as a reference
+  void Build(DelphesFormula *formula, Bool_t closedForms = kTRUE);
+
+  // writes the table to a snapshot and reads it back for the same formula,
+  // which is then only evaluated where the table doesn't apply
+  void Write(TDirectory *directory, const char *name) const;
+  Bool_t Read(TDirectory *directory, const char *name, DelphesFormula *formula);
+
+  // formula at the eta value of the bin
+  Double_t Eval(Int_t bin, Double_t energy) const;
+
+  Double_t Eval(Double_t pt, Double_t eta, Double_t phi, Double_t energy) const;
+
+private:
+
+  struct TEntry
+  {
+    Bool_t closed;
+    Double_t eta;
+    Double_t p0, p1, p2;
+  };
+
+  Bool_t Fit(Double_t *x, Int_t variable, TEntry &entry) const;
+
+  DelphesFormula *fFormula;
+
+  Int_t fVariable;
+
+  Bool_t fIntervals;
+
+  std::vector< TEntry > fEntries;
+  std::vector< Double_t > fThresholds;
+};
+
+#endif /* DelphesResolutionTable_h */
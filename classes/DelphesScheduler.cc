@@ -0,0 +1,200 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class DelphesScheduler
+ *
+ *  Runs the modules of an event on a pool of threads. A module starts
+ *  when all the modules it depends on are done. Modules that are not
+ *  concurrent run one at a time.
+ *
+ */
+
+#include "classes/DelphesScheduler.h"
+
+#include "ExRootAnalysis/ExRootTask.h"
+
+#include "TTask.h"
+#include "TList.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+static void RunTask(TTask *task)
+{
+  TIter itSubTasks(task->GetListOfTasks());
+  TTask *subTask;
+
+  // TTask::ExecuteTask uses static state, the tasks are processed directly
+  if(!task->IsActive()) return;
+
+  if(task->InheritsFrom(ExRootTask::Class())) static_cast<ExRootTask *>(task)->Process();
+
+  while((subTask = static_cast<TTask *>(itSubTasks())))
+  {
+    RunTask(subTask);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+DelphesScheduler::DelphesScheduler(Int_t threads) :
+  fThreads(threads), fRemaining(0), fStop(kFALSE)
+{
+}
+
+//------------------------------------------------------------------------------
+
+DelphesScheduler::~DelphesScheduler()
+{
+  vector< thread >::iterator itWorkers;
+
+  {
+    lock_guard< mutex > lock(fMutex);
+    fStop = kTRUE;
+  }
+  fCondition.notify_all();
+
+  for(itWorkers = fWorkers.begin(); itWorkers != fWorkers.end(); ++itWorkers)
+  {
+    itWorkers->join();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Int_t DelphesScheduler::AddTask(TTask *task, Bool_t concurrent)
+{
+  TNode node;
+
+  node.task = task;
+  node.concurrent = concurrent;
+  node.dependencies = 0;
+  node.pending = 0;
+
+  fNodes.push_back(node);
+
+  return fNodes.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesScheduler::AddDependency(Int_t before, Int_t after)
+{
+  fNodes[before].dependents.push_back(after);
+  ++fNodes[after].dependencies;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesScheduler::Run()
+{
+  unique_lock< mutex > lock(fMutex);
+  exception_ptr error;
+  Int_t i;
+
+  // the workers are started by the first event
+  while(Int_t(fWorkers.size()) < fThreads - 1)
+  {
+    fWorkers.push_back(thread(&DelphesScheduler::Work, this));
+  }
+
+  for(i = 0; i < Int_t(fNodes.size()); ++i)
+  {
+    fNodes[i].pending = fNodes[i].dependencies;
+    if(fNodes[i].pending == 0) fReady.push_back(i);
+  }
+  fRemaining = fNodes.size();
+  fError = exception_ptr();
+  fCondition.notify_all();
+
+  while(fRemaining > 0)
+  {
+    if(fReady.empty())
+      fCondition.wait(lock);
+    else
+      RunNode(lock);
+  }
+
+  error = fError;
+  fError = exception_ptr();
+  lock.unlock();
+
+  if(error) rethrow_exception(error);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesScheduler::Work()
+{
+  unique_lock< mutex > lock(fMutex);
+
+  while(!fStop)
+  {
+    if(fReady.empty())
+      fCondition.wait(lock);
+    else
+      RunNode(lock);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesScheduler::RunNode(unique_lock< mutex > &lock)
+{
+  Int_t node = fReady.front();
+  TNode &current = fNodes[node];
+  vector< Int_t >::iterator itDependents;
+  Bool_t skip = Bool_t(fError);
+
+  fReady.pop_front();
+  lock.unlock();
+
+  // after an error the remaining tasks are only counted down
+  if(!skip)
+  {
+    try
+    {
+      if(current.concurrent)
+      {
+        RunTask(current.task);
+      }
+      else
+      {
+        lock_guard< mutex > serial(fSerialMutex);
+        RunTask(current.task);
+      }
+    }
+    catch(...)
+    {
+      lock.lock();
+      if(!fError) fError = current_exception();
+      lock.unlock();
+    }
+  }
+
+  lock.lock();
+
+  for(itDependents = current.dependents.begin(); itDependents != current.dependents.end(); ++itDependents)
+  {
+    if(--fNodes[*itDependents].pending == 0) fReady.push_back(*itDependents);
+  }
+
+  if(--fRemaining == 0 || !fReady.empty()) fCondition.notify_all();
+}
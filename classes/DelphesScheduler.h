@@ -0,0 +1,84 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesScheduler_h
+#define DelphesScheduler_h
+
+/** \class DelphesScheduler
+ *
+ *  Runs the modules of an event on a pool of threads. A module starts
+ *  when all the modules it depends on are done. Modules that are not
+ *  concurrent run one at a time.
+ *
+ */
+
+#include "Rtypes.h"
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <condition_variable>
+
+class TTask;
+
+class DelphesScheduler
+{
+public:
+
+  // the calling thread is one of the threads
+  DelphesScheduler(Int_t threads);
+  ~DelphesScheduler();
+
+  Int_t AddTask(TTask *task, Bool_t concurrent);
+
+  // the task after starts when the task before is done
+  void AddDependency(Int_t before, Int_t after);
+
+  // runs all tasks once, rethrows the first exception thrown by a task
+  void Run();
+
+private:
+
+  struct TNode
+  {
+    TTask *task;
+    Bool_t concurrent;
+    Int_t dependencies, pending;
+    std::vector< Int_t > dependents;
+  };
+
+  void Work();
+  void RunNode(std::unique_lock< std::mutex > &lock);
+
+  std::vector< TNode > fNodes;
+  std::deque< Int_t > fReady;
+
+  Int_t fThreads, fRemaining;
+  Bool_t fStop;
+
+  std::exception_ptr fError;
+
+  std::vector< std::thread > fWorkers;
+
+  std::mutex fMutex, fSerialMutex;
+  std::condition_variable fCondition;
+};
+
+#endif /* DelphesScheduler_h */
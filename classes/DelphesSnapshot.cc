@@ -0,0 +1,136 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class DelphesSnapshot
+ *
+ *  Reads and writes the state shared by several modules in the snapshot
+ *  of the initialised module chain.
+ *
+ */
+
+#include "classes/DelphesSnapshot.h"
+
+#include "TSystem.h"
+#include "TDirectory.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+void DelphesSnapshot::WriteBins(TDirectory *directory,
+  const vector< Double_t > &etaBins,
+  const vector< vector< Double_t > * > &phiBins)
+{
+  vector< vector< Double_t > * >::const_iterator itPhiBins;
+  vector< Double_t > allPhiBins;
+  vector< Int_t > phiBinsSize;
+
+  // phi bins of all eta bins are stored one after the other
+  for(itPhiBins = phiBins.begin(); itPhiBins != phiBins.end(); ++itPhiBins)
+  {
+    allPhiBins.insert(allPhiBins.end(), (*itPhiBins)->begin(), (*itPhiBins)->end());
+    phiBinsSize.push_back((*itPhiBins)->size());
+  }
+
+  directory->WriteObject(&etaBins, "EtaBins");
+  directory->WriteObject(&allPhiBins, "PhiBins");
+  directory->WriteObject(&phiBinsSize, "PhiBinsSize");
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t DelphesSnapshot::ReadBins(TDirectory *directory,
+  vector< Double_t > &etaBins,
+  vector< vector< Double_t > * > &phiBins)
+{
+  vector< Double_t > *etaBinsRead = 0, *phiBinsRead = 0;
+  vector< Int_t > *phiBinsSize = 0;
+  vector< Int_t >::iterator itSize;
+  vector< Double_t >::iterator itPhiBin;
+  Long64_t total = 0;
+  Bool_t result = kFALSE;
+
+  if(!directory) return kFALSE;
+
+  directory->GetObject("EtaBins", etaBinsRead);
+  directory->GetObject("PhiBins", phiBinsRead);
+  directory->GetObject("PhiBinsSize", phiBinsSize);
+
+  if(etaBinsRead && phiBinsRead && phiBinsSize && etaBinsRead->size() == phiBinsSize->size())
+  {
+    for(itSize = phiBinsSize->begin(); itSize != phiBinsSize->end(); ++itSize) total += *itSize;
+    result = (total == Long64_t(phiBinsRead->size()));
+  }
+
+  if(result)
+  {
+    etaBins = *etaBinsRead;
+    itPhiBin = phiBinsRead->begin();
+    for(itSize = phiBinsSize->begin(); itSize != phiBinsSize->end(); ++itSize)
+    {
+      phiBins.push_back(new vector< Double_t >(itPhiBin, itPhiBin + *itSize));
+      itPhiBin += *itSize;
+    }
+  }
+
+  delete etaBinsRead;
+  delete phiBinsRead;
+  delete phiBinsSize;
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesSnapshot::WriteFileStamp(TDirectory *directory, const char *fileName)
+{
+  FileStat_t stat;
+  vector< Long64_t > stamp;
+
+  if(gSystem->GetPathInfo(fileName, stat) != 0) return;
+
+  stamp.push_back(stat.fSize);
+  stamp.push_back(stat.fMtime);
+
+  directory->WriteObject(&stamp, "FileStamp");
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t DelphesSnapshot::CheckFileStamp(TDirectory *directory, const char *fileName)
+{
+  FileStat_t stat;
+  vector< Long64_t > *stamp = 0;
+  Bool_t result = kFALSE;
+
+  if(!directory) return kFALSE;
+
+  directory->GetObject("FileStamp", stamp);
+
+  if(stamp && stamp->size() == 2 && gSystem->GetPathInfo(fileName, stat) == 0)
+  {
+    result = (*stamp)[0] == stat.fSize && (*stamp)[1] == stat.fMtime;
+  }
+
+  delete stamp;
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
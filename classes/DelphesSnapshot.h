@@ -0,0 +1,55 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesSnapshot_h
+#define DelphesSnapshot_h
+
+/** \class DelphesSnapshot
+ *
+ *  Reads and writes the state shared by several modules in the snapshot
+ *  of the initialised module chain.
+ *
+ */
+
+#include "Rtypes.h"
+
+#include <vector>
+
+class TDirectory;
+
+class DelphesSnapshot
+{
+public:
+
+  // eta bins and phi bins of each eta bin of a calorimeter
+  static void WriteBins(TDirectory *directory,
+    const std::vector< Double_t > &etaBins,
+    const std::vector< std::vector< Double_t > * > &phiBins);
+
+  static Bool_t ReadBins(TDirectory *directory,
+    std::vector< Double_t > &etaBins,
+    std::vector< std::vector< Double_t > * > &phiBins);
+
+  // size and modification time of an input file, to check that the state
+  // read from it is still valid
+  static void WriteFileStamp(TDirectory *directory, const char *fileName);
+
+  static Bool_t CheckFileStamp(TDirectory *directory, const char *fileName);
+};
+
+#endif /* DelphesSnapshot_h */
@@ -40,11 +40,11 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
-bool DelphesStream::fFirstLongMin = true;
-bool DelphesStream::fFirstLongMax = true;
-bool DelphesStream::fFirstHugePos = true;
-bool DelphesStream::fFirstHugeNeg = true;
-bool DelphesStream::fFirstZero = true;
+atomic<bool> DelphesStream::fFirstLongMin(true);
+atomic<bool> DelphesStream::fFirstLongMax(true);
+atomic<bool> DelphesStream::fFirstHugePos(true);
+atomic<bool> DelphesStream::fFirstHugeNeg(true);
+atomic<bool> DelphesStream::fFirstZero(true);
 
 //------------------------------------------------------------------------------
 
@@ -62,19 +62,16 @@ bool DelphesStream::ReadDbl(double &value)
   value = strtod(start, &fBuffer);
   if(errno == ERANGE)
   {
-    if(fFirstHugePos && value == HUGE_VAL)
+    if(value == HUGE_VAL && fFirstHugePos.exchange(false))
     {
-      fFirstHugePos = false; 
       cout << "** WARNING: too large positive value, return " << value << endl;
     }
-    else if(fFirstHugeNeg && value == -HUGE_VAL)
+    else if(value == -HUGE_VAL && fFirstHugeNeg.exchange(false))
     {
-      fFirstHugeNeg = false; 
       cout << "** WARNING: too large negative value, return " << value << endl;
     }
-    else if(fFirstZero)
+    else if(fFirstZero.exchange(false))
     {
-      fFirstZero = false; 
       value = 0.0;
       cout << "** WARNING: too small value, return " << value << endl;
     }
@@ -91,14 +88,12 @@ bool DelphesStream::ReadInt(int &value)
   value = strtol(start, &fBuffer, 10);
   if(errno == ERANGE)
   {
-    if(fFirstLongMin && value == LONG_MIN)
+    if(value == LONG_MIN && fFirstLongMin.exchange(false))
     {
-      fFirstLongMin = false; 
       cout << "** WARNING: too large positive value, return " << value << endl;
     }
-    else if(fFirstLongMax && value == LONG_MAX)
+    else if(value == LONG_MAX && fFirstLongMax.exchange(false))
     {
-      fFirstLongMax = false; 
       cout << "** WARNING: too large negative value, return " << value << endl;
     }
   }
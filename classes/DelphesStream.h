@@ -27,6 +27,8 @@
  *
  */
 
+#include <atomic>
+
 class DelphesStream
 {
 public:
@@ -40,11 +42,12 @@ private:
 
   char *fBuffer;
   
-  static bool fFirstLongMin;
-  static bool fFirstLongMax;
-  static bool fFirstHugePos;
-  static bool fFirstHugeNeg;
-  static bool fFirstZero;
+  // each warning is printed once, also when several threads read
+  static std::atomic<bool> fFirstLongMin;
+  static std::atomic<bool> fFirstLongMax;
+  static std::atomic<bool> fFirstHugePos;
+  static std::atomic<bool> fFirstHugeNeg;
+  static std::atomic<bool> fFirstZero;
 };
 
 #endif // DelphesStream_h
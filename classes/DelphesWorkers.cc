@@ -0,0 +1,161 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class DelphesWorkers
+ *
+ *  Runs the event loop of a reader in several processes forked after the
+ *  initialisation of the modules.
+ *
+ */
+
+#include "classes/DelphesWorkers.h"
+
+#include "TSystem.h"
+#include "TFileMerger.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+DelphesWorkers::DelphesWorkers(int workers) :
+  fWorkers(workers), fFailures(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+int DelphesWorkers::ReadOption(int &argc, char *argv[])
+{
+  int i, j, workers = 1;
+
+  for(i = 1; i < argc; ++i)
+  {
+    if(strcmp(argv[i], "--workers") != 0) continue;
+
+    workers = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+    if(workers < 1) return 0;
+
+    for(j = i; j + 2 < argc; ++j) argv[j] = argv[j + 2];
+    argc -= 2;
+    break;
+  }
+
+  return workers;
+}
+
+//------------------------------------------------------------------------------
+
+TString DelphesWorkers::GetOutputName(const char *outputName, int worker)
+{
+  return TString::Format("%s.worker%d", outputName, worker);
+}
+
+//------------------------------------------------------------------------------
+
+void DelphesWorkers::Exit(int status)
+{
+  cout.flush();
+  cerr.flush();
+  fflush(0);
+  _exit(status);
+}
+
+//------------------------------------------------------------------------------
+
+int DelphesWorkers::Fork()
+{
+  stringstream message;
+  vector< pid_t > pids;
+  vector< pid_t >::iterator itPids;
+  pid_t pid;
+  int worker, status;
+
+  // buffered output would be written by every worker
+  cout.flush();
+  fflush(0);
+
+  for(worker = 0; worker < fWorkers; ++worker)
+  {
+    pid = fork();
+    if(pid == 0) return worker;
+
+    if(pid < 0)
+    {
+      for(itPids = pids.begin(); itPids != pids.end(); ++itPids)
+      {
+        kill(*itPids, SIGTERM);
+        waitpid(*itPids, &status, 0);
+      }
+      message << "can't fork worker process: " << strerror(errno);
+      throw runtime_error(message.str());
+    }
+
+    pids.push_back(pid);
+  }
+
+  fFailures = 0;
+  for(itPids = pids.begin(); itPids != pids.end(); ++itPids)
+  {
+    while((pid = waitpid(*itPids, &status, 0)) < 0 && errno == EINTR) continue;
+    if(pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ++fFailures;
+  }
+
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+
+bool DelphesWorkers::Merge(const char *outputName)
+{
+  TFileMerger merger(kFALSE);
+  int worker;
+
+  if(!merger.OutputFile(outputName, "RECREATE")) return false;
+
+  for(worker = 0; worker < fWorkers; ++worker)
+  {
+    if(!merger.AddFile(GetOutputName(outputName, worker), kFALSE)) return false;
+  }
+
+  // a partial output is removed, the outputs of the workers are kept
+  if(!merger.Merge())
+  {
+    gSystem->Unlink(outputName);
+    return false;
+  }
+
+  for(worker = 0; worker < fWorkers; ++worker)
+  {
+    gSystem->Unlink(GetOutputName(outputName, worker));
+  }
+
+  return true;
+}
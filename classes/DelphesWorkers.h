@@ -0,0 +1,70 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesWorkers_h
+#define DelphesWorkers_h
+
+/** \class DelphesWorkers
+ *
+ *  Runs the event loop of a reader in several processes forked after the
+ *  initialisation of the modules, so that the workers share the initialised
+ *  state through copy-on-write pages. Worker i processes the i-th part of
+ *  each input file, or every N-th event starting from the i-th one, and
+ *  writes its own output file, the outputs are merged by the parent process.
+ *
+ */
+
+#include "TString.h"
+
+#include <vector>
+
+class DelphesWorkers
+{
+public:
+
+  DelphesWorkers(int workers);
+
+  // removes "--workers N" from the command line and returns N,
+  // 1 without the option and 0 if N is not a positive number
+  static int ReadOption(int &argc, char *argv[]);
+
+  // output file of a worker
+  static TString GetOutputName(const char *outputName, int worker);
+
+  // ends a worker process without running the exit handlers, which would
+  // close the files inherited from the parent process
+  static void Exit(int status);
+
+  // forks the workers, returns the worker index in the child processes
+  // and -1 in the parent process once all workers have exited
+  int Fork();
+
+  // number of workers that did not exit successfully
+  int GetFailures() const { return fFailures; }
+
+  // merges the outputs of the workers into outputName, they are removed
+  // only if the merge succeeds and are otherwise kept for diagnosis
+  bool Merge(const char *outputName);
+
+private:
+
+  int fWorkers;
+  int fFailures;
+};
+
+#endif // DelphesWorkers_h
@@ -259,6 +259,27 @@ CXXFLAGS += -I$(PROIO)/include -I$(PROTOBUF)/include -I$(LZ4)/include -I$(PROIO)
 OPT_LIBS += -L$(PROTOBUF)/lib -lprotobuf -L$(PROIO)/lib -lproio -lproio.pb -lz -L$(LZ4)/lib -llz4
 endif
 
+# compression libraries of the input files, zlib is also needed by ROOT
+OPT_LIBS += -lz
+
+ifeq ($(shell pkg-config --exists liblzma 2> /dev/null && echo true),true)
+CXXFLAGS += -DHAS_LZMA $(shell pkg-config --cflags liblzma)
+OPT_LIBS += $(shell pkg-config --libs liblzma)
+endif
+
+ifeq ($(shell pkg-config --exists libzstd 2> /dev/null && echo true),true)
+CXXFLAGS += -DHAS_ZSTD $(shell pkg-config --cflags libzstd)
+OPT_LIBS += $(shell pkg-config --libs libzstd)
+endif
+
+# OpenMP threads for the z regions of VertexFinderDA4D, NOOPENMP=1 switches them off
+ifeq ($(NOOPENMP),)
+ifeq ($(shell echo 'int main() { return 0; }' | $(CXX) -fopenmp -x c++ - -o /dev/null 2> /dev/null && echo true),true)
+CXXFLAGS += -fopenmp
+OPT_LIBS += -fopenmp
+endif
+endif
+
 ifeq ($(HAS_PYTHIA8),true)
 ifneq ($(PYTHIA8),)
 CXXFLAGS += -I$(PYTHIA8)/include
@@ -438,6 +459,13 @@ dist:
 	@tar -czf $(DISTTAR) $(DISTDIR)
 	@rm -rf $(DISTDIR)
 
+check: all
+	@echo ">> Running regression checks"
+	@./HectorTableCheck 100000
+	@./PIDTableCheck 100000 cards/delphes_card_LHCb.tcl
+	@./ResolutionTableCheck 100000 1e-6 cards/delphes_card_CMS.tcl cards/CMS_PhaseII/CMS_PhaseII_0PU.tcl
+	@./ThreadStress gun 200 4
+
 ###
 
 .SUFFIXES: .$(SrcSuf) .$(ObjSuf) .$(DllSuf) $(PcmSuf)
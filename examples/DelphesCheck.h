@@ -0,0 +1,243 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DelphesCheck_h
+#define DelphesCheck_h
+
+/** \class DelphesCheck
+ *
+ *  Set-up shared by the regression checks of this directory: reads a
+ *  configuration card followed by additional settings, initialises the
+ *  modules with or without an output file and fills their input arrays
+ *  (Delphes/allParticles, stableParticles and partons) with generated
+ *  particles, so that the checks run the modules themselves.
+ *
+ *  It is only included by the check programs, one per executable.
+ *
+ */
+
+#include <sstream>
+#include <stdexcept>
+
+#include <stdio.h>
+
+#include "TFile.h"
+#include "TSystem.h"
+#include "TObjArray.h"
+#include "TDatabasePDG.h"
+#include "TParticlePDG.h"
+
+#include "modules/Delphes.h"
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+
+#include "ExRootAnalysis/ExRootConfReader.h"
+#include "ExRootAnalysis/ExRootTreeWriter.h"
+
+class DelphesCheck
+{
+public:
+
+  // reads the card, if any, and then the settings, Tcl commands such as
+  // "set ExecutionPath {A B}" or "module Hector A {...}"; the TreeWriter
+  // module writes to outputFile if it is given
+  DelphesCheck(const char *configName, const char *settings = 0, TFile *outputFile = 0);
+  ~DelphesCheck();
+
+  // adds settings to the configuration read so far
+  static void ReadSettings(ExRootConfReader *confReader, const char *settings);
+
+  ExRootConfReader *GetConfReader() const { return fConfReader; }
+  DelphesFactory *GetFactory() const { return fFactory; }
+
+  TObjArray *GetAllParticles() const { return fAllParticles; }
+  TObjArray *GetStableParticles() const { return fStableParticles; }
+  TObjArray *GetPartons() const { return fPartons; }
+
+  // additional input array "Delphes/name", exported before Init
+  TObjArray *ExportArray(const char *name) { return fDelphes->ExportArray(name); }
+
+  // stable particle from the origin, with the charge and the mass of its
+  // PID, added to allParticles and stableParticles
+  Candidate *AddParticle(Int_t pid, Double_t pt, Double_t eta, Double_t phi);
+
+  void Init();
+
+  // module of the execution path and output array "module/array",
+  // available after Init
+  ExRootTask *GetModule(const char *name) const;
+  TObjArray *GetOutputArray(const char *name);
+
+  // runs all modules on the current event and fills the output tree
+  void Process();
+  void Clear();
+  void Finish();
+
+private:
+
+  ExRootConfReader *fConfReader;
+  ExRootTreeWriter *fTreeWriter;
+  Delphes *fDelphes;
+  DelphesFactory *fFactory;
+
+  TObjArray *fAllParticles, *fStableParticles, *fPartons;
+
+  TDatabasePDG *fPDG;
+
+  Bool_t fOutput;
+};
+
+//------------------------------------------------------------------------------
+
+inline DelphesCheck::DelphesCheck(const char *configName, const char *settings, TFile *outputFile) :
+  fConfReader(0), fTreeWriter(0), fDelphes(0), fFactory(0),
+  fAllParticles(0), fStableParticles(0), fPartons(0),
+  fPDG(TDatabasePDG::Instance()), fOutput(outputFile != 0)
+{
+  fConfReader = new ExRootConfReader;
+  if(configName) fConfReader->ReadFile(configName);
+  if(settings) ReadSettings(fConfReader, settings);
+
+  // without an output file the tree is never filled
+  fTreeWriter = new ExRootTreeWriter(outputFile, "Delphes");
+
+  fDelphes = new Delphes("Delphes");
+  fDelphes->SetConfReader(fConfReader);
+  fDelphes->SetTreeWriter(fTreeWriter);
+
+  fFactory = fDelphes->GetFactory();
+  fAllParticles = fDelphes->ExportArray("allParticles");
+  fStableParticles = fDelphes->ExportArray("stableParticles");
+  fPartons = fDelphes->ExportArray("partons");
+}
+
+//------------------------------------------------------------------------------
+
+inline DelphesCheck::~DelphesCheck()
+{
+  delete fDelphes;
+  delete fConfReader;
+  delete fTreeWriter;
+}
+
+//------------------------------------------------------------------------------
+
+inline void DelphesCheck::ReadSettings(ExRootConfReader *confReader, const char *settings)
+{
+  std::stringstream message;
+  TString fileName("DelphesCheck");
+  FILE *file = gSystem->TempFileName(fileName);
+
+  if(!file)
+  {
+    message << "can't create temporary configuration file";
+    throw std::runtime_error(message.str());
+  }
+
+  fputs(settings, file);
+  fclose(file);
+
+  try
+  {
+    confReader->ReadFile(fileName, false);
+  }
+  catch(...)
+  {
+    gSystem->Unlink(fileName);
+    throw;
+  }
+
+  gSystem->Unlink(fileName);
+}
+
+//------------------------------------------------------------------------------
+
+inline Candidate *DelphesCheck::AddParticle(Int_t pid, Double_t pt, Double_t eta, Double_t phi)
+{
+  Candidate *candidate = fFactory->NewCandidate();
+  TParticlePDG *particle = fPDG->GetParticle(pid);
+
+  candidate->PID = pid;
+  candidate->Status = 1;
+  candidate->Charge = particle ? Int_t(particle->Charge()/3.0) : 0;
+  candidate->Mass = particle ? particle->Mass() : 0.0;
+
+  candidate->Momentum.SetPtEtaPhiM(pt, eta, phi, candidate->Mass);
+
+  fAllParticles->Add(candidate);
+  fStableParticles->Add(candidate);
+
+  return candidate;
+}
+
+//------------------------------------------------------------------------------
+
+inline void DelphesCheck::Init()
+{
+  fDelphes->InitTask();
+  Clear();
+}
+
+//------------------------------------------------------------------------------
+
+inline ExRootTask *DelphesCheck::GetModule(const char *name) const
+{
+  std::stringstream message;
+  ExRootTask *task = static_cast<ExRootTask *>(fDelphes->GetListOfTasks()->FindObject(name));
+
+  if(!task)
+  {
+    message << "module '" << name << "' is not in the execution path";
+    throw std::runtime_error(message.str());
+  }
+
+  return task;
+}
+
+//------------------------------------------------------------------------------
+
+inline TObjArray *DelphesCheck::GetOutputArray(const char *name)
+{
+  return fDelphes->ImportArray(name);
+}
+
+//------------------------------------------------------------------------------
+
+inline void DelphesCheck::Process()
+{
+  fDelphes->ProcessTask();
+  if(fOutput) fTreeWriter->Fill();
+}
+
+//------------------------------------------------------------------------------
+
+inline void DelphesCheck::Clear()
+{
+  fTreeWriter->Clear();
+  fDelphes->Clear();
+}
+
+//------------------------------------------------------------------------------
+
+inline void DelphesCheck::Finish()
+{
+  fDelphes->FinishTask();
+  if(fOutput) fTreeWriter->Write();
+}
+
+#endif /* DelphesCheck_h */
@@ -0,0 +1,181 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+This program fills the leading jet PT histogram of a Delphes output file
+with several threads. Every thread has its own chain and ExRootTreeReader
+and reads its own range of entries, the ranges start at cluster boundaries
+so that no basket is decompressed twice. The baskets are decompressed ahead
+of the readers on a pool of read threads.
+
+Files written with 'set Columnar true' are read one cluster of entries at a
+time from the Jet.PT column, other files one entry at a time from the Jet
+branch.
+
+Example:
+
+./ExampleParallel delphes_output.root 4 2
+*/
+
+#include <iostream>
+#include <vector>
+#include <thread>
+
+#include <stdlib.h>
+
+#include "TROOT.h"
+#include "TH1.h"
+#include "TChain.h"
+#include "TClonesArray.h"
+
+#include "classes/DelphesClasses.h"
+
+#include "ExRootAnalysis/ExRootTreeReader.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+void AnalyseColumns(ExRootTreeReader &treeReader, Long64_t first, Long64_t last, TH1 *histJetPT)
+{
+  ExRootTreeColumn *columnJetPT = treeReader.UseColumn("Jet.PT");
+  Long64_t entry, clusterEntry, clusterLast;
+
+  for(entry = first; entry < last; entry = clusterLast)
+  {
+    clusterLast = treeReader.ReadCluster(entry);
+
+    const vector< Double_t > &values = columnJetPT->GetValues();
+    for(clusterEntry = entry; clusterEntry < columnJetPT->GetLastEntry(); ++clusterEntry)
+    {
+      if(columnJetPT->GetSize(clusterEntry) > 0)
+      {
+        histJetPT->Fill(values[columnJetPT->GetOffset(clusterEntry)]);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void AnalyseEntries(const char *inputFile, Long64_t first, Long64_t last, Int_t readThreads, Bool_t columnar, TH1 *histJetPT)
+{
+  TChain chain("Delphes");
+  chain.Add(inputFile);
+
+  ExRootTreeReader treeReader(&chain);
+  TClonesArray *branchJet;
+  Jet *jet;
+  Long64_t entry;
+
+  treeReader.SetEntryRange(first, last);
+  treeReader.SetReadThreads(readThreads);
+
+  if(columnar)
+  {
+    AnalyseColumns(treeReader, first, last, histJetPT);
+    return;
+  }
+
+  branchJet = treeReader.UseBranch("Jet");
+
+  for(entry = first; entry < last; ++entry)
+  {
+    treeReader.ReadEntry(entry);
+
+    if(branchJet->GetEntriesFast() > 0)
+    {
+      jet = static_cast<Jet*>(branchJet->At(0));
+      histJetPT->Fill(jet->PT);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  const char *appName = "ExampleParallel";
+
+  if(argc < 3 || argc > 4)
+  {
+    cout << " Usage: " << appName << " input_file number_of_threads [number_of_read_threads]" << endl;
+    cout << " input_file - input file in ROOT format ('Delphes' tree)," << endl;
+    cout << " number_of_threads - number of threads reading the input file," << endl;
+    cout << " number_of_read_threads - number of threads decompressing baskets (default 2)" << endl;
+    return 1;
+  }
+
+  Int_t i, numberOfThreads = atoi(argv[2]);
+  Int_t readThreads = argc > 3 ? atoi(argv[3]) : 2;
+  Long64_t numberOfEntries;
+  TBranch *branch;
+  Bool_t columnar;
+
+  if(numberOfThreads < 1) numberOfThreads = 1;
+
+  gROOT->SetBatch();
+  ROOT::EnableThreadSafety();
+  TH1::AddDirectory(kFALSE);
+
+  TChain chain("Delphes");
+  chain.Add(argv[1]);
+
+  ExRootTreeReader treeReader(&chain);
+  numberOfEntries = treeReader.GetEntries();
+
+  // enables the parallel decompression before the readers start
+  treeReader.SetReadThreads(readThreads);
+
+  // columns are flat branches, split object branches are TBranchElements
+  branch = chain.GetBranch("Jet.PT");
+  columnar = branch && branch->IsA() == TBranch::Class();
+
+  // split the entries at cluster boundaries
+  vector< Long64_t > boundaries(numberOfThreads + 1, numberOfEntries);
+  boundaries[0] = 0;
+  for(i = 1; i < numberOfThreads; ++i)
+  {
+    boundaries[i] = treeReader.GetClusterStart(numberOfEntries*i/numberOfThreads);
+  }
+
+  vector< TH1 * > histograms;
+  vector< thread > threads;
+
+  for(i = 0; i < numberOfThreads; ++i)
+  {
+    histograms.push_back(new TH1F(Form("jet_pt_%d", i), "leading jet P_{T}", 50, 0.0, 100.0));
+    threads.push_back(thread(AnalyseEntries, argv[1], boundaries[i], boundaries[i + 1], readThreads, columnar, histograms[i]));
+  }
+
+  for(i = 0; i < numberOfThreads; ++i)
+  {
+    threads[i].join();
+    if(i > 0) histograms[0]->Add(histograms[i]);
+  }
+
+  cout << "** Leading jet PT: " << histograms[0]->GetEntries() << " entries, mean ";
+  cout << histograms[0]->GetMean() << " GeV" << endl;
+
+  for(i = 0; i < numberOfThreads; ++i)
+  {
+    delete histograms[i];
+  }
+
+  return 0;
+}
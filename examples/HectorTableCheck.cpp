@@ -0,0 +1,233 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+This program checks the tabulated transfer matrices of the Hector module
+against the element by element transport. The same protons, antiprotons and
+neutrons, generated with a fixed seed, are transported by two Hector modules
+that only differ by XiBins (250 and 0), with gRandom set to the same seed
+before each of them so that both draw the same smearing.
+
+For every particle it compares the acceptance and, when both modules accept
+it, the positions and angles at Distance. It exits with status 1 if the
+fraction of particles with a different acceptance or the largest difference
+of the positions (um) and angles (urad) exceed the given limits.
+
+Example:
+
+./HectorTableCheck 100000 cards/LHCB1IR5_7TeV.tfs 420
+*/
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <map>
+
+#include <stdlib.h>
+
+#include "TROOT.h"
+#include "TApplication.h"
+
+#include "TMath.h"
+#include "TRandom3.h"
+
+#include "examples/DelphesCheck.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+static string GetSettings(const char *beamLineName, Double_t distance)
+{
+  stringstream settings;
+  const char *names[2] = {"HectorTable", "HectorExact"};
+  Int_t i;
+
+  settings << "set ExecutionPath {" << names[0] << " " << names[1] << "}" << endl;
+  for(i = 0; i < 2; ++i)
+  {
+    settings << "module Hector " << names[i] << " {" << endl;
+    settings << "  set InputArray Delphes/stableParticles" << endl;
+    settings << "  set OutputArray hits" << endl;
+    settings << "  set BeamLineFile " << beamLineName << endl;
+    settings << "  set Distance " << distance << endl;
+    settings << "  set SigmaE 0.79" << endl;
+    settings << "  set SigmaX 30.0" << endl;
+    settings << "  set SigmaY 30.0" << endl;
+    settings << "  set XiBins " << (i == 0 ? 250 : 0) << endl;
+    settings << "}" << endl;
+  }
+
+  return settings.str();
+}
+
+//---------------------------------------------------------------------------
+
+static void GenerateParticles(TRandom3 &random, Int_t number, DelphesCheck &check)
+{
+  Candidate *candidate;
+  Double_t xi, energy, p, tx, ty, u;
+  Int_t i;
+
+  for(i = 0; i < number; ++i)
+  {
+    // mostly protons, some antiprotons and neutrons
+    u = random.Uniform();
+    candidate = check.AddParticle(u < 0.8 ? 2212 : (u < 0.9 ? -2212 : 2112), 0.0, 0.0, 0.0);
+
+    xi = random.Uniform(0.0, 0.2);
+    energy = 7000.0*(1.0 - xi);
+    p = TMath::Sqrt(energy*energy - candidate->Mass*candidate->Mass);
+    tx = random.Gaus(0.0, 50.0E-6);
+    ty = random.Gaus(0.0, 50.0E-6);
+
+    candidate->Momentum.SetPxPyPzE(p*TMath::Sin(tx), p*TMath::Sin(ty), p*TMath::Sqrt(1.0 - TMath::Sin(tx)*TMath::Sin(tx) - TMath::Sin(ty)*TMath::Sin(ty)), energy);
+    candidate->Position.SetXYZT(random.Gaus(0.0, 0.015), random.Gaus(0.0, 0.015), random.Gaus(0.0, 50.0), 0.0);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "HectorTableCheck";
+  stringstream message;
+  DelphesCheck *check = 0;
+  TObjArray *stableParticleOutputArray = 0, *tableArray = 0, *exactArray = 0;
+  ExRootTask *tableTask, *exactTask;
+  Candidate *candidate, *exact;
+  map< Candidate *, Candidate * > exactHits;
+  map< Candidate *, Candidate * >::iterator itExactHits;
+  TRandom3 random(4357);
+  Long64_t particles, generated = 0, accepted = 0, mismatches = 0;
+  Double_t maxPosition = 0.0, maxAngle = 0.0, maxMismatches, positionLimit, angleLimit;
+  Int_t event;
+
+  const Int_t particlesPerEvent = 1000;
+
+  if(argc < 2 || argc > 7)
+  {
+    cout << " Usage: " << appName << " number_of_particles [beam_line_file] [distance] [max_mismatches] [max_position] [max_angle]" << endl;
+    cout << " number_of_particles - number of particles transported by both modules," << endl;
+    cout << " beam_line_file - beam line in tfs format (default cards/LHCB1IR5_7TeV.tfs)," << endl;
+    cout << " distance - distance of the detector from the interaction point in m (default 420)," << endl;
+    cout << " max_mismatches - largest fraction of particles with different acceptance (default 0.001)," << endl;
+    cout << " max_position - largest difference of the positions in um (default 1)," << endl;
+    cout << " max_angle - largest difference of the angles in urad (default 0.1)." << endl;
+    return 1;
+  }
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    particles = atol(argv[1]);
+    maxMismatches = argc > 4 ? atof(argv[4]) : 0.001;
+    positionLimit = argc > 5 ? atof(argv[5]) : 1.0;
+    angleLimit = argc > 6 ? atof(argv[6]) : 0.1;
+
+    if(particles <= 0)
+    {
+      throw runtime_error("number_of_particles must be positive");
+    }
+
+    // no output file, the modules are run directly
+    check = new DelphesCheck(0, GetSettings(argc > 2 ? argv[2] : "cards/LHCB1IR5_7TeV.tfs", argc > 3 ? atof(argv[3]) : 420.0).c_str());
+
+    stableParticleOutputArray = check->GetStableParticles();
+
+    check->Init();
+
+    tableTask = check->GetModule("HectorTable");
+    exactTask = check->GetModule("HectorExact");
+    tableArray = check->GetOutputArray("HectorTable/hits");
+    exactArray = check->GetOutputArray("HectorExact/hits");
+
+    for(event = 0; generated < particles; ++event)
+    {
+      GenerateParticles(random, TMath::Min(Long64_t(particlesPerEvent), particles - generated), *check);
+      generated += stableParticleOutputArray->GetEntriesFast();
+
+      gRandom->SetSeed(event + 1);
+      tableTask->ProcessTask();
+      gRandom->SetSeed(event + 1);
+      exactTask->ProcessTask();
+
+      // the hits lead to the transported particles
+      exactHits.clear();
+      TIter itExactArray(exactArray);
+      while((candidate = static_cast<Candidate *>(itExactArray.Next())))
+      {
+        exactHits[static_cast<Candidate *>(candidate->GetCandidates()->At(0))] = candidate;
+      }
+
+      accepted += exactHits.size();
+
+      TIter itTableArray(tableArray);
+      while((candidate = static_cast<Candidate *>(itTableArray.Next())))
+      {
+        itExactHits = exactHits.find(static_cast<Candidate *>(candidate->GetCandidates()->At(0)));
+        if(itExactHits == exactHits.end())
+        {
+          ++mismatches;
+          continue;
+        }
+
+        exact = itExactHits->second;
+        maxPosition = TMath::Max(maxPosition, TMath::Abs(candidate->Position.X() - exact->Position.X()));
+        maxPosition = TMath::Max(maxPosition, TMath::Abs(candidate->Position.Y() - exact->Position.Y()));
+        maxAngle = TMath::Max(maxAngle, TMath::Abs(candidate->Momentum.Px() - exact->Momentum.Px()));
+        maxAngle = TMath::Max(maxAngle, TMath::Abs(candidate->Momentum.Py() - exact->Momentum.Py()));
+        exactHits.erase(itExactHits);
+      }
+
+      // hits of the element by element transport only
+      mismatches += exactHits.size();
+
+      check->Clear();
+    }
+
+    check->Finish();
+
+    cout << "** " << generated << " particles, " << accepted << " accepted by the element by element transport" << endl;
+    cout << "** different acceptance: " << mismatches << " particles" << endl;
+    cout << "** largest difference of the positions: " << maxPosition << " um, of the angles: " << maxAngle << " urad" << endl;
+
+    delete check;
+
+    if(mismatches > maxMismatches*generated || maxPosition > positionLimit || maxAngle > angleLimit)
+    {
+      cout << "** Tabulated transfer matrices differ from the element by element transport" << endl;
+      return 1;
+    }
+
+    cout << "** Exiting..." << endl;
+
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
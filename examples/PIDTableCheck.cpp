@@ -0,0 +1,353 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+This program checks the PID tables of IdentificationMap against the lookup
+of the efficiency formulas they replace. For every IdentificationMap module
+of a configuration card, candidates with the PIDs of the card, their
+antiparticles and other PIDs, generated with a fixed seed, are identified
+by the module and by the former lookup (PID, then -PID, then 0 in the map
+of formulas), with gRandom set to the same seed before each of them.
+
+It exits with status 1 if a candidate is kept by one and not by the other
+or gets a different PID.
+
+Example:
+
+./PIDTableCheck 100000 cards/delphes_card_LHCb.tcl
+*/
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <map>
+#include <set>
+
+#include <stdlib.h>
+
+#include "TROOT.h"
+#include "TApplication.h"
+
+#include "TMath.h"
+#include "TRandom3.h"
+
+#include "classes/DelphesFormula.h"
+
+#include "examples/DelphesCheck.h"
+
+using namespace std;
+
+typedef multimap< Int_t, pair< Int_t, DelphesFormula * > > TMisIDMap;
+
+struct MapCheck
+{
+  TString name;
+  ExRootTask *task;
+  TObjArray *outputArray;
+  TMisIDMap efficiencyMap;
+  Long64_t mismatches;
+};
+
+//---------------------------------------------------------------------------
+
+// only the IdentificationMap modules run, on the generated candidates
+
+static string GetSettings(const vector< MapCheck > &checks)
+{
+  stringstream settings;
+  vector< MapCheck >::const_iterator itChecks;
+
+  settings << "set ExecutionPath {";
+  for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+  {
+    settings << " " << itChecks->name;
+  }
+  settings << " }" << endl;
+
+  for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+  {
+    settings << "set " << itChecks->name << "::InputArray Delphes/stableParticles" << endl;
+  }
+
+  return settings.str();
+}
+
+//---------------------------------------------------------------------------
+
+// map of formulas as read by IdentificationMap before the PID tables
+
+static void ReadMap(ExRootConfReader *confReader, MapCheck &mapCheck)
+{
+  ExRootConfParam param = confReader->GetParam(mapCheck.name + "::EfficiencyFormula");
+  DelphesFormula *formula;
+  Int_t i, size = param.GetSize();
+
+  for(i = 0; i < size/3; ++i)
+  {
+    formula = new DelphesFormula;
+    formula->Compile(param[i*3 + 2].GetString());
+    mapCheck.efficiencyMap.insert(make_pair(param[i*3].GetInt(), make_pair(param[i*3 + 1].GetInt(), formula)));
+  }
+
+  if(mapCheck.efficiencyMap.find(0) == mapCheck.efficiencyMap.end())
+  {
+    formula = new DelphesFormula;
+    formula->Compile("1.0");
+    mapCheck.efficiencyMap.insert(make_pair(0, make_pair(0, formula)));
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// PID of the candidate after identification by the former lookup,
+// kFALSE if the candidate is dropped
+
+static Bool_t Identify(TMisIDMap &efficiencyMap, Candidate *candidate, Int_t &pdgCode)
+{
+  pair< TMisIDMap::iterator, TMisIDMap::iterator > range;
+  TMisIDMap::iterator itRange;
+  Double_t pt, eta, phi, e, p, r, total;
+
+  eta = candidate->Position.Eta();
+  phi = candidate->Position.Phi();
+  pt = candidate->Momentum.Pt();
+  e = candidate->Momentum.E();
+
+  range = efficiencyMap.equal_range(candidate->PID);
+  if(range.first == range.second) range = efficiencyMap.equal_range(-candidate->PID);
+  if(range.first == range.second) range = efficiencyMap.equal_range(0);
+
+  r = gRandom->Uniform();
+  total = 0.0;
+
+  for(itRange = range.first; itRange != range.second; ++itRange)
+  {
+    p = (itRange->second).second->Eval(pt, eta, phi, e);
+
+    if(total <= r && r < total + p)
+    {
+      pdgCode = ((itRange->second).first != 0) ? candidate->Charge*(itRange->second).first : candidate->PID;
+      return kTRUE;
+    }
+
+    total += p;
+  }
+
+  return kFALSE;
+}
+
+//---------------------------------------------------------------------------
+
+static void GenerateCandidates(TRandom3 &random, Int_t number, const vector< Int_t > &pdgCodes, DelphesCheck &check)
+{
+  Candidate *candidate;
+  Double_t pt, eta, phi;
+  Int_t i, pdgCode;
+
+  for(i = 0; i < number; ++i)
+  {
+    pdgCode = pdgCodes[random.Integer(pdgCodes.size())];
+    pt = random.Exp(5.0);
+    eta = random.Uniform(-6.0, 6.0);
+    phi = random.Uniform(-TMath::Pi(), TMath::Pi());
+
+    // the module reads eta and phi of the position
+    candidate = check.AddParticle(pdgCode, pt, eta, phi);
+    candidate->Position.SetPtEtaPhiE(1.0, eta, phi, 0.0);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "PIDTableCheck";
+  stringstream message;
+  const char *configName;
+  DelphesCheck *check = 0;
+  ExRootConfReader *confReader = 0;
+  TObjArray *stableParticleOutputArray = 0;
+  vector< MapCheck > checks;
+  vector< MapCheck >::iterator itChecks;
+  MapCheck mapCheck;
+  TMisIDMap::iterator itEfficiencyMap;
+  set< Int_t > pdgCodeSet;
+  vector< Int_t > pdgCodes, inputCodes, expectedCodes;
+  vector< Candidate * > expected;
+  Candidate *candidate;
+  TRandom3 random(4357);
+  Long64_t candidates, generated = 0, mismatches = 0;
+  Int_t event, i, pdgCode;
+
+  const Int_t candidatesPerEvent = 1000;
+  const Int_t otherCodes[] = {11, 13, 22, 211, 321, 2212, 130, 2112, 15, 999};
+
+  if(argc < 2 || argc > 3)
+  {
+    cout << " Usage: " << appName << " number_of_candidates [config_file]" << endl;
+    cout << " number_of_candidates - number of candidates identified by each module," << endl;
+    cout << " config_file - configuration file in Tcl format (default cards/delphes_card_LHCb.tcl)." << endl;
+    return 1;
+  }
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    candidates = atol(argv[1]);
+    configName = argc > 2 ? argv[2] : "cards/delphes_card_LHCb.tcl";
+
+    if(candidates <= 0)
+    {
+      throw runtime_error("number_of_candidates must be positive");
+    }
+
+    // no output file, the modules are run directly
+    check = new DelphesCheck(configName);
+    confReader = check->GetConfReader();
+
+    const ExRootConfReader::ExRootTaskMap *modules = confReader->GetModules();
+    ExRootConfReader::ExRootTaskMap::const_iterator itModules;
+
+    for(itModules = modules->begin(); itModules != modules->end(); ++itModules)
+    {
+      if(itModules->second != "IdentificationMap") continue;
+      mapCheck.name = itModules->first;
+      mapCheck.mismatches = 0;
+      checks.push_back(mapCheck);
+      ReadMap(confReader, checks.back());
+    }
+
+    if(checks.empty())
+    {
+      message << "no IdentificationMap module in " << configName;
+      throw runtime_error(message.str());
+    }
+
+    DelphesCheck::ReadSettings(confReader, GetSettings(checks).c_str());
+
+    // PIDs of the maps, their antiparticles and PIDs missing from the maps
+    for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+    {
+      for(itEfficiencyMap = itChecks->efficiencyMap.begin(); itEfficiencyMap != itChecks->efficiencyMap.end(); ++itEfficiencyMap)
+      {
+        pdgCodeSet.insert(itEfficiencyMap->first);
+        pdgCodeSet.insert(-itEfficiencyMap->first);
+      }
+    }
+    for(i = 0; i < Int_t(sizeof(otherCodes)/sizeof(otherCodes[0])); ++i)
+    {
+      pdgCodeSet.insert(otherCodes[i]);
+      pdgCodeSet.insert(-otherCodes[i]);
+    }
+    pdgCodeSet.erase(0);
+    pdgCodes.assign(pdgCodeSet.begin(), pdgCodeSet.end());
+
+    stableParticleOutputArray = check->GetStableParticles();
+
+    check->Init();
+
+    for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+    {
+      itChecks->task = check->GetModule(itChecks->name);
+      itChecks->outputArray = check->GetOutputArray(itChecks->name + "/" + confReader->GetString(itChecks->name + "::OutputArray", "stableParticles"));
+    }
+
+    for(event = 0; generated < candidates; ++event)
+    {
+      GenerateCandidates(random, TMath::Min(Long64_t(candidatesPerEvent), candidates - generated), pdgCodes, *check);
+      generated += stableParticleOutputArray->GetEntriesFast();
+
+      // the modules change the PID of their input candidates
+      inputCodes.clear();
+      TIter itInputArray(stableParticleOutputArray);
+      while((candidate = static_cast<Candidate *>(itInputArray.Next()))) inputCodes.push_back(candidate->PID);
+
+      for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+      {
+        expected.clear();
+        expectedCodes.clear();
+
+        gRandom->SetSeed(event + 1);
+        itInputArray.Reset();
+        for(i = 0; (candidate = static_cast<Candidate *>(itInputArray.Next())); ++i)
+        {
+          candidate->PID = inputCodes[i];
+          if(!Identify(itChecks->efficiencyMap, candidate, pdgCode)) continue;
+          expected.push_back(candidate);
+          expectedCodes.push_back(pdgCode);
+        }
+
+        gRandom->SetSeed(event + 1);
+        itChecks->task->ProcessTask();
+
+        if(itChecks->outputArray->GetEntriesFast() != Int_t(expected.size()))
+        {
+          ++itChecks->mismatches;
+          continue;
+        }
+
+        for(i = 0; i < Int_t(expected.size()); ++i)
+        {
+          candidate = static_cast<Candidate *>(itChecks->outputArray->At(i));
+          if(candidate != expected[i] || candidate->PID != expectedCodes[i]) ++itChecks->mismatches;
+        }
+      }
+
+      check->Clear();
+    }
+
+    check->Finish();
+
+    cout << "** " << generated << " candidates identified by each module" << endl;
+    for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+    {
+      cout << "** " << itChecks->name << ": " << itChecks->mismatches << " differences" << endl;
+      mismatches += itChecks->mismatches;
+
+      for(itEfficiencyMap = itChecks->efficiencyMap.begin(); itEfficiencyMap != itChecks->efficiencyMap.end(); ++itEfficiencyMap)
+      {
+        delete (itEfficiencyMap->second).second;
+      }
+    }
+
+    delete check;
+
+    if(mismatches > 0)
+    {
+      cout << "** PID tables differ from the lookup of the efficiency formulas" << endl;
+      return 1;
+    }
+
+    cout << "** Exiting..." << endl;
+
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,350 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+This program checks the tabulated resolution formulas against the formulas
+they replace. Every Calorimeter, SimpleCalorimeter, MomentumSmearing and
+EnergySmearing module of the configuration cards runs next to a copy of
+itself with TabulateResolution set to false, which always evaluates the
+formulas. Both get the same particles, and tracks for the calorimeters,
+generated with a fixed seed, with gRandom set to the same seed before each
+of them so that both draw the same smearing.
+
+It exits with status 1 if the output arrays of a module and of its copy
+have different sizes or if the relative difference of the energy or the
+transverse momentum of their candidates exceeds the given limit.
+
+Example:
+
+./ResolutionTableCheck 100000 1e-6 cards/delphes_card_CMS.tcl cards/CMS_PhaseII/CMS_PhaseII_0PU.tcl
+*/
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+
+#include "TROOT.h"
+#include "TApplication.h"
+
+#include "TMath.h"
+#include "TRandom3.h"
+
+#include "examples/DelphesCheck.h"
+
+using namespace std;
+
+struct ModuleCheck
+{
+  TString name, className;
+  ExRootTask *tableTask, *formulaTask;
+  vector< pair< TObjArray *, TObjArray * > > arrays;
+  Double_t difference;
+  Long64_t mismatches;
+};
+
+//---------------------------------------------------------------------------
+
+// output arrays of the modules and their default names
+
+static void GetOutputArrays(const TString &className, vector< pair< TString, TString > > &outputArrays)
+{
+  outputArrays.clear();
+  if(className == "Calorimeter")
+  {
+    outputArrays.push_back(make_pair("TowerOutputArray", "towers"));
+    outputArrays.push_back(make_pair("PhotonOutputArray", "photons"));
+    outputArrays.push_back(make_pair("EFlowTrackOutputArray", "eflowTracks"));
+    outputArrays.push_back(make_pair("EFlowPhotonOutputArray", "eflowPhotons"));
+    outputArrays.push_back(make_pair("EFlowNeutralHadronOutputArray", "eflowNeutralHadrons"));
+  }
+  else if(className == "SimpleCalorimeter")
+  {
+    outputArrays.push_back(make_pair("TowerOutputArray", "towers"));
+    outputArrays.push_back(make_pair("EFlowTrackOutputArray", "eflowTracks"));
+    outputArrays.push_back(make_pair("EFlowTowerOutputArray", "eflowTowers"));
+  }
+  else if(className == "MomentumSmearing" || className == "EnergySmearing")
+  {
+    outputArrays.push_back(make_pair("OutputArray", "stableParticles"));
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// only the checked modules and their copies run, on the generated particles
+
+static string GetSettings(const vector< ModuleCheck > &checks)
+{
+  stringstream settings;
+  vector< ModuleCheck >::const_iterator itChecks;
+
+  settings << "set ExecutionPath {";
+  for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+  {
+    settings << " " << itChecks->name << " " << itChecks->name << "Formula";
+  }
+  settings << " }" << endl;
+
+  for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+  {
+    if(itChecks->className.EndsWith("Calorimeter"))
+    {
+      settings << "set ::" << itChecks->name << "::ParticleInputArray Delphes/stableParticles" << endl;
+      settings << "set ::" << itChecks->name << "::TrackInputArray Delphes/tracks" << endl;
+    }
+    else
+    {
+      settings << "set ::" << itChecks->name << "::InputArray Delphes/stableParticles" << endl;
+    }
+
+    settings << "module " << itChecks->className << " " << itChecks->name << "Formula {}" << endl;
+    settings << "foreach name [info vars ::" << itChecks->name << "::*] {" << endl;
+    settings << "  if {![array exists $name]} {set ::" << itChecks->name << "Formula::[namespace tail $name] [set $name]}" << endl;
+    settings << "}" << endl;
+    settings << "set ::" << itChecks->name << "Formula::TabulateResolution false" << endl;
+  }
+
+  return settings.str();
+}
+
+//---------------------------------------------------------------------------
+
+static void GenerateParticles(TRandom3 &random, Int_t number, DelphesCheck &check, TObjArray *trackOutputArray)
+{
+  Candidate *candidate;
+  Double_t pt, eta, phi;
+  Int_t i;
+
+  const Int_t pdgCodes[] = {11, -11, 13, -13, 22, 211, -211, 321, -321, 2212, -2212, 130, 310, 2112, -2112, 12};
+
+  for(i = 0; i < number; ++i)
+  {
+    pt = TMath::Power(10.0, random.Uniform(-1.0, 3.0));
+    eta = random.Uniform(-6.0, 6.0);
+    phi = random.Uniform(-TMath::Pi(), TMath::Pi());
+
+    // the modules read eta and phi of the position
+    candidate = check.AddParticle(pdgCodes[random.Integer(sizeof(pdgCodes)/sizeof(pdgCodes[0]))], pt, eta, phi);
+    candidate->Position.SetPtEtaPhiE(1.0, eta, phi, 0.0);
+
+    // charged particles also reach the calorimeters as tracks
+    if(candidate->Charge == 0) continue;
+    candidate->TrackResolution = 0.01;
+    trackOutputArray->Add(candidate);
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static Double_t Difference(Double_t table, Double_t formula)
+{
+  if(table == formula || (table != table && formula != formula)) return 0.0;
+  return TMath::Abs(table - formula)/TMath::Max(TMath::Abs(formula), 1.0E-300);
+}
+
+//---------------------------------------------------------------------------
+
+static void CompareArrays(TObjArray *tableArray, TObjArray *formulaArray, ModuleCheck &moduleCheck)
+{
+  Candidate *table, *formula;
+  Int_t i;
+
+  if(tableArray->GetEntriesFast() != formulaArray->GetEntriesFast())
+  {
+    ++moduleCheck.mismatches;
+    return;
+  }
+
+  for(i = 0; i < tableArray->GetEntriesFast(); ++i)
+  {
+    table = static_cast<Candidate *>(tableArray->At(i));
+    formula = static_cast<Candidate *>(formulaArray->At(i));
+    moduleCheck.difference = TMath::Max(moduleCheck.difference, Difference(table->Momentum.E(), formula->Momentum.E()));
+    moduleCheck.difference = TMath::Max(moduleCheck.difference, Difference(table->Momentum.Pt(), formula->Momentum.Pt()));
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// runs the modules of a card and their copies, returns the number of failures
+
+static Int_t CheckCard(const char *configName, Long64_t particles, Double_t limit)
+{
+  stringstream message;
+  DelphesCheck *check = 0;
+  ExRootConfReader *confReader = 0;
+  TObjArray *stableParticleOutputArray = 0, *trackOutputArray = 0;
+  vector< ModuleCheck > checks;
+  vector< ModuleCheck >::iterator itChecks;
+  ModuleCheck moduleCheck;
+  vector< pair< TString, TString > > outputArrays;
+  vector< pair< TString, TString > >::iterator itOutputArrays;
+  vector< pair< TObjArray *, TObjArray * > >::iterator itArrays;
+  TString arrayName;
+  TRandom3 random(4357);
+  Long64_t generated = 0;
+  Int_t event, failures = 0;
+
+  const Int_t particlesPerEvent = 1000;
+
+  // no output file, the modules are run directly
+  check = new DelphesCheck(configName);
+  confReader = check->GetConfReader();
+
+  const ExRootConfReader::ExRootTaskMap *modules = confReader->GetModules();
+  ExRootConfReader::ExRootTaskMap::const_iterator itModules;
+
+  for(itModules = modules->begin(); itModules != modules->end(); ++itModules)
+  {
+    moduleCheck.className = itModules->second;
+    if(moduleCheck.className != "Calorimeter" && moduleCheck.className != "SimpleCalorimeter"
+      && moduleCheck.className != "MomentumSmearing" && moduleCheck.className != "EnergySmearing") continue;
+    moduleCheck.name = itModules->first;
+    moduleCheck.difference = 0.0;
+    moduleCheck.mismatches = 0;
+    checks.push_back(moduleCheck);
+  }
+
+  if(checks.empty())
+  {
+    message << "no module with resolution formulas in " << configName;
+    throw runtime_error(message.str());
+  }
+
+  DelphesCheck::ReadSettings(confReader, GetSettings(checks).c_str());
+
+  stableParticleOutputArray = check->GetStableParticles();
+  trackOutputArray = check->ExportArray("tracks");
+
+  check->Init();
+
+  for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+  {
+    itChecks->tableTask = check->GetModule(itChecks->name);
+    itChecks->formulaTask = check->GetModule(itChecks->name + "Formula");
+
+    GetOutputArrays(itChecks->className, outputArrays);
+    for(itOutputArrays = outputArrays.begin(); itOutputArrays != outputArrays.end(); ++itOutputArrays)
+    {
+      arrayName = confReader->GetString(itChecks->name + "::" + itOutputArrays->first, itOutputArrays->second);
+      itChecks->arrays.push_back(make_pair(check->GetOutputArray(itChecks->name + "/" + arrayName),
+        check->GetOutputArray(itChecks->name + "Formula/" + arrayName)));
+    }
+  }
+
+  for(event = 0; generated < particles; ++event)
+  {
+    GenerateParticles(random, TMath::Min(Long64_t(particlesPerEvent), particles - generated), *check, trackOutputArray);
+    generated += stableParticleOutputArray->GetEntriesFast();
+
+    for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+    {
+      gRandom->SetSeed(event + 1);
+      itChecks->tableTask->ProcessTask();
+      gRandom->SetSeed(event + 1);
+      itChecks->formulaTask->ProcessTask();
+
+      for(itArrays = itChecks->arrays.begin(); itArrays != itChecks->arrays.end(); ++itArrays)
+      {
+        CompareArrays(itArrays->first, itArrays->second, *itChecks);
+      }
+    }
+
+    check->Clear();
+  }
+
+  check->Finish();
+
+  cout << "** " << configName << ": " << generated << " particles" << endl;
+  for(itChecks = checks.begin(); itChecks != checks.end(); ++itChecks)
+  {
+    cout << "** " << itChecks->name << ": largest relative difference " << itChecks->difference;
+    cout << ", " << itChecks->mismatches << " arrays of different sizes" << endl;
+    if(itChecks->difference > limit || itChecks->mismatches > 0) ++failures;
+  }
+
+  delete check;
+
+  return failures;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "ResolutionTableCheck";
+  vector< const char * > configNames;
+  vector< const char * >::iterator itConfigNames;
+  Long64_t particles;
+  Double_t limit;
+  Int_t i, failures = 0;
+
+  if(argc < 3)
+  {
+    cout << " Usage: " << appName << " number_of_particles" << " max_difference" << " [config_file ...]" << endl;
+    cout << " number_of_particles - number of particles processed by each module," << endl;
+    cout << " max_difference - largest relative difference between the outputs with and without the tables," << endl;
+    cout << " config_file - configuration files in Tcl format (default cards/delphes_card_CMS.tcl)." << endl;
+    return 1;
+  }
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    particles = atol(argv[1]);
+    limit = atof(argv[2]);
+
+    if(particles <= 0)
+    {
+      throw runtime_error("number_of_particles must be positive");
+    }
+
+    for(i = 3; i < argc; ++i) configNames.push_back(argv[i]);
+    if(configNames.empty()) configNames.push_back("cards/delphes_card_CMS.tcl");
+
+    for(itConfigNames = configNames.begin(); itConfigNames != configNames.end(); ++itConfigNames)
+    {
+      failures += CheckCard(*itConfigNames, particles, limit);
+    }
+
+    if(failures > 0)
+    {
+      cout << "** " << failures << " modules differ from the resolution formulas by more than " << limit << endl;
+      return 1;
+    }
+
+    cout << "** Exiting..." << endl;
+
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,476 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+This program checks that the modules give the same output with several
+threads as with one thread. For each configuration card, it processes the
+same events twice, with ::NumberOfThreads 1 and with number_of_threads, and
+compares the two output files entry by entry. Every run is done in its own
+process forked from the program, so that both runs start from the same state
+of the random generators, and ::RandomSeed is set to 1.
+
+All numeric leaves are compared except the fUniqueID and fBits of TObject,
+the unique identifiers of the candidates depend on the order in which the
+threads create them. The events are read from a HepMC file or, with gun as
+input file, generated with a fixed seed, and the output files are written to
+the temporary directory.
+
+The first card is also run with two SISCone jet finders added before the
+TreeWriter. The SISCone plugin keeps static state, so the two finders must
+never run at the same time, whatever the number of threads.
+
+Build with 'cmake -DENABLE_TSAN=ON' to run the threads under ThreadSanitizer,
+ROOT is then best built with -fsanitize=thread as well.
+
+Example:
+
+./ThreadStress z_ee.hepmc 10000 8 cards/delphes_card_CMS.tcl cards/CMS_PhaseII/CMS_PhaseII_0PU.tcl
+./ThreadStress gun 200 4
+*/
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "TROOT.h"
+#include "TApplication.h"
+
+#include "TMath.h"
+#include "TVector2.h"
+#include "TRandom3.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TLeaf.h"
+#include "TBranch.h"
+#include "TSystem.h"
+
+#include "classes/DelphesWorkers.h"
+#include "classes/DelphesHepMCReader.h"
+
+#include "examples/DelphesCheck.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+static string GetSettings(Int_t threads, Bool_t siscone)
+{
+  stringstream settings;
+  Int_t i;
+
+  settings << "set NumberOfThreads " << threads << endl;
+  settings << "set RandomSeed 1" << endl;
+
+  if(siscone)
+  {
+    for(i = 1; i <= 2; ++i)
+    {
+      settings << "module FastJetFinder SISConeFinder" << i << " {" << endl;
+      settings << "  set InputArray Delphes/stableParticles" << endl;
+      settings << "  set OutputArray jets" << endl;
+      settings << "  set JetAlgorithm 3" << endl;
+      settings << "  set ConeRadius " << 0.4*i << endl;
+      settings << "  set JetPTMin 10.0" << endl;
+      settings << "}" << endl;
+      settings << "add TreeWriter::Branch SISConeFinder" << i << "/jets SISConeJet" << i << " Jet" << endl;
+    }
+    settings << "set ExecutionPath [linsert $ExecutionPath [lsearch $ExecutionPath TreeWriter] SISConeFinder1 SISConeFinder2]" << endl;
+  }
+
+  return settings.str();
+}
+
+//---------------------------------------------------------------------------
+
+static Bool_t ReadEvent(FILE *inputFile, DelphesHepMCReader *reader, DelphesCheck &check)
+{
+  Bool_t rewound = kFALSE;
+
+  while(kTRUE)
+  {
+    if(reader->ReadBlock(check.GetFactory(), check.GetAllParticles(), check.GetStableParticles(), check.GetPartons()))
+    {
+      if(reader->EventReady()) return kTRUE;
+    }
+    else
+    {
+      // start again from the first event when the input file is exhausted
+      if(rewound) return kFALSE;
+      rewound = kTRUE;
+      fseek(inputFile, 0L, SEEK_SET);
+      reader->Clear();
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+// particle gun: a lepton pair and two to four sprays of hadrons and photons
+// from the origin
+
+static void GenerateEvent(TRandom3 &random, DelphesCheck &check)
+{
+  Double_t eta, phi;
+  Int_t i, j, jets, lepton;
+
+  const Int_t pdgCodes[] = {211, -211, 211, -211, 321, -321, 22, 22, 130, 2112, -2112, 2212};
+
+  lepton = random.Uniform() < 0.5 ? 11 : 13;
+  check.AddParticle(lepton, 20.0 + random.Exp(20.0), random.Uniform(-2.5, 2.5), random.Uniform(-TMath::Pi(), TMath::Pi()));
+  check.AddParticle(-lepton, 20.0 + random.Exp(20.0), random.Uniform(-2.5, 2.5), random.Uniform(-TMath::Pi(), TMath::Pi()));
+
+  jets = 2 + random.Integer(3);
+  for(i = 0; i < jets; ++i)
+  {
+    eta = random.Uniform(-3.0, 3.0);
+    phi = random.Uniform(-TMath::Pi(), TMath::Pi());
+    for(j = 0; j < 20; ++j)
+    {
+      check.AddParticle(pdgCodes[random.Integer(sizeof(pdgCodes)/sizeof(pdgCodes[0]))], 0.5 + random.Exp(5.0),
+        eta + random.Gaus(0.0, 0.1), TVector2::Phi_mpi_pi(phi + random.Gaus(0.0, 0.1)));
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static void Run(const char *configName, Bool_t siscone, const char *inputName, Long64_t numberOfEvents,
+  Int_t threads, const char *outputName)
+{
+  stringstream message;
+  FILE *inputFile = 0;
+  TFile *outputFile;
+  DelphesCheck *check;
+  DelphesHepMCReader *reader = 0;
+  TRandom3 random(4357);
+  Long64_t event;
+
+  if(strcmp(inputName, "gun") != 0)
+  {
+    inputFile = fopen(inputName, "r");
+    if(inputFile == NULL)
+    {
+      message << "can't open " << inputName;
+      throw runtime_error(message.str());
+    }
+
+    reader = new DelphesHepMCReader;
+    reader->SetInputFile(inputFile);
+  }
+
+  outputFile = TFile::Open(outputName, "RECREATE");
+  if(outputFile == NULL)
+  {
+    message << "can't create output file " << outputName;
+    throw runtime_error(message.str());
+  }
+
+  check = new DelphesCheck(configName, GetSettings(threads, siscone).c_str(), outputFile);
+
+  check->Init();
+  if(reader) reader->Clear();
+
+  for(event = 0; event < numberOfEvents; ++event)
+  {
+    if(!reader)
+    {
+      GenerateEvent(random, *check);
+    }
+    else if(!ReadEvent(inputFile, reader, *check))
+    {
+      message << "no events in " << inputName;
+      throw runtime_error(message.str());
+    }
+
+    check->Process();
+
+    check->Clear();
+    if(reader) reader->Clear();
+  }
+
+  check->Finish();
+
+  delete reader;
+  delete check;
+  delete outputFile;
+
+  if(inputFile) fclose(inputFile);
+}
+
+//---------------------------------------------------------------------------
+
+// runs the card in a child process, the state of the program is the same
+// for all runs, including the static random generators of the externals
+static void Fork(const char *configName, Bool_t siscone, const char *inputName, Long64_t numberOfEvents,
+  Int_t threads, const char *outputName)
+{
+  stringstream message;
+  pid_t pid;
+  int status;
+
+  cout.flush();
+  fflush(0);
+
+  pid = fork();
+
+  if(pid == 0)
+  {
+    try
+    {
+      Run(configName, siscone, inputName, numberOfEvents, threads, outputName);
+    }
+    catch(runtime_error &e)
+    {
+      cerr << "** ERROR: " << e.what() << endl;
+      DelphesWorkers::Exit(1);
+    }
+    DelphesWorkers::Exit(0);
+  }
+
+  if(pid < 0)
+  {
+    message << "can't fork process: " << strerror(errno);
+    throw runtime_error(message.str());
+  }
+
+  while(waitpid(pid, &status, 0) < 0 && errno == EINTR) continue;
+
+  if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+  {
+    message << "run of " << configName << " with " << threads << " threads failed";
+    throw runtime_error(message.str());
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static Bool_t IsCompared(TLeaf *leaf)
+{
+  static const char *types[] = {"Bool_t", "Char_t", "UChar_t", "Short_t", "UShort_t",
+    "Int_t", "UInt_t", "Long_t", "ULong_t", "Long64_t", "ULong64_t", "Float_t", "Double_t"};
+  TString name(leaf->GetName());
+  UInt_t i;
+
+  if(name.EndsWith("fUniqueID") || name.EndsWith("fBits")) return kFALSE;
+
+  for(i = 0; i < sizeof(types)/sizeof(types[0]); ++i)
+  {
+    if(strcmp(leaf->GetTypeName(), types[i]) == 0) return kTRUE;
+  }
+
+  return kFALSE;
+}
+
+//---------------------------------------------------------------------------
+
+// returns the number of leaves that differ in at least one entry
+static Long64_t Compare(const char *referenceName, const char *outputName)
+{
+  stringstream message;
+  TFile *referenceFile, *outputFile;
+  TTree *referenceTree = 0, *outputTree = 0;
+  TBranch *outputBranch;
+  TLeaf *referenceLeaf, *outputLeaf;
+  vector< pair< TLeaf *, TLeaf * > > leaves;
+  vector< Bool_t > differs;
+  Long64_t entry, entries, differences = 0;
+  Int_t i, j, length;
+  Double_t referenceValue, outputValue;
+
+  referenceFile = TFile::Open(referenceName);
+  outputFile = TFile::Open(outputName);
+
+  if(referenceFile) referenceFile->GetObject("Delphes", referenceTree);
+  if(outputFile) outputFile->GetObject("Delphes", outputTree);
+
+  if(!referenceTree || !outputTree)
+  {
+    message << "can't read Delphes tree of " << referenceName << " or " << outputName;
+    throw runtime_error(message.str());
+  }
+
+  entries = referenceTree->GetEntries();
+  if(outputTree->GetEntries() != entries)
+  {
+    cout << "** " << outputName << ": " << outputTree->GetEntries() << " entries instead of " << entries << endl;
+    ++differences;
+    if(outputTree->GetEntries() < entries) entries = outputTree->GetEntries();
+  }
+
+  TIter itTreeLeaves(referenceTree->GetListOfLeaves());
+  while((referenceLeaf = static_cast<TLeaf *>(itTreeLeaves.Next())))
+  {
+    if(!IsCompared(referenceLeaf)) continue;
+
+    outputBranch = outputTree->GetBranch(referenceLeaf->GetBranch()->GetName());
+    outputLeaf = outputBranch ? outputBranch->GetLeaf(referenceLeaf->GetName()) : 0;
+    if(!outputLeaf)
+    {
+      cout << "** " << outputName << ": no leaf " << referenceLeaf->GetName() << endl;
+      ++differences;
+      continue;
+    }
+
+    leaves.push_back(make_pair(referenceLeaf, outputLeaf));
+  }
+
+  differs.assign(leaves.size(), kFALSE);
+
+  for(entry = 0; entry < entries; ++entry)
+  {
+    referenceTree->GetEntry(entry);
+    outputTree->GetEntry(entry);
+
+    for(j = 0; j < Int_t(leaves.size()); ++j)
+    {
+      if(differs[j]) continue;
+
+      referenceLeaf = leaves[j].first;
+      outputLeaf = leaves[j].second;
+
+      length = referenceLeaf->GetLen();
+      if(outputLeaf->GetLen() != length)
+      {
+        cout << "** entry " << entry << ", " << referenceLeaf->GetBranch()->GetName();
+        cout << ": " << outputLeaf->GetLen() << " values instead of " << length << endl;
+        differs[j] = kTRUE;
+        continue;
+      }
+
+      for(i = 0; i < length; ++i)
+      {
+        referenceValue = referenceLeaf->GetValue(i);
+        outputValue = outputLeaf->GetValue(i);
+
+        // NaN values are equal
+        if(referenceValue == outputValue || (referenceValue != referenceValue && outputValue != outputValue)) continue;
+
+        cout << "** entry " << entry << ", " << referenceLeaf->GetBranch()->GetName() << "[" << i << "]";
+        cout << ": " << outputValue << " instead of " << referenceValue << endl;
+        differs[j] = kTRUE;
+        break;
+      }
+    }
+  }
+
+  for(j = 0; j < Int_t(differs.size()); ++j)
+  {
+    if(differs[j]) ++differences;
+  }
+
+  cout << "** " << entries << " entries and " << leaves.size() << " leaves compared, ";
+  cout << differences << " differences" << endl;
+
+  delete referenceFile;
+  delete outputFile;
+
+  return differences;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "ThreadStress";
+  stringstream message;
+  vector< pair< const char *, Bool_t > > runs;
+  vector< pair< const char *, Bool_t > >::iterator itRuns;
+  TString referenceName, outputName;
+  Long64_t numberOfEvents, differences = 0;
+  Int_t i, threads;
+
+  if(argc < 4)
+  {
+    cout << " Usage: " << appName << " input_file" << " number_of_events" << " number_of_threads" << " [config_file ...]" << endl;
+    cout << " input_file - input file in HepMC format, read again from the start when exhausted," << endl;
+    cout << " or gun for particles generated with a fixed seed," << endl;
+    cout << " number_of_events - number of events processed by each run," << endl;
+    cout << " number_of_threads - number of threads compared with one thread," << endl;
+    cout << " config_file - configuration files in Tcl format," << endl;
+    cout << " cards/delphes_card_CMS.tcl and cards/CMS_PhaseII/CMS_PhaseII_0PU.tcl by default." << endl;
+    return 1;
+  }
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    numberOfEvents = atol(argv[2]);
+    threads = atoi(argv[3]);
+
+    if(numberOfEvents <= 0)
+    {
+      throw runtime_error("number_of_events must be positive");
+    }
+
+    if(threads < 2)
+    {
+      throw runtime_error("number_of_threads must be at least 2");
+    }
+
+    for(i = 4; i < argc; ++i) runs.push_back(make_pair(argv[i], kFALSE));
+    if(runs.empty())
+    {
+      runs.push_back(make_pair("cards/delphes_card_CMS.tcl", kFALSE));
+      runs.push_back(make_pair("cards/CMS_PhaseII/CMS_PhaseII_0PU.tcl", kFALSE));
+    }
+    runs.push_back(make_pair(runs.front().first, kTRUE));
+
+    for(itRuns = runs.begin(); itRuns != runs.end(); ++itRuns)
+    {
+      referenceName.Form("%s/ThreadStress_%d_%d_1.root", gSystem->TempDirectory(), gSystem->GetPid(), Int_t(itRuns - runs.begin()));
+      outputName.Form("%s/ThreadStress_%d_%d_%d.root", gSystem->TempDirectory(), gSystem->GetPid(), Int_t(itRuns - runs.begin()), threads);
+
+      cout << "** Processing " << numberOfEvents << " events of " << argv[1] << " with " << itRuns->first;
+      cout << (itRuns->second ? " and two SISCone jet finders" : "") << endl;
+
+      Fork(itRuns->first, itRuns->second, argv[1], numberOfEvents, 1, referenceName);
+      Fork(itRuns->first, itRuns->second, argv[1], numberOfEvents, threads, outputName);
+
+      cout << "** Comparing " << threads << " threads with 1 thread" << endl;
+
+      differences += Compare(referenceName, outputName);
+
+      gSystem->Unlink(referenceName);
+      gSystem->Unlink(outputName);
+    }
+
+    cout << "** Exiting..." << endl;
+
+    return differences > 0 ? 1 : 0;
+  }
+  catch(runtime_error &e)
+  {
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,508 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+This program runs every vertex finder (VertexFinder, VertexFinderDA4D) of a
+configuration card for a sweep of mean pile-up values and compares
+reconstructed vertices with the generated vertices of PileUpMerger.
+
+A reconstructed vertex is matched to the generated vertex that contributes
+more than half of its tracks, otherwise it is counted as fake.
+A generated vertex with at least two tracks in the input of the vertex finder
+is reconstructable, it is found if at least one reconstructed vertex is matched to it.
+
+The memory column is the largest increase of the resident memory of the process
+during one call of the vertex finder, measured before and after each call.
+
+Example:
+
+./VertexBenchmark cards/CMS_PhaseII/testVertexing.tcl - 100 0 50 140 200 1000
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <map>
+#include <set>
+
+#include <stdlib.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "TROOT.h"
+#include "TApplication.h"
+
+#include "TClass.h"
+#include "TSystem.h"
+#include "TObjArray.h"
+#include "TStopwatch.h"
+
+#include "modules/Delphes.h"
+#include "classes/DelphesClasses.h"
+#include "classes/DelphesFactory.h"
+#include "classes/DelphesHepMCReader.h"
+
+#include "ExRootAnalysis/ExRootConfReader.h"
+#include "ExRootAnalysis/ExRootTreeWriter.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+struct VertexerScore
+{
+  TString name;
+  ExRootTask *task;
+  TObjArray *inputArray;
+  TObjArray *vertexArray;
+
+  TStopwatch stopWatch;
+
+  // largest increase of the resident memory during one call, kB
+  Long_t memoryIncrease;
+
+  Long64_t trueVertices;
+  Long64_t recoVertices;
+  Long64_t foundVertices;
+  Long64_t fakeVertices;
+};
+
+struct BenchmarkRow
+{
+  Double_t mu;
+  TString name;
+  Double_t time;
+  Double_t memory;
+  Double_t trueVertices;
+  Double_t recoVertices;
+  Double_t efficiency;
+  Double_t fakeRate;
+};
+
+//---------------------------------------------------------------------------
+
+static bool interrupted = false;
+
+void SignalHandler(int sig)
+{
+  interrupted = true;
+}
+
+//---------------------------------------------------------------------------
+
+static Bool_t IsVertexer(const TString &className)
+{
+  return className == "VertexFinder" || className == "VertexFinderDA4D";
+}
+
+//---------------------------------------------------------------------------
+
+static Candidate *GetGenParticle(Candidate *candidate)
+{
+  // the first constituent of a cloned candidate always leads to its mother
+  TObjArray *array = candidate->GetCandidates();
+  while(array->GetEntriesFast() > 0)
+  {
+    candidate = static_cast<Candidate *>(array->At(0));
+    array = candidate->GetCandidates();
+  }
+  return candidate;
+}
+
+//---------------------------------------------------------------------------
+
+static void ScoreVertexer(VertexerScore &score, const map<Candidate *, Int_t> &genVertexMap)
+{
+  map<Candidate *, Int_t>::const_iterator itGenVertexMap;
+  map<Int_t, Int_t> genTracks;
+  map<Int_t, map<Int_t, Int_t> > recoTracks;
+  map<Int_t, Int_t>::iterator itTracks;
+  map<Int_t, map<Int_t, Int_t> >::iterator itRecoTracks;
+  set<Int_t> foundVertices;
+  Candidate *candidate;
+  Int_t genIndex, bestIndex, bestCount, sumCount;
+
+  TIter itInputArray(score.inputArray);
+  while((candidate = static_cast<Candidate *>(itInputArray.Next())))
+  {
+    itGenVertexMap = genVertexMap.find(GetGenParticle(candidate));
+    genIndex = (itGenVertexMap != genVertexMap.end()) ? itGenVertexMap->second : -1;
+
+    if(genIndex >= 0) ++genTracks[genIndex];
+    if(candidate->ClusterIndex >= 0) ++recoTracks[candidate->ClusterIndex][genIndex];
+  }
+
+  TIter itVertexArray(score.vertexArray);
+  while((candidate = static_cast<Candidate *>(itVertexArray.Next())))
+  {
+    ++score.recoVertices;
+
+    itRecoTracks = recoTracks.find(candidate->ClusterIndex);
+    if(itRecoTracks == recoTracks.end())
+    {
+      ++score.fakeVertices;
+      continue;
+    }
+
+    bestIndex = -1;
+    bestCount = 0;
+    sumCount = 0;
+    for(itTracks = itRecoTracks->second.begin(); itTracks != itRecoTracks->second.end(); ++itTracks)
+    {
+      sumCount += itTracks->second;
+      if(itTracks->first >= 0 && itTracks->second > bestCount)
+      {
+        bestIndex = itTracks->first;
+        bestCount = itTracks->second;
+      }
+    }
+
+    if(bestIndex >= 0 && 2*bestCount > sumCount)
+    {
+      foundVertices.insert(bestIndex);
+    }
+    else
+    {
+      ++score.fakeVertices;
+    }
+  }
+
+  for(itTracks = genTracks.begin(); itTracks != genTracks.end(); ++itTracks)
+  {
+    if(itTracks->second < 2) continue;
+    ++score.trueVertices;
+    if(foundVertices.count(itTracks->first)) ++score.foundVertices;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+static void SetMeanPileUp(ExRootConfReader *confReader, const TString &moduleName, Double_t mu)
+{
+  stringstream message;
+  TString fileName("VertexBenchmark");
+  FILE *file = gSystem->TempFileName(fileName);
+
+  if(!file)
+  {
+    message << "can't create temporary configuration file";
+    throw runtime_error(message.str());
+  }
+
+  fprintf(file, "set %s::MeanPileUp %g\n", moduleName.Data(), mu);
+  fclose(file);
+
+  confReader->ReadFile(fileName, false);
+
+  gSystem->Unlink(fileName);
+}
+
+//---------------------------------------------------------------------------
+
+static Bool_t ReadEvent(FILE *inputFile, DelphesHepMCReader *reader, DelphesFactory *factory,
+  TObjArray *allParticleOutputArray, TObjArray *stableParticleOutputArray, TObjArray *partonOutputArray)
+{
+  Bool_t rewound = kFALSE;
+
+  while(kTRUE)
+  {
+    if(reader->ReadBlock(factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray))
+    {
+      if(reader->EventReady()) return kTRUE;
+    }
+    else
+    {
+      // start again from the first event when the input file is exhausted
+      if(rewound) return kFALSE;
+      rewound = kTRUE;
+      fseek(inputFile, 0L, SEEK_SET);
+      reader->Clear();
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  char appName[] = "VertexBenchmark";
+  stringstream message;
+  FILE *inputFile = 0;
+  ExRootTreeWriter *treeWriter = 0;
+  ExRootConfReader *confReader = 0;
+  Delphes *modularDelphes = 0;
+  DelphesFactory *factory = 0;
+  DelphesHepMCReader *reader = 0;
+  TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
+  TObjArray *genVertexArray = 0;
+  ExRootTask *task;
+  Candidate *candidate, *particle;
+  ProcInfo_t procInfoBefore, procInfoAfter;
+  vector<VertexerScore> scores;
+  vector<VertexerScore>::iterator itScores;
+  vector<BenchmarkRow> rows;
+  vector<BenchmarkRow>::iterator itRows;
+  BenchmarkRow row;
+  map<Candidate *, Int_t> genVertexMap;
+  TString pileUpName, className;
+  Long64_t event, numberOfEvents;
+  Int_t i, genIndex;
+
+  if(argc < 5)
+  {
+    cout << " Usage: " << appName << " config_file" << " input_file" << " number_of_events" << " mu_1 [mu_2 ...]" << endl;
+    cout << " config_file - configuration file in Tcl format with PileUpMerger and vertex finders," << endl;
+    cout << " input_file - hard scatter events in HepMC format, - for pile-up only events," << endl;
+    cout << " number_of_events - number of events processed for each value of mu," << endl;
+    cout << " mu_1 [mu_2 ...] - mean pile-up values." << endl;
+    return 1;
+  }
+
+  signal(SIGINT, SignalHandler);
+
+  gROOT->SetBatch();
+
+  int appargc = 1;
+  char *appargv[] = {appName};
+  TApplication app(appName, &appargc, appargv);
+
+  try
+  {
+    numberOfEvents = atol(argv[3]);
+
+    if(numberOfEvents <= 0)
+    {
+      throw runtime_error("number_of_events must be positive");
+    }
+
+    if(strncmp(argv[2], "-", 2) != 0)
+    {
+      inputFile = fopen(argv[2], "r");
+
+      if(inputFile == NULL)
+      {
+        message << "can't open " << argv[2];
+        throw runtime_error(message.str());
+      }
+
+      reader = new DelphesHepMCReader;
+      reader->SetInputFile(inputFile);
+    }
+
+    for(i = 4; i < argc && !interrupted; ++i)
+    {
+      row.mu = atof(argv[i]);
+
+      confReader = new ExRootConfReader;
+      confReader->ReadFile(argv[1]);
+
+      const ExRootConfReader::ExRootTaskMap *modules = confReader->GetModules();
+      ExRootConfReader::ExRootTaskMap::const_iterator itModules;
+
+      pileUpName = "";
+      for(itModules = modules->begin(); itModules != modules->end(); ++itModules)
+      {
+        if(itModules->second == "PileUpMerger") pileUpName = itModules->first;
+      }
+
+      if(pileUpName == "")
+      {
+        message << "no PileUpMerger module in " << argv[1];
+        throw runtime_error(message.str());
+      }
+
+      SetMeanPileUp(confReader, pileUpName, row.mu);
+
+      // no output file, the branches of TreeWriter are kept in memory only
+      treeWriter = new ExRootTreeWriter(0, "Delphes");
+
+      modularDelphes = new Delphes("Delphes");
+      modularDelphes->SetConfReader(confReader);
+      modularDelphes->SetTreeWriter(treeWriter);
+
+      factory = modularDelphes->GetFactory();
+      allParticleOutputArray = modularDelphes->ExportArray("allParticles");
+      stableParticleOutputArray = modularDelphes->ExportArray("stableParticles");
+      partonOutputArray = modularDelphes->ExportArray("partons");
+
+      modularDelphes->InitTask();
+
+      genVertexArray = modularDelphes->ImportArray(pileUpName + "/" + confReader->GetString(pileUpName + "::VertexOutputArray", "vertices"));
+
+      scores.clear();
+      TIter itTasks(modularDelphes->GetListOfTasks());
+      while((task = static_cast<ExRootTask *>(itTasks.Next())))
+      {
+        itModules = modules->find(task->GetName());
+        className = (itModules != modules->end()) ? itModules->second : "";
+        if(!IsVertexer(className)) continue;
+
+        VertexerScore score;
+        score.name = task->GetName();
+        score.task = task;
+        score.inputArray = modularDelphes->ImportArray(confReader->GetString(score.name + "::InputArray", "TrackSmearing/tracks"));
+        score.vertexArray = modularDelphes->ImportArray(score.name + "/" + confReader->GetString(score.name + "::VertexOutputArray", "vertices"));
+        score.stopWatch.Reset();
+        score.memoryIncrease = 0;
+        score.trueVertices = 0;
+        score.recoVertices = 0;
+        score.foundVertices = 0;
+        score.fakeVertices = 0;
+        scores.push_back(score);
+      }
+
+      if(scores.empty())
+      {
+        message << "no vertex finder in the ExecutionPath of " << argv[1];
+        throw runtime_error(message.str());
+      }
+
+      cout << "** Processing " << numberOfEvents << " events with mu = " << row.mu << endl;
+
+      treeWriter->Clear();
+      modularDelphes->Clear();
+      if(reader)
+      {
+        fseek(inputFile, 0L, SEEK_SET);
+        reader->Clear();
+      }
+
+      for(event = 0; event < numberOfEvents && !interrupted; ++event)
+      {
+        if(reader && !ReadEvent(inputFile, reader, factory, allParticleOutputArray, stableParticleOutputArray, partonOutputArray))
+        {
+          message << "no events in " << argv[2];
+          throw runtime_error(message.str());
+        }
+
+        genVertexMap.clear();
+
+        itTasks.Reset();
+        while((task = static_cast<ExRootTask *>(itTasks.Next())))
+        {
+          for(itScores = scores.begin(); itScores != scores.end(); ++itScores)
+          {
+            if(itScores->task == task) break;
+          }
+
+          if(itScores == scores.end())
+          {
+            task->ProcessTask();
+            continue;
+          }
+
+          // generated vertices are known once PileUpMerger has run
+          if(genVertexMap.empty())
+          {
+            genIndex = 0;
+            TIter itGenVertexArray(genVertexArray);
+            while((candidate = static_cast<Candidate *>(itGenVertexArray.Next())))
+            {
+              TIter itParticles(candidate->GetCandidates());
+              while((particle = static_cast<Candidate *>(itParticles.Next())))
+              {
+                genVertexMap[particle] = genIndex;
+              }
+              ++genIndex;
+            }
+          }
+
+          // vertex finders share their input tracks, reset the assignment of the previous one
+          TIter itInputArray(itScores->inputArray);
+          while((candidate = static_cast<Candidate *>(itInputArray.Next())))
+          {
+            candidate->ClusterIndex = -1;
+          }
+
+          gSystem->GetProcInfo(&procInfoBefore);
+
+          itScores->stopWatch.Start(kFALSE);
+          task->ProcessTask();
+          itScores->stopWatch.Stop();
+
+          gSystem->GetProcInfo(&procInfoAfter);
+          if(procInfoAfter.fMemResident - procInfoBefore.fMemResident > itScores->memoryIncrease)
+          {
+            itScores->memoryIncrease = procInfoAfter.fMemResident - procInfoBefore.fMemResident;
+          }
+
+          ScoreVertexer(*itScores, genVertexMap);
+        }
+
+        treeWriter->Clear();
+        modularDelphes->Clear();
+        if(reader) reader->Clear();
+      }
+
+      for(itScores = scores.begin(); itScores != scores.end() && event > 0; ++itScores)
+      {
+        row.name = itScores->name;
+        row.time = 1.0E3*itScores->stopWatch.RealTime()/event;
+        row.memory = itScores->memoryIncrease/1024.0;
+        row.trueVertices = Double_t(itScores->trueVertices)/event;
+        row.recoVertices = Double_t(itScores->recoVertices)/event;
+        row.efficiency = itScores->trueVertices > 0 ? Double_t(itScores->foundVertices)/itScores->trueVertices : 0.0;
+        row.fakeRate = itScores->recoVertices > 0 ? Double_t(itScores->fakeVertices)/itScores->recoVertices : 0.0;
+        rows.push_back(row);
+      }
+
+      modularDelphes->FinishTask();
+
+      delete modularDelphes;
+      delete confReader;
+      delete treeWriter;
+      treeWriter = 0;
+    }
+
+    cout << endl;
+    cout << left;
+    cout << setw(8) << "mu" << setw(25) << "module";
+    cout << right;
+    cout << setw(16) << "time/event, ms" << setw(16) << "max dRSS, MB";
+    cout << setw(12) << "<N gen>" << setw(12) << "<N reco>";
+    cout << setw(12) << "efficiency" << setw(12) << "fake rate" << endl;
+
+    for(itRows = rows.begin(); itRows != rows.end(); ++itRows)
+    {
+      cout << left;
+      cout << setw(8) << itRows->mu << setw(25) << itRows->name;
+      cout << right << fixed;
+      cout << setprecision(2) << setw(16) << itRows->time << setprecision(1) << setw(16) << itRows->memory;
+      cout << setprecision(1) << setw(12) << itRows->trueVertices << setw(12) << itRows->recoVertices;
+      cout << setprecision(3) << setw(12) << itRows->efficiency << setw(12) << itRows->fakeRate << endl;
+      cout.unsetf(ios::fixed);
+    }
+
+    cout << "** Exiting..." << endl;
+
+    delete reader;
+    if(inputFile) fclose(inputFile);
+
+    return 0;
+  }
+  catch(runtime_error &e)
+  {
+    if(treeWriter) delete treeWriter;
+    cerr << "** ERROR: " << e.what() << endl;
+    return 1;
+  }
+}
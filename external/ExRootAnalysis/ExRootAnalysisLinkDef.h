@@ -26,6 +26,8 @@
 #pragma link off all functions;
 
 #pragma link C++ class ExRootTreeReader+;
+#pragma link C++ class ExRootTreeLinks+;
+#pragma link C++ class ExRootTreeColumn+;
 #pragma link C++ class ExRootTreeBranch+;
 #pragma link C++ class ExRootTreeWriter+;
 #pragma link C++ class ExRootResult+;
@@ -11,6 +11,7 @@
 
 #include "tcl/tcl.h"
 
+#include "TMD5.h"
 #include "TSystem.h"
 
 #include <iostream>
@@ -25,11 +26,41 @@ using namespace std;
 static Tcl_ObjCmdProc ModuleObjCmdProc;
 static Tcl_ObjCmdProc SourceObjCmdProc;
 
+static const char *const kCacheMagic = "ExRootConfCache 1";
+
+// lists the scalar variables of all namespaces as {name value name value ...}
+static const char *const kCollectScript =
+  "proc ::ExRootConfCollect {namespace} {\n"
+  "  set result {}\n"
+  "  foreach name [info vars ${namespace}::*] {\n"
+  "    if {[info exists $name] && ![array exists $name]} {\n"
+  "      lappend result $name [set $name]\n"
+  "    }\n"
+  "  }\n"
+  "  foreach child [namespace children $namespace] {\n"
+  "    eval lappend result [::ExRootConfCollect $child]\n"
+  "  }\n"
+  "  return $result\n"
+  "}\n"
+  "::ExRootConfCollect ::\n";
+
+//------------------------------------------------------------------------------
+
+static TString AbsolutePath(const char *fileName)
+{
+  TString result(fileName);
+  if(!gSystem->IsAbsoluteFileName(fileName)) gSystem->PrependPathName(gSystem->WorkingDirectory(), result);
+  return result;
+}
+
 //------------------------------------------------------------------------------
 
 ExRootConfReader::ExRootConfReader() :
   fTopDir(0), fTclInterp(0)
 {
+  const char *cacheDir = gSystem->Getenv("DELPHES_CARD_CACHE");
+  if(cacheDir) fCacheDir = cacheDir;
+
   fTclInterp = Tcl_CreateInterp();
 
   Tcl_CreateObjCommand(fTclInterp, "module", ModuleObjCmdProc, this, 0);
@@ -64,6 +95,32 @@ void ExRootConfReader::ReadFile(const char *fileName, bool isTop)
   char *cmdBuffer = new char[file_length];
   inputFileStream.read(cmdBuffer, file_length);
 
+  TMD5 checksum;
+  checksum.Update(reinterpret_cast<UChar_t *>(cmdBuffer), file_length);
+  checksum.Final();
+
+  // absolute names, the sourced files of the same card in another
+  // directory or read from another working directory are other files
+  if(isTop) fFiles.clear();
+  fFiles.push_back(make_pair(AbsolutePath(fileName), TString(checksum.AsString())));
+
+  TString cacheName;
+  TMD5 cacheKey;
+  bool useCache = isTop && fCacheDir.Length() > 0;
+
+  if(useCache)
+  {
+    cacheKey.Update(reinterpret_cast<const UChar_t *>(fFiles[0].first.Data()), fFiles[0].first.Length());
+    cacheKey.Update(reinterpret_cast<const UChar_t *>(fFiles[0].second.Data()), fFiles[0].second.Length());
+    cacheKey.Final();
+    cacheName.Form("%s/%s.conf", fCacheDir.Data(), cacheKey.AsString());
+    if(ReadCache(cacheName))
+    {
+      delete[] cmdBuffer;
+      return;
+    }
+  }
+
   Tcl_Obj *cmdObjPtr = Tcl_NewObj();
   cmdObjPtr->bytes = cmdBuffer;
   cmdObjPtr->length = file_length;
@@ -83,6 +140,192 @@ void ExRootConfReader::ReadFile(const char *fileName, bool isTop)
   Tcl_DecrRefCount(cmdObjPtr);
 
   delete[] cmdBuffer;
+
+  if(useCache) WriteCache(cacheName);
+}
+
+//------------------------------------------------------------------------------
+
+TString ExRootConfReader::GetChecksum() const
+{
+  vector< pair< TString, TString > >::const_iterator itFiles;
+  TMD5 checksum;
+
+  for(itFiles = fFiles.begin(); itFiles != fFiles.end(); ++itFiles)
+  {
+    checksum.Update(reinterpret_cast<const UChar_t *>(itFiles->second.Data()), itFiles->second.Length());
+  }
+  checksum.Final();
+
+  return checksum.AsString();
+}
+
+//------------------------------------------------------------------------------
+
+static void WriteString(ostream &stream, const char *string, int length)
+{
+  UInt_t size = length;
+  stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  stream.write(string, size);
+}
+
+//------------------------------------------------------------------------------
+
+static bool ReadString(istream &stream, string &result)
+{
+  UInt_t size = 0;
+  if(!stream.read(reinterpret_cast<char *>(&size), sizeof(size))) return false;
+  result.resize(size);
+  return size == 0 || stream.read(&result[0], size);
+}
+
+//------------------------------------------------------------------------------
+
+bool ExRootConfReader::ReadCache(const char *cacheName)
+{
+  vector< pair< TString, TString > > files;
+  vector< pair< string, string > > modules, variables;
+  vector< pair< string, string > >::iterator itPairs;
+  string first, second, namespaceName;
+  UInt_t i, size;
+  TMD5 *checksum;
+  bool valid;
+  Tcl_Obj *name, *value;
+
+  ifstream inputFileStream(cacheName, ios::in | ios::binary);
+  if(!inputFileStream.is_open()) return false;
+
+  if(!ReadString(inputFileStream, first) || first != kCacheMagic) return false;
+
+  // the cache is valid if none of the files read by the card has changed,
+  // the name of the cache is the checksum of the path and of the content
+  // of the top card, the sourced files are checked here
+  if(!inputFileStream.read(reinterpret_cast<char *>(&size), sizeof(size))) return false;
+  for(i = 0; i < size; ++i)
+  {
+    if(!ReadString(inputFileStream, first) || !ReadString(inputFileStream, second)) return false;
+    files.push_back(make_pair(TString(first.c_str()), TString(second.c_str())));
+  }
+
+  if(files.empty() || files[0] != fFiles[0]) return false;
+
+  for(i = 1; i < files.size(); ++i)
+  {
+    checksum = TMD5::FileChecksum(files[i].first);
+    valid = checksum && files[i].second == checksum->AsString();
+    delete checksum;
+    if(!valid) return false;
+  }
+
+  if(!inputFileStream.read(reinterpret_cast<char *>(&size), sizeof(size))) return false;
+  for(i = 0; i < size; ++i)
+  {
+    if(!ReadString(inputFileStream, first) || !ReadString(inputFileStream, second)) return false;
+    modules.push_back(make_pair(first, second));
+  }
+
+  if(!inputFileStream.read(reinterpret_cast<char *>(&size), sizeof(size))) return false;
+  for(i = 0; i < size; ++i)
+  {
+    if(!ReadString(inputFileStream, first) || !ReadString(inputFileStream, second)) return false;
+    variables.push_back(make_pair(first, second));
+  }
+
+  cout << "** INFO: reading configuration from cache " << cacheName << endl;
+
+  fFiles = files;
+
+  for(itPairs = modules.begin(); itPairs != modules.end(); ++itPairs)
+  {
+    AddModule(itPairs->first.c_str(), itPairs->second.c_str());
+  }
+
+  // set the variables without evaluating the card,
+  // their namespaces have to exist before
+  for(itPairs = variables.begin(); itPairs != variables.end(); ++itPairs)
+  {
+    first = itPairs->first.substr(0, itPairs->first.rfind("::"));
+    if(!first.empty() && first != namespaceName)
+    {
+      namespaceName = first;
+      name = Tcl_NewStringObj(const_cast<char *>(("namespace eval " + namespaceName + " {}").c_str()), -1);
+      Tcl_IncrRefCount(name);
+      Tcl_EvalObj(fTclInterp, name);
+      Tcl_DecrRefCount(name);
+    }
+
+    name = Tcl_NewStringObj(const_cast<char *>(itPairs->first.data()), itPairs->first.size());
+    value = Tcl_NewStringObj(const_cast<char *>(itPairs->second.data()), itPairs->second.size());
+    Tcl_IncrRefCount(name);
+    Tcl_ObjSetVar2(fTclInterp, name, 0, value, TCL_GLOBAL_ONLY);
+    Tcl_DecrRefCount(name);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootConfReader::WriteCache(const char *cacheName)
+{
+  vector< pair< TString, TString > >::iterator itFiles;
+  ExRootTaskMap::iterator itModules;
+  Tcl_Obj **elements;
+  int i, length, size;
+  char *buffer;
+  UInt_t count;
+
+  if(Tcl_Eval(fTclInterp, const_cast<char *>(kCollectScript)) != TCL_OK
+    || Tcl_ListObjGetElements(fTclInterp, Tcl_GetObjResult(fTclInterp), &size, &elements) != TCL_OK)
+  {
+    cout << "** WARNING: can't collect configuration parameters for cache " << cacheName << endl;
+    return;
+  }
+
+  // write to a temporary file first, concurrent jobs may share the cache
+  TString tmpName = TString::Format("%s.%d", cacheName, gSystem->GetPid());
+  ofstream outputFileStream(tmpName, ios::out | ios::binary | ios::trunc);
+  if(!outputFileStream.is_open())
+  {
+    cout << "** WARNING: can't write configuration cache " << cacheName << endl;
+    return;
+  }
+
+  WriteString(outputFileStream, kCacheMagic, strlen(kCacheMagic));
+
+  count = fFiles.size();
+  outputFileStream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for(itFiles = fFiles.begin(); itFiles != fFiles.end(); ++itFiles)
+  {
+    WriteString(outputFileStream, itFiles->first, itFiles->first.Length());
+    WriteString(outputFileStream, itFiles->second, itFiles->second.Length());
+  }
+
+  count = fModules.size();
+  outputFileStream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for(itModules = fModules.begin(); itModules != fModules.end(); ++itModules)
+  {
+    WriteString(outputFileStream, itModules->second, itModules->second.Length());
+    WriteString(outputFileStream, itModules->first, itModules->first.Length());
+  }
+
+  count = size/2;
+  outputFileStream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for(i = 0; i + 1 < size; i += 2)
+  {
+    buffer = Tcl_GetStringFromObj(elements[i], &length);
+    WriteString(outputFileStream, buffer, length);
+    buffer = Tcl_GetStringFromObj(elements[i + 1], &length);
+    WriteString(outputFileStream, buffer, length);
+  }
+
+  outputFileStream.close();
+
+  if(!outputFileStream || gSystem->Rename(tmpName, cacheName) != 0)
+  {
+    cout << "** WARNING: can't write configuration cache " << cacheName << endl;
+    gSystem->Unlink(tmpName);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -91,7 +334,9 @@ ExRootConfParam ExRootConfReader::GetParam(const char *name)
 {
   Tcl_Obj *object;
   Tcl_Obj *variableName = Tcl_NewStringObj(const_cast<char *>(name), -1);
+  Tcl_IncrRefCount(variableName);
   object = Tcl_ObjGetVar2(fTclInterp, variableName, 0, TCL_GLOBAL_ONLY);
+  Tcl_DecrRefCount(variableName);
   return ExRootConfParam(name, object, fTclInterp);
 }
 
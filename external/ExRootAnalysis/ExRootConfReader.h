@@ -12,6 +12,7 @@
 #include "TNamed.h"
 
 #include <map>
+#include <vector>
 #include <utility>
 
 struct Tcl_Obj;
@@ -51,6 +52,14 @@ public:
 
   void ReadFile(const char *fileName, bool isTop = true);
 
+  // directory of the configuration cache, the resolved parameters of a card
+  // are stored there and the card is evaluated again only when it or one of
+  // its sourced files changes; set from DELPHES_CARD_CACHE by default
+  void SetCacheDir(const char *cacheDir) { fCacheDir = cacheDir; }
+
+  // MD5 checksum of the card and of all its sourced files
+  TString GetChecksum() const;
+
   int GetInt(const char *name, int defaultValue, int index = -1);
   long GetLong(const char *name, long defaultValue, int index = -1);
   double GetDouble(const char *name, double defaultValue, int index = -1);
@@ -66,12 +75,20 @@ public:
 
 private:
 
+  bool ReadCache(const char *cacheName);
+  void WriteCache(const char *cacheName);
+
   const char *fTopDir; //!
 
   Tcl_Interp *fTclInterp; //!
 
   ExRootTaskMap fModules; //!
 
+  TString fCacheDir; //!
+
+  // absolute names and MD5 checksums of the top card and of its sourced files
+  std::vector< std::pair< TString, TString > > fFiles; //!
+
   ClassDef(ExRootConfReader, 1)
 };
 
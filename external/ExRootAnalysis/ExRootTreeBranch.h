@@ -25,6 +25,9 @@ public:
   TObject *NewEntry();
   void Clear();
 
+  TClonesArray *GetData() const { return fData; }
+  Int_t GetSize() const { return fSize; }
+
 private:
 
   Int_t fSize, fCapacity; //!
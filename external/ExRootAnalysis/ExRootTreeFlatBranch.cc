@@ -0,0 +1,376 @@
+
+/** \class ExRootTreeFlatBranch
+ *
+ *  Class writing the entries of an ExRootTreeBranch as flat arrays,
+ *  one ROOT tree branch per data member (Jet.PT[Jet_size], ...).
+ *
+ *  TRef members are written as a pair of (branch id, entry index) columns,
+ *  TRefArray members as [Begin, End) ranges into flat Index/Branch columns,
+ *  with the same layout as ExRootTreeLinkBranch.
+ *  Branch ids are the positions of the branches in TTree::GetUserInfo().
+ *
+ */
+
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
+#include "ExRootAnalysis/ExRootTreeBranch.h"
+
+#include "TRef.h"
+#include "TTree.h"
+#include "TClass.h"
+#include "TBranch.h"
+#include "TString.h"
+#include "TDataType.h"
+#include "TRefArray.h"
+#include "TBaseClass.h"
+#include "TDataMember.h"
+#include "TDictionary.h"
+#include "TClonesArray.h"
+#include "TLorentzVector.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+  enum EColumnKind { kBasic, kLorentzVector, kRef, kRefArray };
+
+  const UInt_t kUIDMask = 0xffffff;
+
+  // leaf type code for ROOT basic types, 0 if the type can't be written
+  char LeafType(Int_t type)
+  {
+    switch(type)
+    {
+      case kChar_t: return 'B';
+      case kUChar_t: return 'b';
+      case kShort_t: return 'S';
+      case kUShort_t: return 's';
+      case kInt_t: return 'I';
+      case kUInt_t: return 'i';
+      case kLong64_t: return 'L';
+      case kULong64_t: return 'l';
+      case kFloat_t: return 'F';
+      case kFloat16_t: return 'F';
+      case kDouble_t: return 'D';
+      case kDouble32_t: return 'D';
+      case kBool_t: return 'O';
+      default: return 0;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatIndex::Add(ExRootTreeBranch *branch, Short_t id)
+{
+  TClonesArray *data = branch->GetData();
+  TObject *object;
+  Int_t i, size = branch->GetSize();
+
+  for(i = 0; i < size; ++i)
+  {
+    object = data->UncheckedAt(i);
+    if(object->TestBit(TObject::kIsReferenced)) Add(object->GetUniqueID(), id, i);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatIndex::Add(UInt_t uid, Short_t branch, Int_t entry)
+{
+  uid &= kUIDMask;
+
+  if(uid >= fEntries.size())
+  {
+    fBranches.resize(2*uid + 1, -1);
+    fEntries.resize(2*uid + 1, -1);
+  }
+
+  // first entry wins if the same object is written to several branches
+  if(fEntries[uid] >= 0) return;
+
+  fBranches[uid] = branch;
+  fEntries[uid] = entry;
+  fUsed.push_back(uid);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatIndex::Find(UInt_t uid, Short_t &branch, Int_t &entry) const
+{
+  uid &= kUIDMask;
+
+  if(uid == 0 || uid >= fEntries.size())
+  {
+    branch = -1;
+    entry = -1;
+    return;
+  }
+
+  branch = fBranches[uid];
+  entry = fEntries[uid];
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatIndex::Clear()
+{
+  vector< UInt_t >::iterator itUsed;
+  for(itUsed = fUsed.begin(); itUsed != fUsed.end(); ++itUsed)
+  {
+    fBranches[*itUsed] = -1;
+    fEntries[*itUsed] = -1;
+  }
+  fUsed.clear();
+}
+
+//------------------------------------------------------------------------------
+
+char *ExRootTreeFlatBranch::Leaf::Reserve(Int_t entries)
+{
+  size_t size = entries*width;
+  if(size > data.size())
+  {
+    data.resize(max(size, 2*data.size()));
+    branch->SetAddress(&data[0]);
+  }
+  return &data[0];
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeFlatBranch::ExRootTreeFlatBranch(const char *name, TClass *cl, TTree *tree, Int_t basketSize, Bool_t references) :
+  fName(name), fReferences(references), fSize(0), fTree(tree), fBasketSize(basketSize), fBranch(0)
+{
+  stringstream message;
+
+  if(!fTree)
+  {
+    message << "can't create flat branch '" << name << "' without output tree";
+    throw runtime_error(message.str());
+  }
+
+  // objects are created and kept in memory only, the tree gets the columns
+  fBranch = new ExRootTreeBranch(name, cl, 0);
+
+  fTree->Branch(fName + "_size", &fSize, fName + "_size/I", fBasketSize);
+
+  AddColumns(cl, 0);
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeFlatBranch::~ExRootTreeFlatBranch()
+{
+  vector< Leaf * >::iterator itLeaves;
+  for(itLeaves = fLeaves.begin(); itLeaves != fLeaves.end(); ++itLeaves)
+  {
+    delete (*itLeaves);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeFlatBranch::Leaf *ExRootTreeFlatBranch::NewLeaf(const char *name, const char *leaflist, Int_t width)
+{
+  Leaf *leaf = new Leaf;
+  leaf->width = width;
+  leaf->data.resize(10*width);
+  leaf->branch = fTree->Branch(name, &leaf->data[0], leaflist, fBasketSize);
+  fLeaves.push_back(leaf);
+  return leaf;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatBranch::AddColumns(TClass *cl, Int_t offset)
+{
+  TBaseClass *base;
+  TClass *baseClass;
+  TDataMember *member;
+  TDataType *type;
+  TString typeName, branchName, counterName, dimensions;
+  Column column;
+  Int_t i, unit;
+  char code;
+
+  // members of base classes other than TObject come first
+  TIter itBases(cl->GetListOfBases());
+  while((base = static_cast<TBaseClass*>(itBases.Next())))
+  {
+    baseClass = base->GetClassPointer();
+    if(!baseClass || baseClass == TObject::Class()) continue;
+    AddColumns(baseClass, offset + base->GetDelta());
+  }
+
+  counterName = fName + "_size";
+
+  TIter itMembers(cl->GetListOfDataMembers());
+  while((member = static_cast<TDataMember*>(itMembers.Next())))
+  {
+    if(!member->IsPersistent() || member->IsaPointer() || (member->Property() & kIsStatic)) continue;
+
+    branchName = fName + "." + member->GetName();
+    typeName = member->GetTypeName();
+
+    column.offset = offset + member->GetOffset();
+    column.length = 1;
+    column.counter = 0;
+    dimensions = "";
+    for(i = 0; i < member->GetArrayDim(); ++i)
+    {
+      column.length *= member->GetMaxIndex(i);
+      dimensions += Form("[%d]", member->GetMaxIndex(i));
+    }
+
+    if(member->IsBasic())
+    {
+      type = member->GetDataType();
+      code = type ? LeafType(type->GetType()) : 0;
+      if(!code)
+      {
+        cout << "** WARNING: member '" << member->GetName() << "' of type '" << typeName;
+        cout << "' is not written to flat branch '" << fName << "'" << endl;
+        continue;
+      }
+      unit = type->Size();
+
+      column.kind = kBasic;
+      column.leaves[0] = NewLeaf(branchName, Form("%s[%s]%s/%c", branchName.Data(), counterName.Data(), dimensions.Data(), code), unit*column.length);
+    }
+    else if(typeName == "TLorentzVector")
+    {
+      column.kind = kLorentzVector;
+      column.leaves[0] = NewLeaf(branchName + ".Px", Form("%s.Px[%s]%s/F", branchName.Data(), counterName.Data(), dimensions.Data()), sizeof(Float_t)*column.length);
+      column.leaves[1] = NewLeaf(branchName + ".Py", Form("%s.Py[%s]%s/F", branchName.Data(), counterName.Data(), dimensions.Data()), sizeof(Float_t)*column.length);
+      column.leaves[2] = NewLeaf(branchName + ".Pz", Form("%s.Pz[%s]%s/F", branchName.Data(), counterName.Data(), dimensions.Data()), sizeof(Float_t)*column.length);
+      column.leaves[3] = NewLeaf(branchName + ".E", Form("%s.E[%s]%s/F", branchName.Data(), counterName.Data(), dimensions.Data()), sizeof(Float_t)*column.length);
+    }
+    else if((typeName == "TRef" || typeName == "TRefArray") && !fReferences)
+    {
+      continue;
+    }
+    else if(typeName == "TRef" && column.length == 1)
+    {
+      column.kind = kRef;
+      column.leaves[0] = NewLeaf(branchName + ".Index", Form("%s.Index[%s]/I", branchName.Data(), counterName.Data()), sizeof(Int_t));
+      column.leaves[1] = NewLeaf(branchName + ".Branch", Form("%s.Branch[%s]/S", branchName.Data(), counterName.Data()), sizeof(Short_t));
+    }
+    else if(typeName == "TRefArray" && column.length == 1)
+    {
+      column.kind = kRefArray;
+      column.leaves[0] = NewLeaf(branchName + ".Begin", Form("%s.Begin[%s]/I", branchName.Data(), counterName.Data()), sizeof(Int_t));
+      column.leaves[1] = NewLeaf(branchName + ".End", Form("%s.End[%s]/I", branchName.Data(), counterName.Data()), sizeof(Int_t));
+
+      TString refCounterName = fName + "_" + member->GetName() + "_size";
+      column.counter = NewLeaf(refCounterName, refCounterName + "/I", sizeof(Int_t));
+      column.leaves[2] = NewLeaf(branchName + ".Index", Form("%s.Index[%s]/I", branchName.Data(), refCounterName.Data()), sizeof(Int_t));
+      column.leaves[3] = NewLeaf(branchName + ".Branch", Form("%s.Branch[%s]/S", branchName.Data(), refCounterName.Data()), sizeof(Short_t));
+    }
+    else
+    {
+      cout << "** WARNING: member '" << member->GetName() << "' of type '" << typeName;
+      cout << "' is not written to flat branch '" << fName << "'" << endl;
+      continue;
+    }
+
+    fColumns.push_back(column);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeFlatBranch::Fill(const ExRootTreeFlatIndex *index)
+{
+  TClonesArray *data = fBranch->GetData();
+  vector< Column >::iterator itColumns;
+  const TLorentzVector *momentum;
+  const TRefArray *refs;
+  char *object;
+  Float_t *px, *py, *pz, *e;
+  Int_t *entries, *begin, *end;
+  Short_t *branches;
+  Int_t i, j, k, n, total;
+
+  fSize = fBranch->GetSize();
+
+  for(itColumns = fColumns.begin(); itColumns != fColumns.end(); ++itColumns)
+  {
+    Column &column = *itColumns;
+    switch(column.kind)
+    {
+      case kBasic:
+        {
+          Leaf *leaf = column.leaves[0];
+          char *buffer = leaf->Reserve(fSize);
+          for(i = 0; i < fSize; ++i)
+          {
+            object = reinterpret_cast<char *>(data->UncheckedAt(i));
+            memcpy(buffer + i*leaf->width, object + column.offset, leaf->width);
+          }
+        }
+        break;
+      case kLorentzVector:
+        px = reinterpret_cast<Float_t *>(column.leaves[0]->Reserve(fSize));
+        py = reinterpret_cast<Float_t *>(column.leaves[1]->Reserve(fSize));
+        pz = reinterpret_cast<Float_t *>(column.leaves[2]->Reserve(fSize));
+        e = reinterpret_cast<Float_t *>(column.leaves[3]->Reserve(fSize));
+        for(i = 0, k = 0; i < fSize; ++i)
+        {
+          object = reinterpret_cast<char *>(data->UncheckedAt(i));
+          momentum = reinterpret_cast<const TLorentzVector *>(object + column.offset);
+          for(j = 0; j < column.length; ++j, ++k)
+          {
+            px[k] = momentum[j].Px();
+            py[k] = momentum[j].Py();
+            pz[k] = momentum[j].Pz();
+            e[k] = momentum[j].E();
+          }
+        }
+        break;
+      case kRef:
+        entries = reinterpret_cast<Int_t *>(column.leaves[0]->Reserve(fSize));
+        branches = reinterpret_cast<Short_t *>(column.leaves[1]->Reserve(fSize));
+        for(i = 0; i < fSize; ++i)
+        {
+          object = reinterpret_cast<char *>(data->UncheckedAt(i));
+          index->Find(reinterpret_cast<const TRef *>(object + column.offset)->GetUniqueID(), branches[i], entries[i]);
+        }
+        break;
+      case kRefArray:
+        begin = reinterpret_cast<Int_t *>(column.leaves[0]->Reserve(fSize));
+        end = reinterpret_cast<Int_t *>(column.leaves[1]->Reserve(fSize));
+
+        total = 0;
+        for(i = 0; i < fSize; ++i)
+        {
+          object = reinterpret_cast<char *>(data->UncheckedAt(i));
+          total += reinterpret_cast<const TRefArray *>(object + column.offset)->GetEntriesFast();
+        }
+
+        entries = reinterpret_cast<Int_t *>(column.leaves[2]->Reserve(total));
+        branches = reinterpret_cast<Short_t *>(column.leaves[3]->Reserve(total));
+        *reinterpret_cast<Int_t *>(column.counter->Reserve(1)) = total;
+
+        for(i = 0, k = 0; i < fSize; ++i)
+        {
+          object = reinterpret_cast<char *>(data->UncheckedAt(i));
+          refs = reinterpret_cast<const TRefArray *>(object + column.offset);
+          n = refs->GetEntriesFast();
+          begin[i] = k;
+          for(j = 0; j < n; ++j, ++k)
+          {
+            index->Find(refs->GetUID(j), branches[k], entries[k]);
+          }
+          end[i] = k;
+        }
+        break;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
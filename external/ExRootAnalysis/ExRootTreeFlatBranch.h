@@ -0,0 +1,95 @@
+#ifndef ExRootTreeFlatBranch_h
+#define ExRootTreeFlatBranch_h
+
+/** \class ExRootTreeFlatBranch
+ *
+ *  Class writing the entries of an ExRootTreeBranch as flat arrays,
+ *  one ROOT tree branch per data member (Jet.PT[Jet_size], ...).
+ *
+ *  TRef members are written as a pair of (branch id, entry index) columns,
+ *  TRefArray members as [Begin, End) ranges into flat Index/Branch columns,
+ *  with the same layout as ExRootTreeLinkBranch.
+ *  Branch ids are the positions of the branches in TTree::GetUserInfo().
+ *
+ */
+
+#include "Rtypes.h"
+#include "TString.h"
+
+#include <vector>
+
+class TTree;
+class TClass;
+class TBranch;
+class ExRootTreeBranch;
+
+//------------------------------------------------------------------------------
+
+class ExRootTreeFlatIndex
+{
+public:
+
+  // adds the referenced entries of a branch
+  void Add(ExRootTreeBranch *branch, Short_t id);
+  void Add(UInt_t uid, Short_t branch, Int_t entry);
+  void Find(UInt_t uid, Short_t &branch, Int_t &entry) const;
+  void Clear();
+
+private:
+
+  std::vector< Short_t > fBranches; //!
+  std::vector< Int_t > fEntries; //!
+  std::vector< UInt_t > fUsed; //!
+};
+
+//------------------------------------------------------------------------------
+
+class ExRootTreeFlatBranch
+{
+public:
+
+  ExRootTreeFlatBranch(const char *name, TClass *cl, TTree *tree, Int_t basketSize = 64000, Bool_t references = kTRUE);
+  ~ExRootTreeFlatBranch();
+
+  ExRootTreeBranch *GetBranch() const { return fBranch; }
+
+  void Fill(const ExRootTreeFlatIndex *index);
+
+private:
+
+#if !defined(__CINT__) && !defined(__CLING__)
+  struct Leaf
+  {
+    TBranch *branch;
+    std::vector< char > data;
+    Int_t width;
+
+    char *Reserve(Int_t entries);
+  };
+
+  struct Column
+  {
+    Int_t kind, offset, length;
+    Leaf *leaves[4];
+    Leaf *counter;
+  };
+
+  void AddColumns(TClass *cl, Int_t offset);
+  Leaf *NewLeaf(const char *name, const char *leaflist, Int_t width);
+
+  TString fName; //!
+  Bool_t fReferences; //!
+  Int_t fSize; //!
+
+  TTree *fTree; //!
+  Int_t fBasketSize; //!
+
+  ExRootTreeBranch *fBranch; //!
+
+  std::vector< Column > fColumns; //!
+  std::vector< Leaf * > fLeaves; //!
+#endif
+};
+
+#endif /* ExRootTreeFlatBranch */
+
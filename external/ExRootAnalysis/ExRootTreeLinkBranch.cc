@@ -0,0 +1,163 @@
+
+/** \class ExRootTreeLinkBranch
+ *
+ *  Class writing links between tree entries as entry indices,
+ *  replacing TRef (one link per entry) and TRefArray (any number of links)
+ *  members. Links are added by unique ID and resolved when the tree is filled.
+ *
+ *  Single links are written as Name.Index[Parent_size] and
+ *  Name.Branch[Parent_size], multiple links as [Name.Begin, Name.End) ranges
+ *  into Name.Index[Parent_Relation_size] and Name.Branch[Parent_Relation_size].
+ *  Branch ids are the positions of the branches in TTree::GetUserInfo().
+ *
+ */
+
+#include "ExRootAnalysis/ExRootTreeLinkBranch.h"
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
+
+#include "TTree.h"
+#include "TBranch.h"
+#include "TString.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+ExRootTreeLinkBranch::ExRootTreeLinkBranch(const char *parent, const char *relation, Bool_t single, TTree *tree, Int_t basketSize) :
+  fSingle(single), fTree(tree), fBasketSize(basketSize), fSize(0),
+  fBeginBranch(0), fEndBranch(0), fIndexBranch(0), fBranchBranch(0),
+  fBeginAddress(0), fEndAddress(0), fIndexAddress(0), fBranchAddress(0)
+{
+  stringstream message;
+  TString name, parentSize, linkSize;
+
+  if(!fTree)
+  {
+    message << "can't create link branch '" << parent << "." << relation << "' without output tree";
+    throw runtime_error(message.str());
+  }
+
+  name = TString(parent) + "." + relation;
+  parentSize = TString(parent) + "_size";
+  linkSize = TString(parent) + "_" + relation + "_size";
+
+  fBegin.resize(1);
+  fEnd.resize(1);
+  fIndex.resize(1);
+  fBranch.resize(1);
+
+  fBeginAddress = &fBegin[0];
+  fEndAddress = &fEnd[0];
+  fIndexAddress = &fIndex[0];
+  fBranchAddress = &fBranch[0];
+
+  if(fSingle)
+  {
+    fIndexBranch = NewBranch(name + ".Index", name + ".Index[" + parentSize + "]/I", fIndexAddress);
+    fBranchBranch = NewBranch(name + ".Branch", name + ".Branch[" + parentSize + "]/S", fBranchAddress);
+  }
+  else
+  {
+    fBeginBranch = NewBranch(name + ".Begin", name + ".Begin[" + parentSize + "]/I", fBeginAddress);
+    fEndBranch = NewBranch(name + ".End", name + ".End[" + parentSize + "]/I", fEndAddress);
+    NewBranch(linkSize, linkSize + "/I", &fSize);
+    fIndexBranch = NewBranch(name + ".Index", name + ".Index[" + linkSize + "]/I", fIndexAddress);
+    fBranchBranch = NewBranch(name + ".Branch", name + ".Branch[" + linkSize + "]/S", fBranchAddress);
+  }
+
+  Clear();
+}
+
+//------------------------------------------------------------------------------
+
+TBranch *ExRootTreeLinkBranch::NewBranch(const TString &name, const TString &leaflist, void *address)
+{
+  return fTree->Branch(name, address, leaflist, fBasketSize);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeLinkBranch::SetAddress(TBranch *branch, void *address, void *&current)
+{
+  if(address == current) return;
+  branch->SetAddress(address);
+  current = address;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeLinkBranch::NewEntry()
+{
+  if(fSingle)
+  {
+    fUIDs.push_back(0);
+  }
+  else
+  {
+    fBegin.push_back(fUIDs.size());
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeLinkBranch::Add(UInt_t uid)
+{
+  if(fSingle)
+  {
+    if(!fUIDs.empty()) fUIDs.back() = uid;
+  }
+  else
+  {
+    fUIDs.push_back(uid);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeLinkBranch::Clear()
+{
+  fUIDs.clear();
+  fBegin.clear();
+  fSize = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeLinkBranch::Fill(const ExRootTreeFlatIndex *index)
+{
+  Int_t i, entries;
+
+  fSize = fUIDs.size();
+
+  fIndex.resize(fSize > 0 ? fSize : 1);
+  fBranch.resize(fSize > 0 ? fSize : 1);
+
+  for(i = 0; i < fSize; ++i)
+  {
+    index->Find(fUIDs[i], fBranch[i], fIndex[i]);
+  }
+
+  SetAddress(fIndexBranch, &fIndex[0], fIndexAddress);
+  SetAddress(fBranchBranch, &fBranch[0], fBranchAddress);
+
+  if(fSingle) return;
+
+  entries = fBegin.size();
+
+  fEnd.resize(entries > 0 ? entries : 1);
+  for(i = 0; i < entries; ++i)
+  {
+    fEnd[i] = (i + 1 < entries) ? fBegin[i + 1] : fSize;
+  }
+
+  if(fBegin.empty()) fBegin.push_back(0);
+
+  SetAddress(fBeginBranch, &fBegin[0], fBeginAddress);
+  SetAddress(fEndBranch, &fEnd[0], fEndAddress);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+#ifndef ExRootTreeLinkBranch_h
+#define ExRootTreeLinkBranch_h
+
+/** \class ExRootTreeLinkBranch
+ *
+ *  Class writing links between tree entries as entry indices,
+ *  replacing TRef (one link per entry) and TRefArray (any number of links)
+ *  members. Links are added by unique ID and resolved when the tree is filled.
+ *
+ *  Single links are written as Name.Index[Parent_size] and
+ *  Name.Branch[Parent_size], multiple links as [Name.Begin, Name.End) ranges
+ *  into Name.Index[Parent_Relation_size] and Name.Branch[Parent_Relation_size].
+ *  Branch ids are the positions of the branches in TTree::GetUserInfo().
+ *
+ */
+
+#include "Rtypes.h"
+#include "TString.h"
+
+#include <vector>
+
+class TTree;
+class TBranch;
+class ExRootTreeFlatIndex;
+
+class ExRootTreeLinkBranch
+{
+public:
+
+  ExRootTreeLinkBranch(const char *parent, const char *relation, Bool_t single, TTree *tree, Int_t basketSize = 64000);
+
+  // starts the links of the next entry of the parent branch
+  void NewEntry();
+  void Add(UInt_t uid);
+
+  void Clear();
+  void Fill(const ExRootTreeFlatIndex *index);
+
+private:
+
+  TBranch *NewBranch(const TString &name, const TString &leaflist, void *address);
+  void SetAddress(TBranch *branch, void *address, void *&current);
+
+  Bool_t fSingle; //!
+  TTree *fTree; //!
+  Int_t fBasketSize; //!
+
+  Int_t fSize; //!
+
+  std::vector< UInt_t > fUIDs; //!
+  std::vector< Int_t > fBegin, fEnd, fIndex; //!
+  std::vector< Short_t > fBranch; //!
+
+  TBranch *fBeginBranch, *fEndBranch, *fIndexBranch, *fBranchBranch; //!
+  void *fBeginAddress, *fEndAddress, *fIndexAddress, *fBranchAddress; //!
+};
+
+#endif /* ExRootTreeLinkBranch */
+
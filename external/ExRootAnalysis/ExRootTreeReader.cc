@@ -12,6 +12,11 @@
 #include "TH2.h"
 #include "TStyle.h"
 #include "TCanvas.h"
+#include "RVersion.h"
+#include "RConfigure.h"
+#include "TList.h"
+#include "TLeaf.h"
+#include "TTreeCacheUnzip.h"
 #include "TClonesArray.h"
 #include "TBranchElement.h"
 
@@ -21,8 +26,155 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
+ExRootTreeLinks::ExRootTreeLinks(const char *name) :
+  fName(name), fBegin(0), fEnd(0), fIndex(0), fBranch(0), fArrays(0)
+{
+  Ssiz_t position = fName.Last('.');
+  fParent = fName(0, position);
+  fRelation = fName(position + 1, fName.Length());
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t ExRootTreeLinks::Notify(TTree *tree)
+{
+  const TString names[6] = {fParent + "_size", fParent + "_" + fRelation + "_size",
+    fName + ".Begin", fName + ".End", fName + ".Index", fName + ".Branch"};
+  TLeaf **leaves[6] = {0, 0, &fBegin, &fEnd, &fIndex, &fBranch};
+  TBranch *branch;
+  Int_t i;
+
+  fBranches.clear();
+  fBegin = fEnd = fIndex = fBranch = 0;
+
+  // counters come first, they have to be read before the arrays
+  for(i = 0; i < 6; ++i)
+  {
+    branch = tree->GetBranch(names[i]);
+    if(!branch) continue;
+    fBranches.push_back(branch);
+    if(leaves[i]) *leaves[i] = branch->GetLeaf(names[i]);
+  }
+
+  return fIndex && fBranch && (fBegin != 0) == (fEnd != 0);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeLinks::ReadEntry(Long64_t entry)
+{
+  vector< TBranch * >::iterator itBranches;
+  for(itBranches = fBranches.begin(); itBranches != fBranches.end(); ++itBranches)
+  {
+    (*itBranches)->GetEntry(entry);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Int_t ExRootTreeLinks::GetSize(Int_t entry) const
+{
+  if(!fBegin) return GetIndex(entry) >= 0 ? 1 : 0;
+
+  const Int_t *begin = static_cast<const Int_t *>(fBegin->GetValuePointer());
+  const Int_t *end = static_cast<const Int_t *>(fEnd->GetValuePointer());
+
+  return end[entry] - begin[entry];
+}
+
+//------------------------------------------------------------------------------
+
+Int_t ExRootTreeLinks::GetIndex(Int_t entry, Int_t i) const
+{
+  const Int_t *index = static_cast<const Int_t *>(fIndex->GetValuePointer());
+  const Int_t *begin = fBegin ? static_cast<const Int_t *>(fBegin->GetValuePointer()) : 0;
+
+  return index[begin ? begin[entry] + i : entry];
+}
+
+//------------------------------------------------------------------------------
+
+Int_t ExRootTreeLinks::GetBranch(Int_t entry, Int_t i) const
+{
+  const Short_t *branch = static_cast<const Short_t *>(fBranch->GetValuePointer());
+  const Int_t *begin = fBegin ? static_cast<const Int_t *>(fBegin->GetValuePointer()) : 0;
+
+  return branch[begin ? begin[entry] + i : entry];
+}
+
+//------------------------------------------------------------------------------
+
+TObject *ExRootTreeLinks::At(Int_t entry, Int_t i) const
+{
+  Int_t index = GetIndex(entry, i);
+  Int_t branch = GetBranch(entry, i);
+  TClonesArray *array;
+
+  if(index < 0 || branch < 0 || !fArrays || branch >= Int_t(fArrays->size())) return 0;
+
+  array = (*fArrays)[branch];
+
+  return array ? array->At(index) : 0;
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeColumn::ExRootTreeColumn(const char *name) :
+  fName(name), fCounter(0), fBranch(0), fLeaf(0), fFirstEntry(0), fOffsets(1, 0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t ExRootTreeColumn::Notify(TTree *tree)
+{
+  TString counterName = fName(0, fName.Last('.')) + "_size";
+
+  // the counter has to be read before the values
+  fCounter = tree->GetBranch(counterName);
+  fBranch = tree->GetBranch(fName);
+  fLeaf = fBranch ? fBranch->GetLeaf(fName) : 0;
+
+  return fLeaf && fBranch->IsA() == TBranch::Class();
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeColumn::Clear(Long64_t first)
+{
+  fFirstEntry = first;
+  fValues.clear();
+  fOffsets.assign(1, 0);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeColumn::ReadEntry(Long64_t entry)
+{
+  Int_t i, size;
+
+  if(fLeaf)
+  {
+    if(fCounter) fCounter->GetEntry(entry);
+    fBranch->GetEntry(entry);
+
+    size = fLeaf->GetLen();
+    for(i = 0; i < size; ++i)
+    {
+      fValues.push_back(fLeaf->GetValue(i));
+    }
+  }
+
+  fOffsets.push_back(fValues.size());
+}
+
+//------------------------------------------------------------------------------
+
 ExRootTreeReader::ExRootTreeReader(TTree *tree) :
-  fChain(tree), fCurrentTree(-1)
+  fChain(tree), fCurrentTree(-1), fFirstEntry(0), fLastEntry(-1),
+  fCacheSize(0), fLearnEntries(10), fCacheValid(kFALSE),
+  fStatsFile(0), fBytesRead(0), fReadCalls(0), fFileBytesRead(0), fFileReadCalls(0),
+  fLinkArraysValid(kFALSE)
 {
 }
 
@@ -36,16 +188,29 @@ ExRootTreeReader::~ExRootTreeReader()
   {
     delete itBranchMap->second.second;
   }
+
+  map< TString, ExRootTreeLinks * >::iterator itLinkMap;
+
+  for(itLinkMap = fLinkMap.begin(); itLinkMap != fLinkMap.end(); ++itLinkMap)
+  {
+    delete itLinkMap->second;
+  }
+
+  map< TString, ExRootTreeColumn * >::iterator itColumnMap;
+
+  for(itColumnMap = fColumnMap.begin(); itColumnMap != fColumnMap.end(); ++itColumnMap)
+  {
+    delete itColumnMap->second;
+  }
 }
 
 //------------------------------------------------------------------------------
 
-Bool_t ExRootTreeReader::ReadEntry(Long64_t entry)
+Bool_t ExRootTreeReader::LoadTree(Long64_t entry, Long64_t &treeEntry)
 {
-  // Read contents of entry.
   if(!fChain) return kFALSE;
 
-  Int_t treeEntry = fChain->LoadTree(entry);
+  treeEntry = fChain->LoadTree(entry);
   if(treeEntry < 0) return kFALSE;
 
   if(fChain->IsA() == TChain::Class())
@@ -58,6 +223,20 @@ Bool_t ExRootTreeReader::ReadEntry(Long64_t entry)
     }
   }
 
+  if(!fCacheValid) UpdateCache();
+
+  return kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t ExRootTreeReader::ReadEntry(Long64_t entry)
+{
+  Long64_t treeEntry;
+
+  // Read contents of entry.
+  if(!LoadTree(entry, treeEntry)) return kFALSE;
+
   TBranchMap::iterator itBranchMap;
   TBranch *branch;
 
@@ -70,11 +249,203 @@ Bool_t ExRootTreeReader::ReadEntry(Long64_t entry)
     }
   }
 
+  if(!fLinkMap.empty())
+  {
+    map< TString, ExRootTreeLinks * >::iterator itLinkMap;
+
+    if(!fLinkArraysValid) UpdateLinkArrays();
+
+    for(itLinkMap = fLinkMap.begin(); itLinkMap != fLinkMap.end(); ++itLinkMap)
+    {
+      itLinkMap->second->ReadEntry(treeEntry);
+    }
+  }
+
+  UpdateReadStats();
+
   return kTRUE;
 }
 
 //------------------------------------------------------------------------------
 
+Long64_t ExRootTreeReader::ReadCluster(Long64_t entry)
+{
+  map< TString, ExRootTreeColumn * >::iterator itColumnMap;
+  Long64_t treeEntry, offset, last, i;
+
+  for(itColumnMap = fColumnMap.begin(); itColumnMap != fColumnMap.end(); ++itColumnMap)
+  {
+    itColumnMap->second->Clear(entry);
+  }
+
+  if(!LoadTree(entry, treeEntry)) return entry;
+
+  // clusters don't span several files of a chain
+  TTree::TClusterIterator itCluster = fChain->GetTree()->GetClusterIterator(treeEntry);
+  itCluster.Next();
+
+  offset = entry - treeEntry;
+  last = offset + itCluster.GetNextEntry();
+  if(last > GetLastEntry()) last = GetLastEntry();
+
+  for(i = entry; i < last; ++i)
+  {
+    for(itColumnMap = fColumnMap.begin(); itColumnMap != fColumnMap.end(); ++itColumnMap)
+    {
+      itColumnMap->second->ReadEntry(i - offset);
+    }
+  }
+
+  UpdateReadStats();
+
+  return last > entry ? last : entry + 1;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeReader::SetEntryRange(Long64_t first, Long64_t last)
+{
+  fFirstEntry = first;
+  fLastEntry = last;
+  if(fChain) fChain->SetCacheEntryRange(first, last);
+}
+
+//------------------------------------------------------------------------------
+
+Long64_t ExRootTreeReader::GetClusterStart(Long64_t entry)
+{
+  if(!fChain) return entry;
+
+  Long64_t treeEntry = fChain->LoadTree(entry);
+  if(treeEntry < 0) return entry;
+
+  // LoadTree may have opened another file of the chain,
+  // branch addresses are set again by the next ReadEntry
+  fCurrentTree = -1;
+
+  TTree::TClusterIterator itCluster = fChain->GetTree()->GetClusterIterator(treeEntry);
+
+  return entry - treeEntry + itCluster.GetStartEntry();
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeReader::SetReadThreads(Int_t threads, Long64_t cacheSize)
+{
+  if(!fChain || threads <= 0) return;
+
+#if defined(R__USE_IMT) && ROOT_VERSION_CODE >= ROOT_VERSION(6, 12, 0)
+  if(!ROOT::IsImplicitMTEnabled()) ROOT::EnableImplicitMT(threads);
+#endif
+
+  // the cache reads whole clusters, the unzip cache decompresses their
+  // baskets in parallel before the branches ask for them
+  if(!TTreeCacheUnzip::IsParallelUnzip()) TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+  fCacheSize = cacheSize;
+  fCacheValid = kFALSE;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeReader::SetCacheSize(Long64_t cacheSize, Int_t learnEntries)
+{
+  fCacheSize = cacheSize;
+  fLearnEntries = learnEntries;
+  fCacheValid = kFALSE;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeReader::UpdateCache()
+{
+  TBranchMap::iterator itBranchMap;
+  map< TString, ExRootTreeLinks * >::iterator itLinkMap;
+  map< TString, ExRootTreeColumn * >::iterator itColumnMap;
+  vector< TBranch * >::iterator itBranches;
+  ExRootTreeColumn *column;
+  UInt_t found;
+
+  fCacheValid = kTRUE;
+
+  if(!fChain || fCacheSize <= 0) return;
+
+  // disable all branches but the used ones, a TChain keeps the
+  // list of statuses and applies it to the next files
+  fChain->SetBranchStatus("*", 0, &found);
+
+  for(itBranchMap = fBranchMap.begin(); itBranchMap != fBranchMap.end(); ++itBranchMap)
+  {
+    fChain->SetBranchStatus(itBranchMap->first, 1, &found);
+    fChain->SetBranchStatus(itBranchMap->first + ".*", 1, &found);
+  }
+
+  for(itLinkMap = fLinkMap.begin(); itLinkMap != fLinkMap.end(); ++itLinkMap)
+  {
+    vector< TBranch * > &branches = itLinkMap->second->fBranches;
+    for(itBranches = branches.begin(); itBranches != branches.end(); ++itBranches)
+    {
+      fChain->SetBranchStatus((*itBranches)->GetName(), 1, &found);
+    }
+  }
+
+  for(itColumnMap = fColumnMap.begin(); itColumnMap != fColumnMap.end(); ++itColumnMap)
+  {
+    column = itColumnMap->second;
+    if(column->fCounter) fChain->SetBranchStatus(column->fCounter->GetName(), 1, &found);
+    fChain->SetBranchStatus(column->fName, 1, &found);
+  }
+
+  // the cache of the current file only prefetches the used branches
+  fChain->SetCacheSize(fCacheSize);
+  fChain->SetCacheEntryRange(fFirstEntry, GetLastEntry());
+  fChain->SetCacheLearnEntries(fLearnEntries);
+
+  for(itBranchMap = fBranchMap.begin(); itBranchMap != fBranchMap.end(); ++itBranchMap)
+  {
+    if(itBranchMap->second.first) fChain->AddBranchToCache(itBranchMap->first, kTRUE);
+  }
+
+  for(itLinkMap = fLinkMap.begin(); itLinkMap != fLinkMap.end(); ++itLinkMap)
+  {
+    vector< TBranch * > &branches = itLinkMap->second->fBranches;
+    for(itBranches = branches.begin(); itBranches != branches.end(); ++itBranches)
+    {
+      fChain->AddBranchToCache((*itBranches)->GetName());
+    }
+  }
+
+  for(itColumnMap = fColumnMap.begin(); itColumnMap != fColumnMap.end(); ++itColumnMap)
+  {
+    column = itColumnMap->second;
+    if(column->fCounter) fChain->AddBranchToCache(column->fCounter->GetName());
+    fChain->AddBranchToCache(column->fName);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeReader::UpdateReadStats()
+{
+  TFile *file = fChain->GetCurrentFile();
+
+  if(file != fStatsFile)
+  {
+    fBytesRead += fFileBytesRead;
+    fReadCalls += fFileReadCalls;
+    fFileBytesRead = 0;
+    fFileReadCalls = 0;
+    fStatsFile = file;
+  }
+
+  if(file)
+  {
+    fFileBytesRead = file->GetBytesRead();
+    fFileReadCalls = file->GetReadCalls();
+  }
+}
+
+//------------------------------------------------------------------------------
+
 TClonesArray *ExRootTreeReader::UseBranch(const char *branchName)
 {
   TClonesArray *array = 0;
@@ -103,6 +474,8 @@ TClonesArray *ExRootTreeReader::UseBranch(const char *branchName)
           array->SetName(branchName);
           fBranchMap.insert(make_pair(branchName, make_pair(branch, array)));
           branch->SetAddress(&array);
+          fLinkArraysValid = kFALSE;
+          fCacheValid = kFALSE;
         }
       }
     }
@@ -118,6 +491,54 @@ TClonesArray *ExRootTreeReader::UseBranch(const char *branchName)
 
 //------------------------------------------------------------------------------
 
+ExRootTreeLinks *ExRootTreeReader::UseLinks(const char *linkName)
+{
+  ExRootTreeLinks *links = 0;
+
+  map< TString, ExRootTreeLinks * >::iterator itLinkMap = fLinkMap.find(linkName);
+
+  if(itLinkMap != fLinkMap.end())
+  {
+    cout << "** WARNING: links '" << linkName << "' are already in use" << endl;
+    return itLinkMap->second;
+  }
+
+  links = new ExRootTreeLinks(linkName);
+  if(!fChain || !links->Notify(fChain))
+  {
+    cout << "** WARNING: cannot access links '" << linkName << "', return NULL pointer" << endl;
+    delete links;
+    return 0;
+  }
+
+  links->fArrays = &fLinkArrays;
+  fLinkMap.insert(make_pair(linkName, links));
+  fLinkArraysValid = kFALSE;
+  fCacheValid = kFALSE;
+
+  return links;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeReader::UpdateLinkArrays()
+{
+  TBranchMap::iterator itBranchMap;
+  TList *info = fChain->GetTree() ? fChain->GetTree()->GetUserInfo() : 0;
+  Int_t i, size = info ? info->GetSize() : 0;
+
+  fLinkArrays.assign(size, 0);
+  for(i = 0; i < size; ++i)
+  {
+    itBranchMap = fBranchMap.find(info->At(i)->GetName());
+    if(itBranchMap != fBranchMap.end()) fLinkArrays[i] = itBranchMap->second.second;
+  }
+
+  fLinkArraysValid = kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
 Bool_t ExRootTreeReader::Notify()
 {
   // Called when loading a new file.
@@ -140,8 +561,60 @@ Bool_t ExRootTreeReader::Notify()
       cout << "** WARNING: cannot get branch '" << itBranchMap->first << "'" << endl;
     }
   }
+
+  map< TString, ExRootTreeLinks * >::iterator itLinkMap;
+
+  for(itLinkMap = fLinkMap.begin(); itLinkMap != fLinkMap.end(); ++itLinkMap)
+  {
+    if(!itLinkMap->second->Notify(fChain))
+    {
+      cout << "** WARNING: cannot get links '" << itLinkMap->first << "'" << endl;
+    }
+  }
+  fLinkArraysValid = kFALSE;
+
+  map< TString, ExRootTreeColumn * >::iterator itColumnMap;
+
+  for(itColumnMap = fColumnMap.begin(); itColumnMap != fColumnMap.end(); ++itColumnMap)
+  {
+    if(!itColumnMap->second->Notify(fChain))
+    {
+      cout << "** WARNING: cannot get column '" << itColumnMap->first << "'" << endl;
+    }
+  }
+
+  // the cache of the new file starts empty
+  UpdateCache();
+
   return kTRUE;
 }
 
 //------------------------------------------------------------------------------
 
+ExRootTreeColumn *ExRootTreeReader::UseColumn(const char *columnName)
+{
+  ExRootTreeColumn *column = 0;
+
+  map< TString, ExRootTreeColumn * >::iterator itColumnMap = fColumnMap.find(columnName);
+
+  if(itColumnMap != fColumnMap.end())
+  {
+    cout << "** WARNING: column '" << columnName << "' is already in use" << endl;
+    return itColumnMap->second;
+  }
+
+  column = new ExRootTreeColumn(columnName);
+  if(!fChain || !column->Notify(fChain))
+  {
+    cout << "** WARNING: cannot access column '" << columnName << "', return NULL pointer" << endl;
+    delete column;
+    return 0;
+  }
+
+  fColumnMap.insert(make_pair(columnName, column));
+  fCacheValid = kFALSE;
+
+  return column;
+}
+
+//------------------------------------------------------------------------------
@@ -15,6 +15,94 @@
 #include "TFile.h"
 
 #include <map>
+#include <vector>
+
+class TLeaf;
+
+/** \class ExRootTreeLinks
+ *
+ *  Resolves links written as entry indices by ExRootTreeLinkBranch
+ *  or ExRootTreeFlatBranch, e.g. "Jet.Particles" or "Track.Particle"
+ *
+ */
+
+class ExRootTreeLinks
+{
+  friend class ExRootTreeReader;
+
+public:
+
+  ExRootTreeLinks(const char *name);
+
+  // number of links of entry of the parent branch
+  Int_t GetSize(Int_t entry) const;
+
+  // linked entry index and branch id, -1 if the linked object was not written
+  Int_t GetIndex(Int_t entry, Int_t i = 0) const;
+  Int_t GetBranch(Int_t entry, Int_t i = 0) const;
+
+  // linked object, 0 if its branch is not used by the reader
+  TObject *At(Int_t entry, Int_t i = 0) const;
+
+private:
+
+  Bool_t Notify(TTree *tree);
+  void ReadEntry(Long64_t entry);
+
+  TString fName, fParent, fRelation; //!
+
+  std::vector< TBranch * > fBranches; //!
+  TLeaf *fBegin, *fEnd, *fIndex, *fBranch; //!
+
+  const std::vector< TClonesArray * > *fArrays; //!
+};
+
+//------------------------------------------------------------------------------
+
+/** \class ExRootTreeColumn
+ *
+ *  Values of a flat branch written with 'set Columnar true', e.g. "Jet.PT",
+ *  for all entries of a cluster of baskets, in one contiguous array
+ *
+ */
+
+class ExRootTreeColumn
+{
+  friend class ExRootTreeReader;
+
+public:
+
+  ExRootTreeColumn(const char *name);
+
+  // entries [first, last) read by the last ExRootTreeReader::ReadCluster
+  Long64_t GetFirstEntry() const { return fFirstEntry; }
+  Long64_t GetLastEntry() const { return fFirstEntry + fOffsets.size() - 1; }
+
+  // values of all entries, the values of entry are
+  // [GetOffset(entry), GetOffset(entry) + GetSize(entry))
+  const std::vector< Double_t > &GetValues() const { return fValues; }
+
+  Int_t GetOffset(Long64_t entry) const { return fOffsets[entry - fFirstEntry]; }
+  Int_t GetSize(Long64_t entry) const { return fOffsets[entry - fFirstEntry + 1] - fOffsets[entry - fFirstEntry]; }
+
+private:
+
+  Bool_t Notify(TTree *tree);
+  void Clear(Long64_t first);
+  void ReadEntry(Long64_t entry);
+
+  TString fName; //!
+
+  TBranch *fCounter, *fBranch; //!
+  TLeaf *fLeaf; //!
+
+  Long64_t fFirstEntry; //!
+
+  std::vector< Double_t > fValues; //!
+  std::vector< Int_t > fOffsets; //!
+};
+
+//------------------------------------------------------------------------------
 
 class ExRootTreeReader : public TNamed
 {
@@ -28,19 +116,70 @@ public :
   Long64_t GetEntries() const { return fChain ? static_cast<Long64_t>(fChain->GetEntries()) : 0; }
   Bool_t ReadEntry(Long64_t entry);
 
+  // restricts read-ahead to the entries [first, last) processed by this reader
+  void SetEntryRange(Long64_t first, Long64_t last);
+  Long64_t GetFirstEntry() const { return fFirstEntry; }
+  Long64_t GetLastEntry() const { return fLastEntry >= 0 ? fLastEntry : GetEntries(); }
+
+  // first entry of the cluster of baskets containing entry,
+  // entry ranges of parallel readers should start at cluster boundaries
+  Long64_t GetClusterStart(Long64_t entry);
+
+  // decompresses the baskets of the read-ahead cache on a pool of threads
+  void SetReadThreads(Int_t threads, Long64_t cacheSize = 30000000);
+
+  // read-ahead cache restricted to the used branches, the other branches
+  // are disabled; the cache learns the access pattern over learnEntries,
+  // cacheSize = 0 (the default) leaves the branch status and the cache of
+  // the tree alone, so that code reading branches directly from the tree
+  // still gets them
+  void SetCacheSize(Long64_t cacheSize, Int_t learnEntries = 10);
+
+  // bytes read from the input files and number of read calls
+  Long64_t GetBytesRead() const { return fBytesRead + fFileBytesRead; }
+  Long64_t GetReadCalls() const { return fReadCalls + fFileReadCalls; }
+
   TClonesArray *UseBranch(const char *branchName);
+  ExRootTreeLinks *UseLinks(const char *linkName);
+  ExRootTreeColumn *UseColumn(const char *columnName);
+
+  // reads the used columns from entry to the end of its cluster of baskets,
+  // within the entry range, returns the entry after the last one read
+  Long64_t ReadCluster(Long64_t entry);
 
 private:
 
   Bool_t Notify();
+  Bool_t LoadTree(Long64_t entry, Long64_t &treeEntry);
+  void UpdateLinkArrays();
+  void UpdateCache();
+  void UpdateReadStats();
 
   TTree *fChain; //! pointer to the analyzed TTree or TChain
   Int_t fCurrentTree; //! current Tree number in a TChain
 
+  Long64_t fFirstEntry, fLastEntry; //! entry range of this reader
+
+  Long64_t fCacheSize; //! read-ahead cache size, 0 if not managed by the reader
+  Int_t fLearnEntries; //!
+  Bool_t fCacheValid; //!
+
+  TFile *fStatsFile; //! only compared, the chain owns and deletes its files
+  Long64_t fBytesRead, fReadCalls; //! read statistics of the previous files
+  Long64_t fFileBytesRead, fFileReadCalls; //! read statistics of the current file
+
   typedef std::map<TString, std::pair<TBranch*, TClonesArray*> > TBranchMap;
 
   TBranchMap fBranchMap; //!
 
+  std::map< TString, ExRootTreeLinks * > fLinkMap; //!
+
+  std::map< TString, ExRootTreeColumn * > fColumnMap; //!
+
+  // arrays of the used branches indexed by the branch ids of the tree user info
+  std::vector< TClonesArray * > fLinkArrays; //!
+  Bool_t fLinkArraysValid; //!
+
   ClassDef(ExRootTreeReader, 1)
 };
 
@@ -9,10 +9,17 @@
 
 #include "ExRootAnalysis/ExRootTreeWriter.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeFlatBranch.h"
+#include "ExRootAnalysis/ExRootTreeLinkBranch.h"
 
+#include "RVersion.h"
+#include "RConfigure.h"
 #include "TROOT.h"
 #include "TFile.h"
+#include "TList.h"
 #include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
 #include "TClonesArray.h"
 
 #include <iostream>
@@ -22,7 +29,10 @@
 using namespace std;
 
 ExRootTreeWriter::ExRootTreeWriter(TFile *file, const char *treeName) :
-  fFile(file), fTree(0), fTreeName(treeName)
+  fFile(file), fTree(0), fTreeName(treeName),
+  fBasketSize(0), fCompressionSettings(-1), fAutoFlush(0),
+  fAutoSave(10000000), fImplicitMT(kFALSE), fSkipEvent(kFALSE),
+  fFlatIndex(0)
 {
 }
 
@@ -36,6 +46,20 @@ ExRootTreeWriter::~ExRootTreeWriter()
     delete (*itBranches);
   }
 
+  vector<ExRootTreeFlatBranch*>::iterator itFlatBranches;
+  for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+  {
+    delete (*itFlatBranches);
+  }
+
+  vector<ExRootTreeLinkBranch*>::iterator itLinkBranches;
+  for(itLinkBranches = fLinkBranches.begin(); itLinkBranches != fLinkBranches.end(); ++itLinkBranches)
+  {
+    delete (*itLinkBranches);
+  }
+
+  if(fFlatIndex) delete fFlatIndex;
+
   if(fTree) delete fTree;
 }
 
@@ -46,18 +70,167 @@ ExRootTreeBranch *ExRootTreeWriter::NewBranch(const char *name, TClass *cl)
   if(!fTree) fTree = NewTree();
   ExRootTreeBranch *branch = new ExRootTreeBranch(name, cl, fTree);
   fBranches.insert(branch);
+  if(fTree)
+  {
+    RegisterBranch(branch);
+    ConfigureBranches(fTree->GetListOfBranches());
+  }
   return branch;
 }
 
 //------------------------------------------------------------------------------
 
+ExRootTreeBranch *ExRootTreeWriter::NewFlatBranch(const char *name, TClass *cl, Bool_t references)
+{
+  if(!fTree) fTree = NewTree();
+  // without output file the entries are only kept in memory
+  if(!fTree) return NewBranch(name, cl);
+  if(!fFlatIndex) fFlatIndex = new ExRootTreeFlatIndex;
+  ExRootTreeFlatBranch *flatBranch = new ExRootTreeFlatBranch(name, cl, fTree, fBasketSize > 0 ? fBasketSize : 64000, references);
+  fFlatBranches.push_back(flatBranch);
+  fBranches.insert(flatBranch->GetBranch());
+  RegisterBranch(flatBranch->GetBranch());
+  ConfigureBranches(fTree->GetListOfBranches());
+  return flatBranch->GetBranch();
+}
+
+//------------------------------------------------------------------------------
+
+ExRootTreeLinkBranch *ExRootTreeWriter::NewLinkBranch(const char *parent, const char *relation, Bool_t single)
+{
+  if(!fTree) fTree = NewTree();
+  if(!fTree) return 0;
+  if(!fFlatIndex) fFlatIndex = new ExRootTreeFlatIndex;
+  ExRootTreeLinkBranch *linkBranch = new ExRootTreeLinkBranch(parent, relation, single, fTree, fBasketSize > 0 ? fBasketSize : 64000);
+  fLinkBranches.push_back(linkBranch);
+  ConfigureBranches(fTree->GetListOfBranches());
+  return linkBranch;
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::RegisterBranch(ExRootTreeBranch *branch)
+{
+  // branch ids used by flat and link branches are the positions in the user info
+  fBranchIds.push_back(branch);
+  fTree->GetUserInfo()->Add(new TNamed(branch->GetData()->GetName(), branch->GetData()->GetClass()->GetName()));
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetBasketSize(Int_t size)
+{
+  fBasketSize = size;
+  if(fTree) ConfigureBranches(fTree->GetListOfBranches());
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetCompressionSettings(Int_t settings)
+{
+  fCompressionSettings = settings;
+  if(fTree) ConfigureBranches(fTree->GetListOfBranches());
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetAutoFlush(Long64_t autoFlush)
+{
+  fAutoFlush = autoFlush;
+  if(fTree && fAutoFlush != 0) fTree->SetAutoFlush(fAutoFlush);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetAutoSave(Long64_t autoSave)
+{
+  fAutoSave = autoSave;
+  if(fTree) fTree->SetAutoSave(fAutoSave);
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::SetCompressionThreads(Int_t threads)
+{
+  if(threads <= 0) return;
+
+#if defined(R__USE_IMT) && ROOT_VERSION_CODE >= ROOT_VERSION(6, 10, 0)
+  // baskets are then compressed by a pool of worker tasks when TTree::Fill
+  // flushes a cluster, Fill returns only once the cluster has been written
+  if(!ROOT::IsImplicitMTEnabled())
+  {
+    ROOT::EnableImplicitMT(threads);
+  }
+  else if(ROOT::GetImplicitMTPoolSize() != UInt_t(threads))
+  {
+    // the pool is shared by the whole process and cannot be resized
+    cout << "** WARNING: ROOT implicit multi-threading is already enabled with ";
+    cout << ROOT::GetImplicitMTPoolSize() << " threads, ";
+    cout << threads << " compression threads are ignored" << endl;
+  }
+  fImplicitMT = kTRUE;
+  if(fTree) fTree->SetImplicitMT(kTRUE);
+#else
+  cout << "** WARNING: ROOT was built without implicit multi-threading, ";
+  cout << "baskets are compressed sequentially" << endl;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+void ExRootTreeWriter::ConfigureBranches(TObjArray *branches)
+{
+  TBranch *branch;
+  TIter iterator(branches);
+  while((branch = static_cast<TBranch*>(iterator.Next())))
+  {
+    if(fBasketSize > 0) branch->SetBasketSize(fBasketSize);
+    if(fCompressionSettings >= 0) branch->SetCompressionSettings(fCompressionSettings);
+    ConfigureBranches(branch->GetListOfBranches());
+  }
+}
+
+//------------------------------------------------------------------------------
+
 void ExRootTreeWriter::Fill()
 {
+  vector<ExRootTreeFlatBranch*>::iterator itFlatBranches;
+  vector<ExRootTreeLinkBranch*>::iterator itLinkBranches;
+  size_t i;
+
+  if(fSkipEvent) return;
+
+  if(fFlatIndex)
+  {
+    // resolve references to entries of all branches before filling the columns
+    fFlatIndex->Clear();
+    for(i = 0; i < fBranchIds.size(); ++i)
+    {
+      fFlatIndex->Add(fBranchIds[i], i);
+    }
+    for(itFlatBranches = fFlatBranches.begin(); itFlatBranches != fFlatBranches.end(); ++itFlatBranches)
+    {
+      (*itFlatBranches)->Fill(fFlatIndex);
+    }
+    for(itLinkBranches = fLinkBranches.begin(); itLinkBranches != fLinkBranches.end(); ++itLinkBranches)
+    {
+      (*itLinkBranches)->Fill(fFlatIndex);
+    }
+  }
+
   if(fTree) fTree->Fill();
 }
 
 //------------------------------------------------------------------------------
 
+void ExRootTreeWriter::ChangeFile(TFile *file)
+{
+  fFile = file;
+  if(fTree) fTree->SetDirectory(file);
+}
+
+//------------------------------------------------------------------------------
+
 void ExRootTreeWriter::Write()
 {
   fFile = fTree ? fTree->GetCurrentFile() : 0;
@@ -69,10 +242,19 @@ void ExRootTreeWriter::Write()
 void ExRootTreeWriter::Clear()
 {
   set<ExRootTreeBranch*>::iterator itBranches;
+  vector<ExRootTreeLinkBranch*>::iterator itLinkBranches;
+
+  fSkipEvent = kFALSE;
+
   for(itBranches = fBranches.begin(); itBranches != fBranches.end(); ++itBranches)
   {
     (*itBranches)->Clear();
   }
+
+  for(itLinkBranches = fLinkBranches.begin(); itLinkBranches != fLinkBranches.end(); ++itLinkBranches)
+  {
+    (*itLinkBranches)->Clear();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -94,7 +276,11 @@ TTree *ExRootTreeWriter::NewTree()
   }
 
   tree->SetDirectory(fFile);
-  tree->SetAutoSave(10000000);  // autosave when 10 MB written
+  tree->SetAutoSave(fAutoSave);
+  if(fAutoFlush != 0) tree->SetAutoFlush(fAutoFlush);
+#if defined(R__USE_IMT) && ROOT_VERSION_CODE >= ROOT_VERSION(6, 10, 0)
+  tree->SetImplicitMT(fImplicitMT);
+#endif
 
   return tree;
 }
@@ -12,11 +12,16 @@
 #include "TNamed.h"
 
 #include <set>
+#include <vector>
 
 class TFile;
 class TTree;
 class TClass;
+class TObjArray;
 class ExRootTreeBranch;
+class ExRootTreeFlatBranch;
+class ExRootTreeFlatIndex;
+class ExRootTreeLinkBranch;
 
 class ExRootTreeWriter : public TNamed
 {
@@ -28,7 +33,28 @@ public:
   void SetTreeFile(TFile *file) { fFile = file; }
   void SetTreeName(const char *name) { fTreeName = name; }
 
+  // moves the tree, still without entries, to another file
+  void ChangeFile(TFile *file);
+
+  // basket size in bytes, 0 keeps the default
+  void SetBasketSize(Int_t size);
+  // ROOT compression settings (100*algorithm + level), -1 keeps the file settings
+  void SetCompressionSettings(Int_t settings);
+  // number of entries (> 0) or of bytes (< 0) between flushes, 0 keeps the default
+  void SetAutoFlush(Long64_t autoFlush);
+  // number of entries (> 0) or of bytes (< 0) between autosaves, 0 disables autosave
+  void SetAutoSave(Long64_t autoSave);
+  // compress baskets with ROOT implicit multi-threading, 0 threads keeps compression sequential;
+  // this enables implicit multi-threading for the whole process (other trees, RDataFrame, ...),
+  // a pool already enabled with another number of threads is kept as is
+  void SetCompressionThreads(Int_t threads);
+
   ExRootTreeBranch *NewBranch(const char *name, TClass *cl);
+  ExRootTreeBranch *NewFlatBranch(const char *name, TClass *cl, Bool_t references = kTRUE);
+  ExRootTreeLinkBranch *NewLinkBranch(const char *parent, const char *relation, Bool_t single);
+
+  // the current event is not written, until the next call to Clear
+  void SkipEvent() { fSkipEvent = kTRUE; }
 
   void Clear();
   void Fill();
@@ -38,12 +64,27 @@ private:
 
   TTree *NewTree();
 
+  void ConfigureBranches(TObjArray *branches);
+  void RegisterBranch(ExRootTreeBranch *branch);
+
   TFile *fFile; //!
   TTree *fTree; //!
 
   TString fTreeName; //!
 
+  Int_t fBasketSize; //!
+  Int_t fCompressionSettings; //!
+  Long64_t fAutoFlush; //!
+  Long64_t fAutoSave; //!
+  Bool_t fImplicitMT; //!
+  Bool_t fSkipEvent; //!
+
   std::set<ExRootTreeBranch*> fBranches; //!
+  std::vector<ExRootTreeBranch*> fBranchIds; //!
+  std::vector<ExRootTreeFlatBranch*> fFlatBranches; //!
+  std::vector<ExRootTreeLinkBranch*> fLinkBranches; //!
+
+  ExRootTreeFlatIndex *fFlatIndex; //!
 
   ClassDef(ExRootTreeWriter, 1)
 };
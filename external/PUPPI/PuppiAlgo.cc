@@ -37,6 +37,7 @@ PuppiAlgo::PuppiAlgo(AlgoObj &iAlgo) {
     double pMean = 0;
     int    pNCount = 0; 
     fRMS   .push_back(pRMS);
+    fInvRMS2.push_back(pRMS);
     fMedian.push_back(pMed);
     fMean  .push_back(pMean);
     fNCount.push_back(pNCount);
@@ -62,6 +63,7 @@ void PuppiAlgo::reset() {
   for(unsigned int i0 = 0; i0 < fNAlgos; i0++) { 
     fMedian[i0] =  0; 
     fRMS   [i0] =  0;
+    fInvRMS2[i0] = 0;
     fMean  [i0] =  0;
     fNCount[i0] =  0;
   }
@@ -123,6 +125,7 @@ void PuppiAlgo::computeMedRMS(const unsigned int &iAlgo,const double &iPVFrac) {
       fRMS[iAlgo]    -= sqrt(ROOT::Math::chisquared_quantile(lAdjust,1.)*fRMS[iAlgo]);
     }        
   }
+  fInvRMS2[iAlgo] = 1./fRMS[iAlgo]/fRMS[iAlgo];
   /* eta extrapolated version
   for (unsigned int j0 = 0; j0 < fEtaMin.size(); j0++){
     fRMS_perEta[iAlgo][j0]    = fRMS[iAlgo]*fRMSEtaSF[j0];
@@ -131,7 +134,7 @@ void PuppiAlgo::computeMedRMS(const unsigned int &iAlgo,const double &iPVFrac) {
   */
 }
 //This code is probably a bit confusing
-double PuppiAlgo::compute(std::vector<double> &iVals,double iChi2) { 
+double PuppiAlgo::compute(const double *iVals,double iChi2) { 
   if(fAlgoId[0] == -1) return 1;
   double lVal  = 0.;
   double lPVal = 1.;
@@ -149,7 +152,7 @@ double PuppiAlgo::compute(std::vector<double> &iVals,double iChi2) {
     if(fAlgoId[i0] == 0 && iVals[i0] == 0) pVal = fMedian[i0];
     if(fAlgoId[i0] == 3 && iVals[i0] == 0) pVal = fMedian[i0];
     if(fAlgoId[i0] == 5 && iVals[i0] == 0) pVal = fMedian[i0];
-    lVal += (pVal-fMedian[i0])*(fabs(pVal-fMedian[i0]))/fRMS[i0]/fRMS[i0];
+    lVal += (pVal-fMedian[i0])*(fabs(pVal-fMedian[i0]))*fInvRMS2[i0];
     lNDOF++;
     if(i0 == 0 && iChi2 != 0) lNDOF++;      //Add external Chi2 to first element
     if(i0 == 0 && iChi2 != 0) lVal+=iChi2;  //Add external Chi2 to first element
@@ -11,7 +11,7 @@ public:
   void   add(const fastjet::PseudoJet &iParticle,const double &iVal,const unsigned int iAlgo);
   void   computeMedRMS(const unsigned int &iAlgo,const double &iPVFrac);
   //Get the Weight
-  double compute(std::vector<double> &iVals,double iChi2);
+  double compute(const double *iVals,double iChi2);
   //Helpers
   double ptMin();
   double etaMin();
@@ -42,6 +42,7 @@ private:
   std::vector<double> fRMSPtMin;
   std::vector<double> fRMSScaleFactor;
   std::vector<double> fRMS;
+  std::vector<double> fInvRMS2;
   std::vector<double> fMedian;
   std::vector<double> fMean;
   std::vector<int>    fNCount;
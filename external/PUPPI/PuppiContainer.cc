@@ -5,111 +5,190 @@
 #include <iostream>
 #include <math.h>
 
-PuppiContainer::PuppiContainer(bool iApplyCHS, bool iUseExp,double iPuppiWeightCut,std::vector<AlgoObj> &iAlgos) { 
+PuppiContainer::PuppiContainer(bool iApplyCHS, bool iUseExp,double iPuppiWeightCut,std::vector<AlgoObj> &iAlgos) {
   fApplyCHS        = iApplyCHS;
   fUseExp          = iUseExp;
   fPuppiWeightCut  = iPuppiWeightCut;
   fNAlgos = iAlgos.size();
-  for(unsigned int i0 = 0; i0 < iAlgos.size(); i0++) { 
+  for(unsigned int i0 = 0; i0 < iAlgos.size(); i0++) {
     PuppiAlgo pPuppiConfig(iAlgos[i0]);
     fPuppiAlgo.push_back(pPuppiConfig);
   }
+  //The tiles are at least as large as the largest cone
+  fNMaxAlgo = 1;
+  fTileSize = 0.1;
+  for(int i0 = 0; i0 < fNAlgos; i0++) {
+    fNMaxAlgo = TMath::Max(fPuppiAlgo[i0].numAlgos(),fNMaxAlgo);
+    for(int i1 = 0; i1 < fPuppiAlgo[i0].numAlgos(); i1++) fTileSize = TMath::Max(fPuppiAlgo[i0].coneSize(i1),fTileSize);
+  }
+  fNPhiTiles = int(2.*M_PI/fTileSize);
+  if(fNPhiTiles < 1) fNPhiTiles = 1;
+  fPhiTileSize = 2.*M_PI/fNPhiTiles;
+  fRapMin    = 0;
+  fNRapTiles = 1;
+  fSubIds  .resize(fNMaxAlgo);
+  fSubCone2.resize(fNMaxAlgo);
+  fSums    .resize(fNMaxAlgo);
 }
 
-void PuppiContainer::initialize(const std::vector<RecoObj> &iRecoObjects) { 
-  //Clear everything
+void PuppiContainer::initialize(const std::vector<RecoObj> &iRecoObjects) {
+  //Clear everything, the containers keep their capacity from event to event
   fRecoParticles.resize(0);
   fPFParticles  .resize(0);
   fChargedPV    .resize(0);
   fPupParticles .resize(0);
   fWeights      .resize(0);
   fVals.resize(0);
+  fRap   .resize(0);
+  fPhi   .resize(0);
+  fEta   .resize(0);
+  fPt    .resize(0);
+  fPupIds.resize(0);
+  fIndices[0].resize(0);
+  fIndices[1].resize(0);
   //fChargedNoPV.resize(0);
   //Link to the RecoObjects
-  fPVFrac = 0.; 
+  fPVFrac = 0.;
   fNPV    = 1.;
   fRecoParticles = iRecoObjects;
   for (unsigned int i = 0; i < fRecoParticles.size(); i++){
     fastjet::PseudoJet curPseudoJet;
     curPseudoJet.reset_PtYPhiM(fRecoParticles[i].pt,fRecoParticles[i].eta,fRecoParticles[i].phi,fRecoParticles[i].m);
     if(fRecoParticles[i].id == 0 or  fRecoParticles[i].charge == 0)  curPseudoJet.set_user_index(0); // zero is neutral hadron
-    if(fRecoParticles[i].id == 1 and fRecoParticles[i].charge != 0) curPseudoJet.set_user_index(fRecoParticles[i].charge); // from PV use the                             
+    if(fRecoParticles[i].id == 1 and fRecoParticles[i].charge != 0) curPseudoJet.set_user_index(fRecoParticles[i].charge); // from PV use the
     if(fRecoParticles[i].id == 2 and fRecoParticles[i].charge != 0) curPseudoJet.set_user_index(fRecoParticles[i].charge+5); // from NPV use the charge as key +5 as key           // fill vector of pseudojets for internal references
     fPFParticles.push_back(curPseudoJet);
+    fRap.push_back(curPseudoJet.rap());
+    fPhi.push_back(curPseudoJet.phi());
+    fEta.push_back(curPseudoJet.eta());
+    fPt .push_back(curPseudoJet.pt());
+    fPupIds.push_back(getPuppiId(curPseudoJet.pt(),curPseudoJet.eta()));
+    fIndices[0].push_back(i);
     //Take Charged particles associated to PV
     if(fabs(fRecoParticles[i].id) == 1) fChargedPV.push_back(curPseudoJet);
+    if(fabs(fRecoParticles[i].id) == 1) fIndices[1].push_back(i);
     if(fabs(fRecoParticles[i].id) >= 1 ) fPVFrac+=1.;
     if(fNPV < fRecoParticles[i].vtxId) fNPV = fRecoParticles[i].vtxId;
   }
   //if(fNPV < 10) fNPV = 80.;
   if(fPVFrac != 0) { fPVFrac = double(fChargedPV.size())/fPVFrac;}
   else { fPVFrac = 0;}
+  //Sort the particles into eta-phi tiles, far forward rapidities are clamped to the edge tiles
+  const double lMaxRap = 10.;
+  double lRapMin = 0;
+  double lRapMax = 0;
+  for(unsigned int i0 = 0; i0 < fRap.size(); i0++) {
+    double pRap = TMath::Max(TMath::Min(fRap[i0],lMaxRap),-lMaxRap);
+    if(i0 == 0 || pRap < lRapMin) lRapMin = pRap;
+    if(i0 == 0 || pRap > lRapMax) lRapMax = pRap;
+  }
+  fRapMin    = lRapMin;
+  fNRapTiles = int((lRapMax-lRapMin)/fTileSize)+1;
+  fTiles.resize(fRap.size());
+  for(unsigned int i0 = 0; i0 < fRap.size(); i0++) {
+    double pRap = TMath::Max(TMath::Min(fRap[i0],lMaxRap),-lMaxRap);
+    int pRapTile = TMath::Min(int((pRap-fRapMin)/fTileSize),fNRapTiles-1);
+    int pPhiTile = TMath::Min(int(fPhi[i0]/fPhiTileSize),fNPhiTiles-1);
+    fTiles[i0] = pRapTile*fNPhiTiles+pPhiTile;
+  }
+  fillTiles(0,fIndices[0]);
+  fillTiles(1,fIndices[1]);
 }
 PuppiContainer::~PuppiContainer(){}
 
-double PuppiContainer::goodVar(fastjet::PseudoJet &iPart,std::vector<fastjet::PseudoJet> &iParts, int iOpt,double iRCone) {
-  double lPup = 0;
-  lPup = var_within_R(iOpt,iParts,iPart,iRCone);
-  return lPup;
+void PuppiContainer::fillTiles(int iColl,const std::vector<int> &iIndices) {
+  //Counting sort of the particles by tile, keeping their order inside a tile
+  std::vector<int> &lStart     = fTileStart[iColl];
+  std::vector<int> &lParticles = fTileParticles[iColl];
+  lStart.assign(fNRapTiles*fNPhiTiles+1,0);
+  lParticles.resize(iIndices.size());
+  for(unsigned int i0 = 0; i0 < iIndices.size(); i0++) lStart[fTiles[iIndices[i0]]+1]++;
+  for(unsigned int i0 = 1; i0 < lStart.size(); i0++) lStart[i0] += lStart[i0-1];
+  fTileCursor.assign(lStart.begin(),lStart.end()-1);
+  for(unsigned int i0 = 0; i0 < iIndices.size(); i0++) lParticles[fTileCursor[fTiles[iIndices[i0]]]++] = iIndices[i0];
+}
+//Adds the neighbours in the cones of the sub algos using the collection iColl,
+//selected as with fastjet::SelectorCircle and weighted as in the former var_within_R
+void PuppiContainer::sumWithinR(int iColl,int iParticle,int iPupId) {
+  PuppiAlgo &lAlgo = fPuppiAlgo[iPupId];
+  int lNSubs = 0;
+  double lR2Max = -1;
+  for(int i1 = 0; i1 < lAlgo.numAlgos(); i1++) {
+    if(lAlgo.algoId(i1) == -1 || int(lAlgo.isCharged(i1)) != iColl) continue;
+    fSubIds  [lNSubs] = i1;
+    fSubCone2[lNSubs] = lAlgo.coneSize(i1)*lAlgo.coneSize(i1);
+    if(fSubCone2[lNSubs] > lR2Max) lR2Max = fSubCone2[lNSubs];
+    lNSubs++;
+  }
+  if(lNSubs == 0) return;
+  const std::vector<int> &lStart     = fTileStart[iColl];
+  const std::vector<int> &lParticles = fTileParticles[iColl];
+  int lRapTile = fTiles[iParticle]/fNPhiTiles;
+  int lPhiTile = fTiles[iParticle]%fNPhiTiles;
+  int lNPhi    = fNPhiTiles < 3 ? fNPhiTiles : 3;
+  for(int i0 = lRapTile-1; i0 <= lRapTile+1; i0++) {
+    if(i0 < 0 || i0 >= fNRapTiles) continue;
+    for(int i1 = 0; i1 < lNPhi; i1++) {
+      int pTile = i0*fNPhiTiles + (fNPhiTiles < 3 ? i1 : (lPhiTile+i1-1+fNPhiTiles)%fNPhiTiles);
+      for(int i2 = lStart[pTile]; i2 < lStart[pTile+1]; i2++) {
+        int pId = lParticles[i2];
+        double pDPhi = fabs(fPhi[pId]-fPhi[iParticle]);
+        if(pDPhi > M_PI) pDPhi = 2.*M_PI-pDPhi;
+        double pDRap = fRap[pId]-fRap[iParticle];
+        double pDist2 = pDPhi*pDPhi+pDRap*pDRap;
+        if(pDist2 > lR2Max) continue;
+        double pDEta = fEta[pId]-fEta[iParticle];
+        pDPhi = fabs(fPhi[pId]-fPhi[iParticle]);
+        if(pDPhi > 2.*3.14159265-pDPhi) pDPhi =  2.*3.14159265-pDPhi;
+        double pDR2 = pDEta*pDEta+pDPhi*pDPhi;
+        if(std::abs(pDR2)  <  0.0001) continue;
+        double pPt = fPt[pId];
+        for(int i3 = 0; i3 < lNSubs; i3++) {
+          if(pDist2 > fSubCone2[i3]) continue;
+          int pAlgo = lAlgo.algoId(fSubIds[i3]);
+          double &pSum = fSums[fSubIds[i3]];
+          if(pAlgo == 0) pSum += (pPt/pDR2);
+          if(pAlgo == 1) pSum += pPt;
+          if(pAlgo == 2) pSum += (1./pDR2);
+          if(pAlgo == 3) pSum += (1./pDR2);
+          if(pAlgo == 4) pSum += pPt;
+          if(pAlgo == 5) pSum += (pPt*(pPt/pDR2));
+        }
+      }
+    }
+  }
 }
-double PuppiContainer::var_within_R(int iId, const vector<fastjet::PseudoJet> & particles, const fastjet::PseudoJet& centre, double R){
-  if(iId == -1) return 1;
-  fastjet::Selector sel = fastjet::SelectorCircle(R);
-  sel.set_reference(centre);
-  vector<fastjet::PseudoJet> near_particles = sel(particles);
-  double var = 0;
-  //double lSumPt = 0;
-  //if(iId == 1) for(unsigned int i=0; i<near_particles.size(); i++) lSumPt += near_particles[i].pt();
-  for(unsigned int i=0; i<near_particles.size(); i++){
-    double pDEta = near_particles[i].eta()-centre.eta();
-    double pDPhi = fabs(near_particles[i].phi()-centre.phi());
-    if(pDPhi > 2.*3.14159265-pDPhi) pDPhi =  2.*3.14159265-pDPhi;
-    double pDR2 = pDEta*pDEta+pDPhi*pDPhi;
-    if(std::abs(pDR2)  <  0.0001) continue;
-    if(iId == 0) var += (near_particles[i].pt()/pDR2);
-    if(iId == 1) var += near_particles[i].pt();
-    if(iId == 2) var += (1./pDR2);
-    if(iId == 3) var += (1./pDR2);
-    if(iId == 4) var += near_particles[i].pt();  
-    if(iId == 5) var += (near_particles[i].pt()*(near_particles[i].pt()/pDR2));
+//Computes the metrics of all the sub algos of a particle in one pass over its neighbours
+void PuppiContainer::getVals() {
+  int lNParticles = fPFParticles.size();
+  fVals.assign(lNParticles*fNMaxAlgo,-1);
+  for(int i0 = 0; i0 < lNParticles; i0++) {
+    int pPupId = fPupIds[i0];
+    if(pPupId == -1) continue;
+    int lNAlgos = fPuppiAlgo[pPupId].numAlgos();
+    for(int i1 = 0; i1 < lNAlgos; i1++) fSums[i1] = 0;
+    sumWithinR(0,i0,pPupId);
+    sumWithinR(1,i0,pPupId);
+    for(int i1 = 0; i1 < lNAlgos; i1++) {
+      int pAlgo = fPuppiAlgo[pPupId].algoId(i1);
+      double pVal = fSums[i1];
+      if(pAlgo == -1) pVal = 1;
+      if(pAlgo == 1) pVal += fPt[i0]; //Sum in a cone
+      if((pAlgo == 0 || pAlgo == 3 || pAlgo == 5) && pVal != 0) pVal = log(pVal);
+      fVals[i0*fNMaxAlgo+i1] = pVal;
+      if(std::isnan(pVal) || std::isinf(pVal)) cerr << "====> Value is Nan " << pVal << " == " << fPt[i0] << " -- " << fEta[i0] << endl;
+    }
   }
-  if(iId == 1) var += centre.pt(); //Sum in a cone
-  if(iId == 0 && var != 0) var = log(var);
-  if(iId == 3 && var != 0) var = log(var);
-  if(iId == 5 && var != 0) var = log(var);
-  return var;
 }
 //In fact takes the median not the average
-void PuppiContainer::getRMSAvg(int iOpt,std::vector<fastjet::PseudoJet> &iConstits,std::vector<fastjet::PseudoJet> &iParticles,std::vector<fastjet::PseudoJet> &iChargedParticles) { 
-  for(unsigned int i0 = 0; i0 < iConstits.size(); i0++ ) { 
-    double pVal = -1;
-    //Calculate the Puppi Algo to use
-    int  pPupId   = getPuppiId(iConstits[i0].pt(),iConstits[i0].eta());
-    if(fPuppiAlgo[pPupId].numAlgos() <= iOpt) pPupId = -1;
-    if(pPupId == -1) {fVals.push_back(-1); continue;}
-    //Get the Puppi Sub Algo (given iteration)
-    int  pAlgo    = fPuppiAlgo[pPupId].algoId   (iOpt); 
-    bool pCharged = fPuppiAlgo[pPupId].isCharged(iOpt);
-    double pCone  = fPuppiAlgo[pPupId].coneSize (iOpt);
-    //Compute the Puppi Metric 
-    if(!pCharged) pVal = goodVar(iConstits[i0],iParticles       ,pAlgo,pCone);
-    if( pCharged) pVal = goodVar(iConstits[i0],iChargedParticles,pAlgo,pCone);
-    fVals.push_back(pVal);
-    if(std::isnan(pVal) || std::isinf(pVal)) cerr << "====> Value is Nan " << pVal << " == " << iConstits[i0].pt() << " -- " << iConstits[i0].eta() << endl;
+void PuppiContainer::getRMSAvg(int iOpt) {
+  int lNParticles = fPFParticles.size();
+  for(int i0 = 0; i0 < lNParticles; i0++ ) {
+    int pPupId = fPupIds[i0];
+    if(pPupId == -1 || fPuppiAlgo[pPupId].numAlgos() <= iOpt) continue;
+    double pVal = fVals[i0*fNMaxAlgo+iOpt];
     if(std::isnan(pVal) || std::isinf(pVal)) continue;
-    fPuppiAlgo[pPupId].add(iConstits[i0],pVal,iOpt);
-    /*   eta extrapolation code
-        for(int i1 = 0; i1 < fNAlgos; i1++){
-            pAlgo    = fPuppiAlgo[i1].algoId   (iOpt);
-            pCharged = fPuppiAlgo[i1].isCharged(iOpt);
-            pCone    = fPuppiAlgo[i1].coneSize (iOpt);
-            double curVal = -1;
-            if(!pCharged) curVal = goodVar(iConstits[i0],iParticles       ,pAlgo,pCone);
-            if( pCharged) curVal = goodVar(iConstits[i0],iChargedParticles,pAlgo,pCone);
-            //std::cout << "i1 = " << i1 << ", curVal = " << curVal << ", eta = " << iConstits[i0].eta() << ", pupID = " << pPupId << std::endl;                                
-            fPuppiAlgo[i1].add(iConstits[i0],curVal,iOpt);
-        }
-    */
+    fPuppiAlgo[pPupId].add(fPFParticles[i0],pVal,iOpt);
   }
   for(int i0 = 0; i0 < fNAlgos; i0++) fPuppiAlgo[i0].computeMedRMS(iOpt,fPVFrac);
 }
@@ -137,23 +216,19 @@ double PuppiContainer::getChi2FromdZ(double iDZ) {
   lChi2PU*=lChi2PU;
   return lChi2PU;
 }
-const std::vector<double> PuppiContainer::puppiWeights() {
+const std::vector<double> &PuppiContainer::puppiWeights() {
   fPupParticles .resize(0);
   fWeights      .resize(0);
   fVals         .resize(0);
   for(int i0 = 0; i0 < fNAlgos; i0++) fPuppiAlgo[i0].reset();
 
-    int lNMaxAlgo = 1;
-  for(int i0 = 0; i0 < fNAlgos; i0++) lNMaxAlgo = TMath::Max(fPuppiAlgo[i0].numAlgos(),lNMaxAlgo);
   //Run through all compute mean and RMS
   int lNParticles    = fRecoParticles.size();
-  for(int i0 = 0; i0 < lNMaxAlgo; i0++) { 
-    getRMSAvg(i0,fPFParticles,fPFParticles,fChargedPV);
+  getVals();
+  for(int i0 = 0; i0 < fNMaxAlgo; i0++) { 
+    getRMSAvg(i0);
   }
-  std::vector<double> pVals;
   for(int i0 = 0; i0 < lNParticles; i0++) {
-    //Refresh
-    pVals.clear();
     double pWeight = 1;
     //Get the Puppi Id and if ill defined move on
     int  pPupId   = getPuppiId(fRecoParticles[i0].pt,fRecoParticles[i0].eta);
@@ -171,13 +246,12 @@ const std::vector<double> PuppiContainer::puppiWeights() {
     }
     //Fill and compute the PuppiWeight
     int lNAlgos = fPuppiAlgo[pPupId].numAlgos();
-    for(int i1 = 0; i1 < lNAlgos; i1++) pVals.push_back(fVals[lNParticles*i1+i0]);
-    pWeight = fPuppiAlgo[pPupId].compute(pVals,pChi2);
+    pWeight = fPuppiAlgo[pPupId].compute(&fVals[i0*fNMaxAlgo],pChi2);
     //Apply the CHS weights
     if(fRecoParticles[i0].id == 1 && fApplyCHS ) pWeight = 1;
     if(fRecoParticles[i0].id == 2 && fApplyCHS ) pWeight = 0;
     //Basic Weight Checks
-    if(std::isnan(pWeight)) std::cerr << "====> Weight is nan  : pt " << fRecoParticles[i0].pt << " -- eta : " << fRecoParticles[i0].eta << " -- Value" << fVals[i0] << " -- id :  " << fRecoParticles[i0].id << " --  NAlgos: " << lNAlgos << std::endl;
+    if(std::isnan(pWeight)) std::cerr << "====> Weight is nan  : pt " << fRecoParticles[i0].pt << " -- eta : " << fRecoParticles[i0].eta << " -- Value" << fVals[i0*fNMaxAlgo] << " -- id :  " << fRecoParticles[i0].id << " --  NAlgos: " << lNAlgos << std::endl;
     //Basic Cuts      
     if(pWeight                         < fPuppiWeightCut) pWeight = 0;  //==> Elminate the low Weight stuff
     if(pWeight*fPFParticles[i0].pt()   < fPuppiAlgo[pPupId].neutralPt(fNPV) && fRecoParticles[i0].id == 0 ) pWeight = 0;  //threshold cut on the neutral Pt
@@ -10,35 +10,53 @@ public:
     //PuppiContainer(const edm::ParameterSet &iConfig);
     PuppiContainer(const std::string &iConfig);
     PuppiContainer(bool iApplyCHS, bool iUseExp,double iPuppiWeightCut,std::vector<AlgoObj> &iAlgos);
-    ~PuppiContainer(); 
+    ~PuppiContainer();
     void initialize(const std::vector<RecoObj> &iRecoObjects);
-    std::vector<fastjet::PseudoJet> pfParticles(){ return fPFParticles; }    
-    std::vector<fastjet::PseudoJet> pvParticles(){ return fChargedPV; }        
-    const std::vector<double> puppiWeights();
-    std::vector<fastjet::PseudoJet> puppiParticles() { return fPupParticles;}
+    const std::vector<fastjet::PseudoJet> &pfParticles(){ return fPFParticles; }
+    const std::vector<fastjet::PseudoJet> &pvParticles(){ return fChargedPV; }
+    const std::vector<double> &puppiWeights();
+    const std::vector<fastjet::PseudoJet> &puppiParticles() { return fPupParticles;}
 
 protected:
-    double  goodVar      (fastjet::PseudoJet &iPart,std::vector<fastjet::PseudoJet> &iParts, int iOpt,double iRCone);
-    void    getRMSAvg    (int iOpt,std::vector<fastjet::PseudoJet> &iConstits,std::vector<fastjet::PseudoJet> &iParticles,std::vector<fastjet::PseudoJet> &iChargeParticles);
+    void    fillTiles    (int iColl,const std::vector<int> &iIndices);
+    void    sumWithinR   (int iColl,int iParticle,int iPupId);
+    void    getVals      ();
+    void    getRMSAvg    (int iOpt);
     double  getChi2FromdZ(double iDZ);
     int     getPuppiId   (const float &iPt,const float &iEta);
-    double  var_within_R (int iId, const std::vector<fastjet::PseudoJet> & particles, const fastjet::PseudoJet& centre, double R);  
-    
+
     std::vector<RecoObj>  fRecoParticles;
     std::vector<fastjet::PseudoJet> fPFParticles;
     std::vector<fastjet::PseudoJet> fChargedPV;
     std::vector<fastjet::PseudoJet> fPupParticles;
     std::vector<double>    fWeights;
-    std::vector<double>    fVals;
+    std::vector<double>    fVals;     // metrics of all the algos, particle by particle
     bool   fApplyCHS;
     bool   fUseExp;
     double fNeutralMinPt;
     double fNeutralSlope;
     double fPuppiWeightCut;
     int    fNAlgos;
+    int    fNMaxAlgo;
     int    fNPV;
     double fPVFrac;
     std::vector<PuppiAlgo> fPuppiAlgo;
+    // eta-phi tiles for the neighbour search, of all (0) and PV charged (1) particles
+    double fTileSize;
+    double fPhiTileSize;
+    double fRapMin;
+    int    fNRapTiles;
+    int    fNPhiTiles;
+    std::vector<double> fRap, fPhi, fEta, fPt;
+    std::vector<int>    fPupIds;
+    std::vector<int>    fTiles;
+    std::vector<int>    fIndices[2];
+    std::vector<int>    fTileStart[2];
+    std::vector<int>    fTileParticles[2];
+    std::vector<int>    fTileCursor;
+    std::vector<int>    fSubIds;
+    std::vector<double> fSubCone2;
+    std::vector<double> fSums;
 };
 
 
@@ -51,7 +51,7 @@ using namespace std;
 //------------------------------------------------------------------------------
 
 BTagging::BTagging() :
-  fItJetInputArray(0)
+  fDefaultFormula(0), fItJetInputArray(0)
 {
 }
 
@@ -95,6 +95,14 @@ void BTagging::Init()
     fEfficiencyMap[0] = formula;
   }
 
+  // fill the PID lookup table used for every jet
+  fEfficiencyTable.Clear();
+  for(itEfficiencyMap = fEfficiencyMap.begin(); itEfficiencyMap != fEfficiencyMap.end(); ++itEfficiencyMap)
+  {
+    fEfficiencyTable.Insert(itEfficiencyMap->first, itEfficiencyMap->second);
+  }
+  fDefaultFormula = fEfficiencyMap[0];
+
   // import input array(s)
 
   fJetInputArray = ImportArray(GetString("JetInputArray", "FastJetFinder/jets"));
@@ -123,7 +131,6 @@ void BTagging::Process()
 {
   Candidate *jet;
   Double_t pt, eta, phi, e;
-  map< Int_t, DelphesFormula * >::iterator itEfficiencyMap;
   DelphesFormula *formula;
 
   // loop over all input jets
@@ -137,34 +144,19 @@ void BTagging::Process()
     e = jetMomentum.E();
 
     // find an efficiency formula
-    itEfficiencyMap = fEfficiencyMap.find(jet->Flavor);
-    if(itEfficiencyMap == fEfficiencyMap.end())
-    {
-      itEfficiencyMap = fEfficiencyMap.find(0);
-    }
-    formula = itEfficiencyMap->second;
+    formula = fEfficiencyTable.Get(jet->Flavor, fDefaultFormula);
 
     // apply an efficiency formula
     jet->BTag |= (gRandom->Uniform() <= formula->Eval(pt, eta, phi, e)) << fBitNumber;
 
     // find an efficiency formula for algo flavor definition
-    itEfficiencyMap = fEfficiencyMap.find(jet->FlavorAlgo);
-    if(itEfficiencyMap == fEfficiencyMap.end())
-    {
-      itEfficiencyMap = fEfficiencyMap.find(0);
-    }
-    formula = itEfficiencyMap->second;
+    formula = fEfficiencyTable.Get(jet->FlavorAlgo, fDefaultFormula);
 
     // apply an efficiency formula
     jet->BTagAlgo |= (gRandom->Uniform() <= formula->Eval(pt, eta, phi, e)) << fBitNumber;
 
     // find an efficiency formula for phys flavor definition
-    itEfficiencyMap = fEfficiencyMap.find(jet->FlavorPhys);
-    if(itEfficiencyMap == fEfficiencyMap.end())
-    {
-      itEfficiencyMap = fEfficiencyMap.find(0);
-    }
-    formula = itEfficiencyMap->second;
+    formula = fEfficiencyTable.Get(jet->FlavorPhys, fDefaultFormula);
 
     // apply an efficiency formula
     jet->BTagPhys |= (gRandom->Uniform() <= formula->Eval(pt, eta, phi, e)) << fBitNumber;
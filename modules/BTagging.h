@@ -31,6 +31,10 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesPIDTable.h"
+#endif
+
 #include <map>
 
 class TObjArray;
@@ -47,12 +51,17 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
 private:
 
   Int_t fBitNumber;
 
 #if !defined(__CINT__) && !defined(__CLING__)
   std::map< Int_t, DelphesFormula * > fEfficiencyMap; //!
+
+  DelphesPIDTable< DelphesFormula * > fEfficiencyTable; //!
+  DelphesFormula *fDefaultFormula; //!
 #endif
 
   TIterator *fItJetInputArray; //!
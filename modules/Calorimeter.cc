@@ -31,12 +31,14 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
+#include "classes/DelphesSnapshot.h"
 
 #include "ExRootAnalysis/ExRootResult.h"
 #include "ExRootAnalysis/ExRootFilter.h"
 #include "ExRootAnalysis/ExRootClassifier.h"
 
 #include "TMath.h"
+#include "TDirectory.h"
 #include "TString.h"
 #include "TFormula.h"
 #include "TRandom3.h"
@@ -95,40 +97,45 @@ void Calorimeter::Init()
   TBinMap::iterator itEtaBin;
   set< Double_t >::iterator itPhiBin;
   vector< Double_t > *phiBins;
+  vector< Double_t > towerEta;
+  Bool_t tabulate;
 
-  // read eta and phi bins
-  param = GetParam("EtaPhiBins");
-  size = param.GetSize();
+  // read eta and phi bins, from the snapshot if there is one
   fBinMap.clear();
   fEtaBins.clear();
   fPhiBins.clear();
-  for(i = 0; i < size/2; ++i)
+  if(!DelphesSnapshot::ReadBins(GetSnapshot(), fEtaBins, fPhiBins))
   {
-    paramEtaBins = param[i*2];
-    sizeEtaBins = paramEtaBins.GetSize();
-    paramPhiBins = param[i*2 + 1];
-    sizePhiBins = paramPhiBins.GetSize();
-
-    for(j = 0; j < sizeEtaBins; ++j)
+    param = GetParam("EtaPhiBins");
+    size = param.GetSize();
+    for(i = 0; i < size/2; ++i)
     {
-      for(k = 0; k < sizePhiBins; ++k)
+      paramEtaBins = param[i*2];
+      sizeEtaBins = paramEtaBins.GetSize();
+      paramPhiBins = param[i*2 + 1];
+      sizePhiBins = paramPhiBins.GetSize();
+
+      for(j = 0; j < sizeEtaBins; ++j)
       {
-        fBinMap[paramEtaBins[j].GetDouble()].insert(paramPhiBins[k].GetDouble());
+        for(k = 0; k < sizePhiBins; ++k)
+        {
+          fBinMap[paramEtaBins[j].GetDouble()].insert(paramPhiBins[k].GetDouble());
+        }
       }
     }
-  }
 
-  // for better performance we transform map of sets to parallel vectors:
-  // vector< double > and vector< vector< double >* >
-  for(itEtaBin = fBinMap.begin(); itEtaBin != fBinMap.end(); ++itEtaBin)
-  {
-    fEtaBins.push_back(itEtaBin->first);
-    phiBins = new vector< double >(itEtaBin->second.size());
-    fPhiBins.push_back(phiBins);
-    phiBins->clear();
-    for(itPhiBin = itEtaBin->second.begin(); itPhiBin != itEtaBin->second.end(); ++itPhiBin)
+    // for better performance we transform map of sets to parallel vectors:
+    // vector< double > and vector< vector< double >* >
+    for(itEtaBin = fBinMap.begin(); itEtaBin != fBinMap.end(); ++itEtaBin)
     {
-      phiBins->push_back(*itPhiBin);
+      fEtaBins.push_back(itEtaBin->first);
+      phiBins = new vector< double >(itEtaBin->second.size());
+      fPhiBins.push_back(phiBins);
+      phiBins->clear();
+      for(itPhiBin = itEtaBin->second.begin(); itPhiBin != itEtaBin->second.end(); ++itPhiBin)
+      {
+        phiBins->push_back(*itPhiBin);
+      }
     }
   }
 
@@ -167,9 +174,26 @@ void Calorimeter::Init()
   // switch on or off the dithering of the center of calorimeter towers
   fSmearTowerCenter = GetBool("SmearTowerCenter", true);
 
-  // read resolution formulas
-  fECalResolutionFormula->Compile(GetString("ECalResolutionFormula", "0"));
-  fHCalResolutionFormula->Compile(GetString("HCalResolutionFormula", "0"));
+  // read resolution formulas, with a snapshot their tables are read back
+  // and the formulas are compiled only if they have to be evaluated
+  fECalResolutionFormula->CompileLater(GetString("ECalResolutionFormula", "0"));
+  fHCalResolutionFormula->CompileLater(GetString("HCalResolutionFormula", "0"));
+
+  // tabulate them at the eta of the towers, TabulateResolution false
+  // always evaluates the formulas
+  tabulate = GetBool("TabulateResolution", true);
+  for(i = 1; i < Long_t(fEtaBins.size()); ++i)
+  {
+    towerEta.push_back(0.5*(fEtaBins[i - 1] + fEtaBins[i]));
+  }
+  if(!tabulate || !fECalResolutionTable.Read(GetSnapshot(), "ECalResolutionTable", fECalResolutionFormula))
+  {
+    fECalResolutionTable.Build(fECalResolutionFormula, towerEta, tabulate);
+  }
+  if(!tabulate || !fHCalResolutionTable.Read(GetSnapshot(), "HCalResolutionTable", fHCalResolutionFormula))
+  {
+    fHCalResolutionTable.Build(fHCalResolutionFormula, towerEta, tabulate);
+  }
 
   // import array with output from other modules
   fParticleInputArray = ImportArray(GetString("ParticleInputArray", "ParticlePropagator/particles"));
@@ -189,6 +213,15 @@ void Calorimeter::Init()
 
 //------------------------------------------------------------------------------
 
+void Calorimeter::SaveState(TDirectory *directory)
+{
+  DelphesSnapshot::WriteBins(directory, fEtaBins, fPhiBins);
+  fECalResolutionTable.Write(directory, "ECalResolutionTable");
+  fHCalResolutionTable.Write(directory, "HCalResolutionTable");
+}
+
+//------------------------------------------------------------------------------
+
 void Calorimeter::Finish()
 {
   vector< vector< Double_t >* >::iterator itPhiBin;
@@ -351,6 +384,7 @@ void Calorimeter::Process()
       phiBins = fPhiBins[etaBin];
 
       // calculate eta and phi of the tower's center
+      fTowerEtaBin = etaBin;
       fTowerEta = 0.5*(fEtaBins[etaBin - 1] + fEtaBins[etaBin]);
       fTowerPhi = 0.5*((*phiBins)[phiBin - 1] + (*phiBins)[phiBin]);
 
@@ -399,7 +433,7 @@ void Calorimeter::Process()
       if(fECalTrackFractions[number] > 1.0E-9 && fHCalTrackFractions[number] < 1.0E-9)
       {
         fECalTrackEnergy += ecalEnergy;
-        ecalSigma = fECalResolutionFormula->Eval(0.0, fTowerEta, 0.0, momentum.E());        
+        ecalSigma = fECalResolutionTable.Eval(fTowerEtaBin - 1, momentum.E());        
         if(ecalSigma/momentum.E() < track->TrackResolution) energyGuess = ecalEnergy;        
         else energyGuess = momentum.E();
 
@@ -410,7 +444,7 @@ void Calorimeter::Process()
       else if(fECalTrackFractions[number] < 1.0E-9 && fHCalTrackFractions[number] > 1.0E-9)
       {
         fHCalTrackEnergy += hcalEnergy;
-        hcalSigma = fHCalResolutionFormula->Eval(0.0, fTowerEta, 0.0, momentum.E());
+        hcalSigma = fHCalResolutionTable.Eval(fTowerEtaBin - 1, momentum.E());
         if(hcalSigma/momentum.E() < track->TrackResolution) energyGuess = hcalEnergy;
         else energyGuess = momentum.E();
 
@@ -476,14 +510,14 @@ void Calorimeter::FinalizeTower()
 
   if(!fTower) return;
 
-  ecalSigma = fECalResolutionFormula->Eval(0.0, fTowerEta, 0.0, fECalTowerEnergy);
-  hcalSigma = fHCalResolutionFormula->Eval(0.0, fTowerEta, 0.0, fHCalTowerEnergy);
+  ecalSigma = fECalResolutionTable.Eval(fTowerEtaBin - 1, fECalTowerEnergy);
+  hcalSigma = fHCalResolutionTable.Eval(fTowerEtaBin - 1, fHCalTowerEnergy);
 
   ecalEnergy = LogNormal(fECalTowerEnergy, ecalSigma);
   hcalEnergy = LogNormal(fHCalTowerEnergy, hcalSigma);
 
-  ecalSigma = fECalResolutionFormula->Eval(0.0, fTowerEta, 0.0, ecalEnergy);
-  hcalSigma = fHCalResolutionFormula->Eval(0.0, fTowerEta, 0.0, hcalEnergy);
+  ecalSigma = fECalResolutionTable.Eval(fTowerEtaBin - 1, ecalEnergy);
+  hcalSigma = fHCalResolutionTable.Eval(fTowerEtaBin - 1, hcalEnergy);
 
   if(ecalEnergy < fECalEnergyMin || ecalEnergy < fECalEnergySignificanceMin*ecalSigma) ecalEnergy = 0.0;
   if(hcalEnergy < fHCalEnergyMin || hcalEnergy < fHCalEnergySignificanceMin*hcalSigma) hcalEnergy = 0.0;
@@ -30,11 +30,16 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesResolutionTable.h"
+#endif
+
 #include <map>
 #include <set>
 #include <vector>
 
 class TObjArray;
+class TDirectory;
 class DelphesFormula;
 class Candidate;
 
@@ -49,12 +54,15 @@ public:
   void Process();
   void Finish();
 
+  void SaveState(TDirectory *directory);
+
 private:
 
   typedef std::map< Long64_t, std::pair< Double_t, Double_t > > TFractionMap; //!
   typedef std::map< Double_t, std::set< Double_t > > TBinMap; //!
 
   Candidate *fTower;
+  Short_t fTowerEtaBin;
   Double_t fTowerEta, fTowerPhi, fTowerEdges[4];
   Double_t fECalTowerEnergy, fHCalTowerEnergy;
   Double_t fECalTrackEnergy, fHCalTrackEnergy;
@@ -92,6 +100,12 @@ private:
   DelphesFormula *fECalResolutionFormula; //!
   DelphesFormula *fHCalResolutionFormula; //!
 
+#if !defined(__CINT__) && !defined(__CLING__)
+  // resolution formulas at the eta of the towers
+  DelphesResolutionTable fECalResolutionTable; //!
+  DelphesResolutionTable fHCalResolutionTable; //!
+#endif
+
   TIterator *fItParticleInputArray; //!
   TIterator *fItTrackInputArray; //!
 
@@ -46,6 +46,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
 private:
 
   Double_t fJetPTMin;
@@ -31,6 +31,7 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
+#include "classes/DelphesScheduler.h"
 
 #include "ExRootAnalysis/ExRootResult.h"
 #include "ExRootAnalysis/ExRootFilter.h"
@@ -39,12 +40,15 @@
 #include "ExRootAnalysis/ExRootTreeWriter.h"
 
 #include "TROOT.h"
+#include "TFile.h"
 #include "TMath.h"
 #include "TFolder.h"
+#include "TSystem.h"
 #include "TString.h"
 #include "TFormula.h"
 #include "TRandom3.h"
 #include "TObjArray.h"
+#include "TStopwatch.h"
 #include "TDatabasePDG.h"
 #include "TLorentzVector.h"
 
@@ -52,6 +56,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
+#include <set>
 
 #include <string.h>
 #include <stdio.h>
@@ -59,7 +64,7 @@
 using namespace std;
 
 Delphes::Delphes(const char *name) :
-  fFactory(0)
+  fFactory(0), fSnapshotFile(0), fScheduler(0)
 {
   TFolder *folder = new TFolder(name, "");
   fFactory = new DelphesFactory("ObjectFactory");
@@ -84,6 +89,8 @@ Delphes::~Delphes()
     delete folder;
   }
   if(fFactory) delete fFactory;
+  if(fSnapshotFile) delete fSnapshotFile;
+  if(fScheduler) delete fScheduler;
 }
 
 //------------------------------------------------------------------------------
@@ -103,6 +110,276 @@ void Delphes::SetTreeWriter(ExRootTreeWriter *treeWriter)
 
 //------------------------------------------------------------------------------
 
+void Delphes::InitTask()
+{
+  TIter itTasks(GetListOfTasks());
+  TObject *task;
+  TStopwatch stopwatch;
+  Int_t threads;
+
+  stopwatch.Start();
+  DelphesModule::InitTask();
+  stopwatch.Stop();
+
+  cout << "** INFO: modules initialised in " << stopwatch.RealTime() << " s";
+  if(fSnapshotFile) cout << " from snapshot " << fSnapshotName;
+  cout << endl;
+
+  if(fSnapshotFile)
+  {
+    // modules have copied their state in Init
+    while((task = itTasks()))
+    {
+      if(task->InheritsFrom(DelphesModule::Class())) static_cast<DelphesModule *>(task)->SetSnapshot(0);
+    }
+    delete fSnapshotFile;
+    fSnapshotFile = 0;
+  }
+  else if(fSnapshotName.Length() > 0)
+  {
+    SaveSnapshot();
+  }
+
+  FindUnusedModules();
+
+  threads = GetConfReader()->GetInt("::NumberOfThreads", 1);
+  if(threads > 1)
+  {
+    ROOT::EnableThreadSafety();
+
+    // the particle table is read on first use
+    TDatabasePDG::Instance()->GetParticle(11);
+
+    BuildScheduler(threads);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void Delphes::ProcessTask()
+{
+  if(!fScheduler)
+  {
+    DelphesModule::ProcessTask();
+    return;
+  }
+
+  if(!IsActive()) return;
+
+  Process();
+  fScheduler->Run();
+}
+
+//------------------------------------------------------------------------------
+
+static void CollectArrays(TTask *task, set< TObject * > &imports, set< TObject * > &exports)
+{
+  DelphesModule *module;
+  TObject *object;
+  TTask *subTask;
+
+  if(task->InheritsFrom(DelphesModule::Class()))
+  {
+    module = static_cast<DelphesModule *>(task);
+
+    TIter itImports(module->GetImportFolder() ? module->GetImportFolder()->GetListOfFolders() : 0);
+    while((object = itImports())) imports.insert(object);
+
+    TIter itExports(module->GetExportFolder() ? module->GetExportFolder()->GetListOfFolders() : 0);
+    while((object = itExports())) exports.insert(object);
+  }
+
+  // modules run by other modules, like the stages of a Pipeline
+  TIter itSubTasks(task->GetListOfTasks());
+  while((subTask = static_cast<TTask *>(itSubTasks())))
+  {
+    CollectArrays(subTask, imports, exports);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void Delphes::BuildScheduler(Int_t threads)
+{
+  TIter itTasks(GetListOfTasks());
+  TTask *task;
+  vector< Int_t > nodes;
+  vector< Bool_t > modifies, barriers;
+  vector< set< TObject * > > imports, exports;
+  set< TObject * >::iterator itArrays;
+  Bool_t dependent, concurrent;
+  Int_t i, j, serial = -1;
+
+  fScheduler = new DelphesScheduler(threads);
+
+  while((task = static_cast<TTask *>(itTasks())))
+  {
+    if(!task->IsActive()) continue;
+
+    imports.push_back(set< TObject * >());
+    exports.push_back(set< TObject * >());
+    CollectArrays(task, imports.back(), exports.back());
+
+    // other tasks run after all tasks before them and before all tasks after them
+    barriers.push_back(!task->InheritsFrom(DelphesModule::Class()));
+
+    concurrent = !barriers.back() && static_cast<DelphesModule *>(task)->IsConcurrent();
+
+    // modules not declared concurrent may modify their imported arrays even
+    // if they don't declare it, concurrent modules don't
+    modifies.push_back(!concurrent || static_cast<DelphesModule *>(task)->ModifiesInputs());
+
+    nodes.push_back(fScheduler->AddTask(task, concurrent));
+
+    // a module runs after the modules exporting its imported arrays, and
+    // after the modules reading or modifying the arrays it modifies
+    j = nodes.size() - 1;
+    for(i = 0; i < j; ++i)
+    {
+      dependent = barriers[i] || barriers[j];
+      for(itArrays = imports[j].begin(); itArrays != imports[j].end() && !dependent; ++itArrays)
+      {
+        dependent = exports[i].count(*itArrays) || ((modifies[i] || modifies[j]) && imports[i].count(*itArrays));
+      }
+      if(dependent) fScheduler->AddDependency(nodes[i], nodes[j]);
+    }
+
+    // the other modules run in the order of the card, so that they draw
+    // the same random numbers as with a single thread
+    if(concurrent) continue;
+    if(serial >= 0) fScheduler->AddDependency(nodes[serial], nodes[j]);
+    serial = j;
+  }
+
+  cout << "** INFO: modules run on " << threads << " threads" << endl;
+}
+
+//------------------------------------------------------------------------------
+
+void Delphes::FindUnusedModules()
+{
+  TIter itTasks(GetListOfTasks());
+  TObject *task, *object;
+  vector< DelphesModule * > modules;
+  vector< set< TObject * > > imports, exports;
+  vector< Bool_t > used;
+  set< TObject * > usedArrays;
+  set< TObject * >::iterator itArrays;
+  Bool_t skip = GetConfReader()->GetBool("::SkipUnusedModules", false);
+  Bool_t changed, treeWriter = kFALSE;
+  Int_t i;
+
+  while((task = itTasks()))
+  {
+    if(!task->InheritsFrom(DelphesModule::Class())) continue;
+    modules.push_back(static_cast<DelphesModule *>(task));
+    imports.push_back(set< TObject * >());
+    exports.push_back(set< TObject * >());
+    CollectArrays(modules.back(), imports.back(), exports.back());
+    used.push_back(task->InheritsFrom("TreeWriter"));
+    if(used.back())
+    {
+      treeWriter = kTRUE;
+      usedArrays.insert(imports.back().begin(), imports.back().end());
+    }
+  }
+
+  // without tree writer the arrays are read by the main program
+  if(!treeWriter) return;
+
+  // arrays imported by the main program
+  TIter itImports(GetImportFolder() ? GetImportFolder()->GetListOfFolders() : 0);
+  while((object = itImports())) usedArrays.insert(object);
+
+  // follow the imported arrays back from the tree writers, modules without
+  // output array or modifying their inputs are used if they modify used arrays
+  do
+  {
+    changed = kFALSE;
+    for(i = modules.size() - 1; i >= 0; --i)
+    {
+      if(used[i]) continue;
+
+      for(itArrays = exports[i].begin(); itArrays != exports[i].end() && !usedArrays.count(*itArrays); ++itArrays);
+      used[i] = (itArrays != exports[i].end());
+
+      if(!used[i] && (exports[i].empty() || modules[i]->ModifiesInputs()))
+      {
+        for(itArrays = imports[i].begin(); itArrays != imports[i].end() && !usedArrays.count(*itArrays); ++itArrays);
+        used[i] = (itArrays != imports[i].end());
+      }
+
+      if(!used[i]) continue;
+
+      usedArrays.insert(imports[i].begin(), imports[i].end());
+      changed = kTRUE;
+    }
+  }
+  while(changed);
+
+  fSkippedModules.clear();
+  for(i = 0; i < Int_t(modules.size()); ++i)
+  {
+    if(used[i]) continue;
+
+    cout << "** INFO: module " << modules[i]->GetName() << " is not used by the output";
+    if(skip)
+    {
+      cout << ", it is skipped";
+      modules[i]->SetActive(kFALSE);
+      fSkippedModules.push_back(modules[i]);
+    }
+    cout << endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void Delphes::SaveSnapshot()
+{
+  TIter itTasks(GetListOfTasks());
+  TObject *task;
+  TDirectory *directory, *currentDirectory = gDirectory;
+  TString tmpName = TString::Format("%s.%d", fSnapshotName.Data(), gSystem->GetPid());
+  TNamed checksum("Checksum", GetConfReader()->GetChecksum().Data());
+
+  // write to a temporary file first, concurrent jobs may share the snapshot
+  TFile *file = TFile::Open(tmpName, "RECREATE");
+  if(!file || file->IsZombie())
+  {
+    cout << "** WARNING: can't write snapshot " << fSnapshotName << endl;
+    if(file) delete file;
+    currentDirectory->cd();
+    return;
+  }
+
+  file->WriteTObject(&checksum);
+
+  while((task = itTasks()))
+  {
+    if(!task->InheritsFrom(DelphesModule::Class())) continue;
+    directory = file->mkdir(task->GetName());
+    if(directory) static_cast<DelphesModule *>(task)->SaveState(directory);
+  }
+
+  file->Write();
+  file->Close();
+  delete file;
+
+  currentDirectory->cd();
+
+  if(gSystem->Rename(tmpName, fSnapshotName) != 0)
+  {
+    cout << "** WARNING: can't write snapshot " << fSnapshotName << endl;
+    gSystem->Unlink(tmpName);
+    return;
+  }
+
+  cout << "** INFO: initialised state written to snapshot " << fSnapshotName << endl;
+}
+
+//------------------------------------------------------------------------------
+
 void Delphes::Init()
 {
   stringstream message;
@@ -112,6 +389,8 @@ void Delphes::Init()
 
   TString name;
   ExRootTask *task;
+  TDirectory *directory, *currentDirectory = gDirectory;
+  TNamed *checksum = 0;
   const ExRootConfReader::ExRootTaskMap *modules = confReader->GetModules();
   ExRootConfReader::ExRootTaskMap::const_iterator itModules;
 
@@ -120,6 +399,25 @@ void Delphes::Init()
 
   gRandom->SetSeed(confReader->GetInt("::RandomSeed", 0));
 
+  // snapshot of the initialised modules, valid only for the same card
+  fSnapshotName = confReader->GetString("::Snapshot", "");
+  if(fSnapshotName.Length() > 0 && !gSystem->AccessPathName(fSnapshotName))
+  {
+    fSnapshotFile = TFile::Open(fSnapshotName);
+    if(fSnapshotFile) fSnapshotFile->GetObject("Checksum", checksum);
+    if(!checksum || confReader->GetChecksum() != checksum->GetTitle())
+    {
+      cout << "** WARNING: snapshot " << fSnapshotName << " does not match the card, it will be written again" << endl;
+      if(fSnapshotFile) delete fSnapshotFile;
+      fSnapshotFile = 0;
+    }
+    else
+    {
+      cout << "** INFO: initialising modules from snapshot " << fSnapshotName << endl;
+    }
+    currentDirectory->cd();
+  }
+
   for(i = 0; i < size; ++i)
   {
     name = param[i].GetString();
@@ -131,6 +429,12 @@ void Delphes::Init()
       {
         task->SetFolder(GetFolder());
         Add(task);
+        if(fSnapshotFile && task->InheritsFrom(DelphesModule::Class()))
+        {
+          directory = 0;
+          fSnapshotFile->GetObject(name, directory);
+          static_cast<DelphesModule *>(task)->SetSnapshot(directory);
+        }
       }
     }
     else
@@ -152,6 +456,14 @@ void Delphes::Process()
 
 void Delphes::Finish()
 {
+  vector< DelphesModule * >::iterator itModules;
+
+  // the skipped modules were initialised, they are finished as well
+  for(itModules = fSkippedModules.begin(); itModules != fSkippedModules.end(); ++itModules)
+  {
+    (*itModules)->SetActive(kTRUE);
+  }
+  fSkippedModules.clear();
 }
 
 //------------------------------------------------------------------------------
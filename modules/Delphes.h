@@ -30,12 +30,16 @@
 
 #include "classes/DelphesModule.h"
 
+#include <vector>
+
+class TFile;
 class TFolder;
 class TObjArray;
 
 class ExRootTreeWriter;
 
 class DelphesFactory;
+class DelphesScheduler;
 
 class Delphes: public DelphesModule
 {
@@ -50,14 +54,35 @@ public:
 
   void Clear();
 
+  // initialises the modules from the snapshot file given by ::Snapshot
+  // in the card, or writes it if it does not exist yet, then reports the
+  // modules whose outputs are not written and skips them if
+  // ::SkipUnusedModules is true
+  virtual void InitTask();
+
+  // with ::NumberOfThreads > 1, the modules of an event run on a pool of
+  // threads in the order given by their imported and exported arrays
+  virtual void ProcessTask();
+
   virtual void Init();
   virtual void Process();
   virtual void Finish();
 
 private:
 
+  void SaveSnapshot();
+  void FindUnusedModules();
+  void BuildScheduler(Int_t threads);
+
   DelphesFactory *fFactory;
 
+  TString fSnapshotName; //!
+  TFile *fSnapshotFile; //!
+
+  std::vector< DelphesModule * > fSkippedModules; //!
+
+  DelphesScheduler *fScheduler; //!
+
   ClassDef(Delphes, 1)
 };
 
@@ -95,23 +95,32 @@ void Efficiency::Finish()
 void Efficiency::Process()
 { 
   Candidate *candidate;
-  Double_t pt, eta, phi, e;
 
   fItInputArray->Reset();
   while((candidate = static_cast<Candidate*>(fItInputArray->Next())))
   {
-    const TLorentzVector &candidatePosition = candidate->Position;
-    const TLorentzVector &candidateMomentum = candidate->Momentum;
-    eta = candidatePosition.Eta();
-    phi = candidatePosition.Phi();
-    pt = candidateMomentum.Pt();
-    e = candidateMomentum.E();
-
-    // apply an efficency formula
-    if(gRandom->Uniform() > fFormula->Eval(pt, eta, phi, e)) continue;
-    
-    fOutputArray->Add(candidate);
+    candidate = ProcessCandidate(candidate);
+    if(candidate) fOutputArray->Add(candidate);
   }
 }
 
 //------------------------------------------------------------------------------
+
+Candidate *Efficiency::ProcessCandidate(Candidate *candidate)
+{
+  Double_t pt, eta, phi, e;
+
+  const TLorentzVector &candidatePosition = candidate->Position;
+  const TLorentzVector &candidateMomentum = candidate->Momentum;
+  eta = candidatePosition.Eta();
+  phi = candidatePosition.Phi();
+  pt = candidateMomentum.Pt();
+  e = candidateMomentum.E();
+
+  // apply an efficency formula
+  if(gRandom->Uniform() > fFormula->Eval(pt, eta, phi, e)) return 0;
+
+  return candidate;
+}
+
+//------------------------------------------------------------------------------
@@ -44,6 +44,10 @@ public:
   void Process();
   void Finish();
 
+  Bool_t IsElementWise() const { return kTRUE; }
+
+  Candidate *ProcessCandidate(Candidate *candidate);
+
 private:
 
   DelphesFormula *fFormula; //!
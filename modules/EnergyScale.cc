@@ -95,23 +95,31 @@ void EnergyScale::Finish()
 void EnergyScale::Process()
 {
   Candidate *candidate;
-  TLorentzVector momentum;
-  Double_t scale;
   
   fItInputArray->Reset();
   while((candidate = static_cast<Candidate*>(fItInputArray->Next())))
   {
-    momentum = candidate->Momentum;
+    fOutputArray->Add(ProcessCandidate(candidate));
+  }
+}
+
+//------------------------------------------------------------------------------
 
-    scale = fFormula->Eval(momentum.Pt(), momentum.Eta(), momentum.Phi(), momentum.E());
+Candidate *EnergyScale::ProcessCandidate(Candidate *candidate)
+{
+  TLorentzVector momentum;
+  Double_t scale;
 
-    if(scale > 0.0) momentum *= scale;
+  momentum = candidate->Momentum;
 
-    candidate = static_cast<Candidate*>(candidate->Clone());
-    candidate->Momentum = momentum;
+  scale = fFormula->Eval(momentum.Pt(), momentum.Eta(), momentum.Phi(), momentum.E());
 
-    fOutputArray->Add(candidate);
-  }
+  if(scale > 0.0) momentum *= scale;
+
+  candidate = static_cast<Candidate*>(candidate->Clone());
+  candidate->Momentum = momentum;
+
+  return candidate;
 }
 
 //------------------------------------------------------------------------------
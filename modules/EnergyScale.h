@@ -44,6 +44,11 @@ public:
   void Process();
   void Finish();
 
+  Bool_t IsElementWise() const { return kTRUE; }
+  Bool_t IsConcurrent() const { return kTRUE; }
+
+  Candidate *ProcessCandidate(Candidate *candidate);
+
 private:
 
   DelphesFormula *fFormula; //!
@@ -69,9 +69,18 @@ EnergySmearing::~EnergySmearing()
 
 void EnergySmearing::Init()
 {
-  // read resolution formula
+  // read resolution formula, with a snapshot its table is read back and
+  // the formula is compiled only if the table doesn't replace it;
+  // TabulateResolution false always evaluates the formula
 
-  fFormula->Compile(GetString("ResolutionFormula", "0.0"));
+  Bool_t tabulate = GetBool("TabulateResolution", true);
+
+  fFormula->CompileLater(GetString("ResolutionFormula", "0.0"));
+  if(!tabulate || !fResolutionTable.Read(GetSnapshot(), "ResolutionTable", fFormula))
+  {
+    fFormula->CompilePending();
+    fResolutionTable.Build(fFormula, tabulate);
+  }
 
   // import input array
 
@@ -85,6 +94,13 @@ void EnergySmearing::Init()
 
 //------------------------------------------------------------------------------
 
+void EnergySmearing::SaveState(TDirectory *directory)
+{
+  fResolutionTable.Write(directory, "ResolutionTable");
+}
+
+//------------------------------------------------------------------------------
+
 void EnergySmearing::Finish()
 {  
   if(fItInputArray) delete fItInputArray;
@@ -109,7 +125,7 @@ void EnergySmearing::Process()
     energy = candidateMomentum.E();
  
     // apply smearing formula
-    energy = gRandom->Gaus(energy, fFormula->Eval(pt, eta, phi, energy));
+    energy = gRandom->Gaus(energy, fResolutionTable.Eval(pt, eta, phi, energy));
      
     if(energy <= 0.0) continue;
  
@@ -118,7 +134,7 @@ void EnergySmearing::Process()
     eta = candidateMomentum.Eta();
     phi = candidateMomentum.Phi();
     candidate->Momentum.SetPtEtaPhiE(energy/TMath::CosH(eta), eta, phi, energy);
-    candidate->TrackResolution = fFormula->Eval(pt, eta, phi, energy)/candidateMomentum.E();
+    candidate->TrackResolution = fResolutionTable.Eval(pt, eta, phi, energy)/candidateMomentum.E();
     candidate->AddCandidate(mother);
  
     fOutputArray->Add(candidate);
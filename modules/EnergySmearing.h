@@ -29,6 +29,10 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesResolutionTable.h"
+#endif
+
 class TIterator;
 class TObjArray;
 class DelphesFormula;
@@ -44,10 +48,16 @@ public:
   void Process();
   void Finish();
 
+  void SaveState(TDirectory *directory);
+
 private:
 
   DelphesFormula *fFormula; //!
 
+#if !defined(__CINT__) && !defined(__CLING__)
+  DelphesResolutionTable fResolutionTable; //!
+#endif
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
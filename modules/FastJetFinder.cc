@@ -316,6 +316,18 @@ void FastJetFinder::Finish()
 
 //------------------------------------------------------------------------------
 
+Bool_t FastJetFinder::IsConcurrent() const
+{
+  // only the native kt, Cambridge/Aachen and anti-kt clusterings keep no
+  // static state: the plugins (CDF cones, SISCone, ...) have static caches
+  // and generators, ghosted areas use the static random generator,
+  // exclusive jets and the substructure tools update static warning counters
+  return fJetAlgorithm >= 4 && fJetAlgorithm <= 6 && !fAreaDefinition && !fExclusiveClustering
+    && !fComputeNsubjettiness && !fComputeTrimming && !fComputePruning && !fComputeSoftDrop;
+}
+
+//------------------------------------------------------------------------------
+
 void FastJetFinder::Process()
 {
   Candidate *candidate, *constituent;
@@ -57,6 +57,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t IsConcurrent() const;
+
 private:
 
   void *fPlugin; //!
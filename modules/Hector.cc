@@ -51,13 +51,39 @@
 #include "Hector/H_BeamLine.h"
 #include "Hector/H_RecRPObject.h"
 #include "Hector/H_BeamParticle.h"
+#include "Hector/H_OpticalElement.h"
+#include "Hector/H_Aperture.h"
 
 using namespace std;
 
 //------------------------------------------------------------------------------
 
+// product of a track vector with a transfer matrix interpolated
+// between two energy loss nodes, for the given number of columns
+
+static void Transform(const Double_t *initial, const Double_t *first, const Double_t *second,
+  Double_t weight, Int_t columns, Double_t *result)
+{
+  Double_t a, b;
+  Int_t i, j;
+
+  for(j = 0; j < columns; ++j)
+  {
+    a = 0.0;
+    b = 0.0;
+    for(i = 0; i < 6; ++i)
+    {
+      a += initial[i]*first[i*columns + j];
+      b += initial[i]*second[i*columns + j];
+    }
+    result[j] = a + weight*(b - a);
+  }
+}
+
+//------------------------------------------------------------------------------
+
 Hector::Hector() :
-  fBeamLine(0), fItInputArray(0)
+  fTargetPosition(-1), fNodeSize(0), fBeamLine(0), fItInputArray(0)
 {
 }
 
@@ -84,11 +110,20 @@ void Hector::Init()
   fSigmaT = GetDouble("SigmaT", 0.0);
   fEtaMin = GetDouble("EtaMin", 5.0);
 
+  // bins of relative energy loss of the tabulated transfer matrices,
+  // the particles are transported element by element if XiBins is 0
+  fXiBins = GetInt("XiBins", 250);
+  fXiMin = GetDouble("XiMin", -0.01);
+  fXiMax = GetDouble("XiMax", 0.24);
+
   fBeamLine = new H_BeamLine(fDirection, fBeamLineLength + 0.1);
   fBeamLine->fill(GetString("BeamLineFile", "cards/LHCB1IR5_5TeV.tfs"), fDirection, GetString("IPName", "IP5"));
   fBeamLine->offsetElements(fOffsetS, fOffsetX);
   fBeamLine->calcMatrix();
 
+  fTargetPosition = -1;
+  if(fXiBins > 0) BuildTables();
+
   // import input array
 
   fInputArray = ImportArray(GetString("InputArray", "ParticlePropagator/stableParticles"));
@@ -113,8 +148,10 @@ void Hector::Process()
 {
   Candidate *candidate, *mother;
   Double_t pz;
-  Double_t x, y, z, tx, ty, theta;
+  Double_t x, y, z, tx, ty, theta, energy;
   Double_t distance, time;
+  Double_t track[5];
+  Int_t status;
 
   const Double_t c_light = 2.99792458E8;
 
@@ -131,35 +168,28 @@ void Hector::Process()
     y = 1.0E3 * candidatePosition.Y();
     z = 1.0E-3 * candidatePosition.Z();
 
-//    tx = 1.0E6 * TMath::ATan(candidateMomentum.Px()/pz);
-//    ty = 1.0E6 * TMath::ATan(candidateMomentum.Py()/pz);
-
-    tx = 0.0;
-    ty = 0.0;
-
     theta = TMath::Hypot(TMath::ATan(candidateMomentum.Px()/pz), TMath::ATan(candidateMomentum.Py()/pz));
     distance = (fDistance - 1.0E-3 * candidatePosition.Z())/TMath::Cos(theta);
     time = gRandom->Gaus((distance + 1.0E-3 * candidatePosition.T())/c_light, fSigmaT);
 
-    H_BeamParticle particle(candidate->Mass, candidate->Charge);
-//    particle.set4Momentum(candidateMomentum);
-    particle.set4Momentum(candidateMomentum.Px(), candidateMomentum.Py(), 
-                          candidateMomentum.Pz(), candidateMomentum.E());
-    particle.setPosition(x, y, tx, ty, z);
+    // smearing of H_BeamParticle::smearAng and H_BeamParticle::smearE,
+    // the initial angles are 0
 
-    particle.smearAng(fSigmaX, fSigmaY, gRandom);
-    particle.smearE(fSigmaE, gRandom);
-
-    particle.computePath(fBeamLine);
+//    tx = 1.0E6 * TMath::ATan(candidateMomentum.Px()/pz);
+//    ty = 1.0E6 * TMath::ATan(candidateMomentum.Py()/pz);
 
-    if(particle.stopped(fBeamLine)) continue;
+    tx = gRandom->Gaus(0.0, fSigmaX);
+    ty = gRandom->Gaus(0.0, fSigmaY);
+    energy = gRandom->Gaus(candidateMomentum.E(), fSigmaE);
 
-    particle.propagate(fDistance);
+    status = Interpolate(candidate->Mass, candidate->Charge, x, y, z, tx, ty, energy, track);
+    if(status < 0) status = Propagate(candidate->Mass, candidate->Charge, x, y, z, tx, ty, energy, track);
+    if(status == 0) continue;
 
     mother = candidate;
     candidate = static_cast<Candidate*>(candidate->Clone());
-    candidate->Position.SetXYZT(particle.getX(), particle.getY(), particle.getS(), time);
-    candidate->Momentum.SetPxPyPzE(particle.getTX(), particle.getTY(), 0.0, particle.getE());
+    candidate->Position.SetXYZT(track[0], track[2], track[4], time);
+    candidate->Momentum.SetPxPyPzE(track[1], track[3], 0.0, energy);
     candidate->AddCandidate(mother);
 
     fOutputArray->Add(candidate);
@@ -167,3 +197,232 @@ void Hector::Process()
 }
 
 //------------------------------------------------------------------------------
+
+void Hector::BuildTables()
+{
+  const Int_t charges[3] = {0, 1, -1};
+  H_OpticalElement *element;
+  TMatrix matrix(6, 6);
+  Double_t chain[36], product[36], offset[6];
+  Double_t eloss, sum, *block;
+  Int_t elements, apertures, nodes, table, node, position, i, j, k, m;
+  vector< Int_t > apertureIndex;
+
+  if(fXiMax <= fXiMin)
+  {
+    throw runtime_error("XiMax must be greater than XiMin");
+  }
+
+  elements = fBeamLine->getNumberOfElements();
+
+  // positions are 0 at the vertex and i + 1 at the exit of element i,
+  // Distance is reached between the target position and the one before
+
+  for(position = 1; position <= elements; ++position)
+  {
+    element = fBeamLine->getElement(position - 1);
+    if(element->getS() + element->getLength() >= fDistance) break;
+  }
+
+  if(position > elements)
+  {
+    cout << "** WARNING: Distance is beyond the beam line, transfer matrices aren't tabulated" << endl;
+    return;
+  }
+
+  fTargetS[1] = element->getS() + element->getLength();
+  fTargetS[0] = 0.0;
+  if(position > 1)
+  {
+    element = fBeamLine->getElement(position - 2);
+    fTargetS[0] = element->getS() + element->getLength();
+  }
+
+  if((position > 1 && fTargetS[0] == fTargetS[1]) || (position == elements && fTargetS[1] == fDistance))
+  {
+    cout << "** WARNING: Distance is at the exit of an element, transfer matrices aren't tabulated" << endl;
+    return;
+  }
+
+  apertureIndex.assign(elements, -1);
+  fApertureElements.clear();
+  for(i = 0; i < elements; ++i)
+  {
+    if(fBeamLine->getElement(i)->getAperture()->getType() == NONE) continue;
+    apertureIndex[i] = fApertureElements.size();
+    fApertureElements.push_back(i);
+  }
+
+  // x and y columns at the entrance and exit of each element with an aperture,
+  // x, x', y and y' columns at the two positions around Distance
+  apertures = fApertureElements.size();
+  fNodeSize = 24*apertures + 48;
+
+  fTargetPosition = position;
+
+  for(table = 0; table < 3; ++table)
+  {
+    // neutral particles only drift
+    nodes = (charges[table] == 0) ? 1 : fXiBins + 1;
+    fTables[table].assign(nodes*fNodeSize, 0.0);
+
+    for(node = 0; node < nodes; ++node)
+    {
+      eloss = BE*(fXiMin + (fXiMax - fXiMin)*node/fXiBins);
+      block = &fTables[table][node*fNodeSize];
+
+      for(i = 0; i < 36; ++i) chain[i] = (i % 7 == 0) ? 1.0 : 0.0;
+
+      // same composition as H_BeamParticle::computePath,
+      // the element offsets act on the constant last row
+      for(k = 0; k <= elements; ++k)
+      {
+        if(k > 0)
+        {
+          element = fBeamLine->getElement(k - 1);
+          offset[0] = element->getX();
+          offset[1] = TMath::Tan(element->getTX()/URAD)*URAD;
+          offset[2] = element->getY();
+          offset[3] = TMath::Tan(element->getTY()/URAD)*URAD;
+          offset[4] = 0.0;
+          offset[5] = 0.0;
+
+          matrix = element->getMatrix(eloss, MP, charges[table]);
+
+          for(j = 0; j < 6; ++j) chain[30 + j] -= offset[j];
+          for(i = 0; i < 6; ++i)
+          {
+            for(j = 0; j < 6; ++j)
+            {
+              sum = 0.0;
+              for(m = 0; m < 6; ++m)
+              {
+                sum += chain[i*6 + m]*matrix(m, j);
+              }
+              product[i*6 + j] = sum;
+            }
+          }
+          for(i = 0; i < 36; ++i) chain[i] = product[i];
+          for(j = 0; j < 6; ++j) chain[30 + j] += offset[j];
+        }
+
+        for(i = 0; i < 6; ++i)
+        {
+          if(k < elements && apertureIndex[k] >= 0)
+          {
+            block[24*apertureIndex[k] + i*2] = chain[i*6];
+            block[24*apertureIndex[k] + i*2 + 1] = chain[i*6 + 2];
+          }
+          if(k > 0 && apertureIndex[k - 1] >= 0)
+          {
+            block[24*apertureIndex[k - 1] + 12 + i*2] = chain[i*6];
+            block[24*apertureIndex[k - 1] + 12 + i*2 + 1] = chain[i*6 + 2];
+          }
+          if(k == fTargetPosition - 1 || k == fTargetPosition)
+          {
+            for(j = 0; j < 4; ++j)
+            {
+              block[24*apertures + 24*(k - fTargetPosition + 1) + i*4 + j] = chain[i*6 + j];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Int_t Hector::Interpolate(Double_t mass, Int_t charge, Double_t x, Double_t y, Double_t z,
+  Double_t tx, Double_t ty, Double_t energy, Double_t *track) const
+{
+  extern bool relative_energy;
+  H_OpticalElement *element;
+  const Double_t *first, *second;
+  Double_t initial[6], in[2], out[2], before[4], after[4];
+  Double_t momentum, xi, bin, weight, s, l;
+  Int_t table, node, i;
+
+  if(fTargetPosition < 0 || z >= fDistance || energy <= mass) return -1;
+
+  if(mass == 0.0) charge = 0;
+
+  table = 0;
+  node = 0;
+  weight = 0.0;
+
+  if(charge != 0)
+  {
+    // the matrices only depend on the momentum over the charge,
+    // other particles use the proton energy of the same rigidity
+    table = (charge > 0) ? 1 : 2;
+    momentum = TMath::Sqrt((energy - mass)*(energy + mass))/TMath::Abs(charge);
+    xi = 1.0 - TMath::Sqrt(momentum*momentum + MP*MP)/BE;
+    bin = (xi - fXiMin)/(fXiMax - fXiMin)*fXiBins;
+    if(bin < 0.0 || bin >= fXiBins) return -1;
+    node = Int_t(bin);
+    weight = bin - node;
+  }
+
+  first = &fTables[table][node*fNodeSize];
+  second = (charge != 0) ? first + fNodeSize : first;
+
+  initial[0] = x/URAD;
+  initial[1] = TMath::Tan(tx/URAD);
+  initial[2] = y/URAD;
+  initial[3] = TMath::Tan(ty/URAD);
+  initial[4] = relative_energy ? energy - BE : energy;
+  initial[5] = 1.0;
+
+  // same aperture checks as H_BeamParticle::stopped
+  for(i = 0; i < Int_t(fApertureElements.size()); ++i)
+  {
+    element = fBeamLine->getElement(fApertureElements[i]);
+    Transform(initial, first, second, weight, 2, in);
+    Transform(initial, first + 12, second + 12, weight, 2, out);
+    if(!element->isInside(in[0]*URAD, in[1]*URAD) || !element->isInside(out[0]*URAD, out[1]*URAD)) return 0;
+    first += 24;
+    second += 24;
+  }
+
+  // same interpolation as H_BeamParticle::propagate
+  Transform(initial, first, second, weight, 4, before);
+  Transform(initial, first + 24, second + 24, weight, 4, after);
+
+  s = (fTargetPosition > 1) ? fTargetS[0] : z;
+  l = fTargetS[1] - s;
+
+  track[0] = (before[0] + (fDistance - s)*(after[0] - before[0])/l)*URAD;
+  track[1] = TMath::ATan(before[1])*URAD;
+  track[2] = (before[2] + (fDistance - s)*(after[2] - before[2])/l)*URAD;
+  track[3] = TMath::ATan(before[3])*URAD;
+  track[4] = fDistance;
+
+  return 1;
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t Hector::Propagate(Double_t mass, Int_t charge, Double_t x, Double_t y, Double_t z,
+  Double_t tx, Double_t ty, Double_t energy, Double_t *track) const
+{
+  H_BeamParticle particle(mass, charge);
+  particle.setPosition(x, y, tx, ty, z);
+  particle.setE(energy);
+
+  particle.computePath(fBeamLine);
+
+  if(particle.stopped(fBeamLine)) return kFALSE;
+
+  particle.propagate(fDistance);
+
+  track[0] = particle.getX();
+  track[1] = particle.getTX();
+  track[2] = particle.getY();
+  track[3] = particle.getTY();
+  track[4] = particle.getS();
+
+  return kTRUE;
+}
+
+//------------------------------------------------------------------------------
@@ -29,6 +29,8 @@
 
 #include "classes/DelphesModule.h"
 
+#include <vector>
+
 class TIterator;
 class TObjArray;
 class H_BeamLine;
@@ -46,6 +48,14 @@ public:
 
 private:
 
+  void BuildTables();
+
+  Int_t Interpolate(Double_t mass, Int_t charge, Double_t x, Double_t y, Double_t z,
+    Double_t tx, Double_t ty, Double_t energy, Double_t *track) const;
+
+  Bool_t Propagate(Double_t mass, Int_t charge, Double_t x, Double_t y, Double_t z,
+    Double_t tx, Double_t ty, Double_t energy, Double_t *track) const;
+
   Int_t fDirection;
 
   Double_t fBeamLineLength, fDistance;
@@ -53,6 +63,17 @@ private:
   Double_t fSigmaE, fSigmaX, fSigmaY, fSigmaT;
   Double_t fEtaMin;
 
+  Int_t fXiBins;
+  Double_t fXiMin, fXiMax;
+
+  // transfer matrices of neutral, positive and negative particles in bins of
+  // energy loss, at the entrance and exit of the elements with an aperture
+  // and at the two positions around Distance
+  std::vector< Double_t > fTables[3];
+  std::vector< Int_t > fApertureElements;
+  Int_t fTargetPosition, fNodeSize;
+  Double_t fTargetS[2];
+
   H_BeamLine *fBeamLine;
 
   TIterator *fItInputArray; //!
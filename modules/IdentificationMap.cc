@@ -68,7 +68,10 @@ IdentificationMap::~IdentificationMap()
 
 void IdentificationMap::Init()
 {
-  TMisIDMap::iterator itEfficiencyMap;
+  TMisIDMap::iterator itEfficiencyMap, itRange;
+  pair< TMisIDMap::iterator, TMisIDMap::iterator > range;
+  TMisIDChannels channels;
+  TMisIDChannel channel;
   ExRootConfParam param;
   DelphesFormula *formula;
   Int_t i, size, pdg;
@@ -96,6 +99,29 @@ void IdentificationMap::Init()
     fEfficiencyMap.insert(make_pair(0, make_pair(0, formula)));
   }
 
+  // resolve the output channels of every PID in the map and of its
+  // antiparticle, the other PIDs use the channels of PID = 0
+  fChannelTable.Clear();
+  for(itEfficiencyMap = fEfficiencyMap.begin(); itEfficiencyMap != fEfficiencyMap.end(); itEfficiencyMap = range.second)
+  {
+    pdg = itEfficiencyMap->first;
+    range = fEfficiencyMap.equal_range(pdg);
+
+    channels.clear();
+    for(itRange = range.first; itRange != range.second; ++itRange)
+    {
+      formula = (itRange->second).second;
+      channel.pdgCode = (itRange->second).first;
+      channel.formula = formula->IsConstant() ? 0 : formula;
+      channel.probability = formula->IsConstant() ? formula->Eval(0.0) : 0.0;
+      channels.push_back(channel);
+    }
+
+    fChannelTable.Insert(pdg, channels);
+    if(pdg != 0 && fEfficiencyMap.find(-pdg) == fEfficiencyMap.end()) fChannelTable.Insert(-pdg, channels);
+    if(pdg == 0) fDefaultChannels = channels;
+  }
+
   // import input array
 
   fInputArray = ImportArray(GetString("InputArray", "ParticlePropagator/stableParticles"));
@@ -127,9 +153,8 @@ void IdentificationMap::Process()
 {
   Candidate *candidate;
   Double_t pt, eta, phi, e;
-  TMisIDMap::iterator itEfficiencyMap;
-  pair <TMisIDMap::iterator, TMisIDMap::iterator> range;
-  DelphesFormula *formula;
+  const TMisIDChannels *channels;
+  TMisIDChannels::const_iterator itChannel;
   Int_t pdgCodeIn, pdgCodeOut, charge;
 
   Double_t p, r, total;
@@ -147,25 +172,21 @@ void IdentificationMap::Process()
     pdgCodeIn = candidate->PID;
     charge = candidate->Charge;
 
-    // first check that PID of this particle is specified in the map
-    // otherwise, look for PID = 0
-
-    itEfficiencyMap = fEfficiencyMap.find(pdgCodeIn);
+    // first check that PID of this particle or of its antiparticle is
+    // specified in the map, otherwise use PID = 0
 
-    range = fEfficiencyMap.equal_range(pdgCodeIn);
-    if(range.first == range.second) range = fEfficiencyMap.equal_range(-pdgCodeIn);
-    if(range.first == range.second) range = fEfficiencyMap.equal_range(0);
+    channels = fChannelTable.Find(pdgCodeIn);
+    if(!channels) channels = &fDefaultChannels;
 
     r = gRandom->Uniform();
     total = 0.0;
 
     // loop over sub-map for this PID
-    for(TMisIDMap::iterator it = range.first; it != range.second; ++it)
+    for(itChannel = channels->begin(); itChannel != channels->end(); ++itChannel)
     {
-      formula = (it->second).second;
-      pdgCodeOut = (it->second).first;
+      pdgCodeOut = itChannel->pdgCode;
 
-      p = formula->Eval(pt, eta, phi, e);
+      p = itChannel->formula ? itChannel->formula->Eval(pt, eta, phi, e) : itChannel->probability;
 
       if(total <= r && r < total + p)
       {
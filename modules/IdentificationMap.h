@@ -31,6 +31,13 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesPIDTable.h"
+#endif
+
+#include <map>
+#include <vector>
+
 class TIterator;
 class TObjArray;
 class DelphesFormula;
@@ -52,6 +59,22 @@ private:
 
   TMisIDMap fEfficiencyMap; //!
 
+#if !defined(__CINT__) && !defined(__CLING__)
+  // output channels of a PID, the formulas that don't depend on the
+  // kinematics are replaced by their value
+  struct TMisIDChannel
+  {
+    Int_t pdgCode;
+    DelphesFormula *formula;
+    Double_t probability;
+  };
+
+  typedef std::vector< TMisIDChannel > TMisIDChannels;
+
+  DelphesPIDTable< TMisIDChannels > fChannelTable;
+  TMisIDChannels fDefaultChannels;
+#endif
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
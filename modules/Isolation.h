@@ -48,6 +48,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
 private:
 
   Double_t fDeltaRMax;
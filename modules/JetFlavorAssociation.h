@@ -49,6 +49,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
   void GetAlgoFlavor(Candidate *jet, TObjArray *partonArray, TObjArray *partonLHEFArray);
   void GetPhysicsFlavor(Candidate *jet, TObjArray *partonArray, TObjArray *partonLHEFArray);
 
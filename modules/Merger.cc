@@ -111,16 +111,10 @@ void Merger::Finish()
 void Merger::Process()
 {
   Candidate *candidate;
-  TLorentzVector momentum;
-  Double_t sumPT, sumE;  
   vector< TIterator * >::iterator itInputList;
   TIterator *iterator;
 
-  DelphesFactory *factory = GetFactory();
-  
-  momentum.SetPxPyPzE(0.0, 0.0, 0.0, 0.0);
-  sumPT = 0;
-  sumE = 0;
+  StartEvent();
 
   // loop over all input arrays
   for(itInputList = fInputList.begin(); itInputList != fInputList.end(); ++itInputList)
@@ -131,27 +125,54 @@ void Merger::Process()
     iterator->Reset();
     while((candidate = static_cast<Candidate*>(iterator->Next())))
     {
-      const TLorentzVector &candidateMomentum = candidate->Momentum;
-
-      momentum += candidateMomentum;
-      sumPT += candidateMomentum.Pt();
-      sumE += candidateMomentum.E();
-
-      fOutputArray->Add(candidate);
+      fOutputArray->Add(ProcessCandidate(candidate));
     }
   }
 
+  FinishEvent();
+}
+
+//------------------------------------------------------------------------------
+
+void Merger::StartEvent()
+{
+  fMomentum.SetPxPyPzE(0.0, 0.0, 0.0, 0.0);
+  fSumPT = 0;
+  fSumE = 0;
+}
+
+//------------------------------------------------------------------------------
+
+Candidate *Merger::ProcessCandidate(Candidate *candidate)
+{
+  const TLorentzVector &candidateMomentum = candidate->Momentum;
+
+  fMomentum += candidateMomentum;
+  fSumPT += candidateMomentum.Pt();
+  fSumE += candidateMomentum.E();
+
+  return candidate;
+}
+
+//------------------------------------------------------------------------------
+
+void Merger::FinishEvent()
+{
+  Candidate *candidate;
+
+  DelphesFactory *factory = GetFactory();
+
   candidate = factory->NewCandidate();
   
   candidate->Position.SetXYZT(0.0, 0.0, 0.0, 0.0);
-  candidate->Momentum = momentum;
+  candidate->Momentum = fMomentum;
   
   fMomentumOutputArray->Add(candidate);
 
   candidate = factory->NewCandidate();
   
   candidate->Position.SetXYZT(0.0, 0.0, 0.0, 0.0);
-  candidate->Momentum.SetPtEtaPhiE(sumPT, 0.0, 0.0, sumE);
+  candidate->Momentum.SetPtEtaPhiE(fSumPT, 0.0, 0.0, fSumE);
   
   fEnergyOutputArray->Add(candidate);
 }
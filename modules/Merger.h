@@ -30,6 +30,8 @@
 
 #include "classes/DelphesModule.h"
 
+#include "TLorentzVector.h"
+
 #include <vector>
 
 class TIterator;
@@ -46,6 +48,13 @@ public:
   void Process();
   void Finish();
 
+  Bool_t IsElementWise() const { return kTRUE; }
+  Bool_t IsConcurrent() const { return kTRUE; }
+
+  void StartEvent();
+  Candidate *ProcessCandidate(Candidate *candidate);
+  void FinishEvent();
+
 private:
 
   std::vector< TIterator * > fInputList; //!
@@ -54,6 +63,9 @@ private:
   TObjArray *fMomentumOutputArray; //!
   TObjArray *fEnergyOutputArray; //!
 
+  TLorentzVector fMomentum; //!
+  Double_t fSumPT, fSumE; //!
+
   ClassDef(Merger, 1)
 };
 
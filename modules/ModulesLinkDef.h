@@ -50,6 +50,7 @@
 #include "modules/TrackCountingTauTagging.h"
 #include "modules/TreeWriter.h"
 #include "modules/Merger.h"
+#include "modules/Pipeline.h"
 #include "modules/LeptonDressing.h"
 #include "modules/PileUpMerger.h"
 #include "modules/JetPileUpSubtractor.h"
@@ -104,6 +105,7 @@
 #pragma link C++ class TrackCountingTauTagging+;
 #pragma link C++ class TreeWriter+;
 #pragma link C++ class Merger+;
+#pragma link C++ class Pipeline+;
 #pragma link C++ class LeptonDressing+;
 #pragma link C++ class PileUpMerger+;
 #pragma link C++ class JetPileUpSubtractor+;
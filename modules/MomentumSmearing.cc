@@ -69,9 +69,18 @@ MomentumSmearing::~MomentumSmearing()
 
 void MomentumSmearing::Init()
 {
-  // read resolution formula
+  // read resolution formula, with a snapshot its table is read back and
+  // the formula is compiled only if the table doesn't replace it;
+  // TabulateResolution false always evaluates the formula
 
-  fFormula->Compile(GetString("ResolutionFormula", "0.0"));
+  Bool_t tabulate = GetBool("TabulateResolution", true);
+
+  fFormula->CompileLater(GetString("ResolutionFormula", "0.0"));
+  if(!tabulate || !fResolutionTable.Read(GetSnapshot(), "ResolutionTable", fFormula))
+  {
+    fFormula->CompilePending();
+    fResolutionTable.Build(fFormula, tabulate);
+  }
 
   // import input array
 
@@ -85,6 +94,13 @@ void MomentumSmearing::Init()
 
 //------------------------------------------------------------------------------
 
+void MomentumSmearing::SaveState(TDirectory *directory)
+{
+  fResolutionTable.Write(directory, "ResolutionTable");
+}
+
+//------------------------------------------------------------------------------
+
 void MomentumSmearing::Finish()
 {
   if(fItInputArray) delete fItInputArray;
@@ -94,41 +110,50 @@ void MomentumSmearing::Finish()
 
 void MomentumSmearing::Process()
 {
-  Candidate *candidate, *mother;
-  Double_t pt, eta, phi, e, res;
+  Candidate *candidate;
 
   fItInputArray->Reset();
   while((candidate = static_cast<Candidate*>(fItInputArray->Next())))
   {
-    const TLorentzVector &candidatePosition = candidate->Position;
-    const TLorentzVector &candidateMomentum = candidate->Momentum;
-    eta = candidatePosition.Eta();
-    phi = candidatePosition.Phi();
-    pt = candidateMomentum.Pt();
-    e = candidateMomentum.E();
-    res = fFormula->Eval(pt, eta, phi, e);
- 
-    // apply smearing formula
-    //pt = gRandom->Gaus(pt, fFormula->Eval(pt, eta, phi, e) * pt);
-    
-    res = ( res > 1.0 ) ? 1.0 : res; 
-
-    pt = LogNormal(pt, res * pt );
-    
-    //if(pt <= 0.0) continue;
-
-    mother = candidate;
-    candidate = static_cast<Candidate*>(candidate->Clone());
-    eta = candidateMomentum.Eta();
-    phi = candidateMomentum.Phi();
-    candidate->Momentum.SetPtEtaPhiE(pt, eta, phi, pt*TMath::CosH(eta));
-    //candidate->TrackResolution = fFormula->Eval(pt, eta, phi, e);
-    candidate->TrackResolution = res;
-    candidate->AddCandidate(mother);
-        
-    fOutputArray->Add(candidate);
+    fOutputArray->Add(ProcessCandidate(candidate));
   }
 }
+
+//------------------------------------------------------------------------------
+
+Candidate *MomentumSmearing::ProcessCandidate(Candidate *candidate)
+{
+  Candidate *mother;
+  Double_t pt, eta, phi, e, res;
+
+  const TLorentzVector &candidatePosition = candidate->Position;
+  const TLorentzVector &candidateMomentum = candidate->Momentum;
+  eta = candidatePosition.Eta();
+  phi = candidatePosition.Phi();
+  pt = candidateMomentum.Pt();
+  e = candidateMomentum.E();
+  res = fResolutionTable.Eval(pt, eta, phi, e);
+
+  // apply smearing formula
+  //pt = gRandom->Gaus(pt, fFormula->Eval(pt, eta, phi, e) * pt);
+  
+  res = ( res > 1.0 ) ? 1.0 : res; 
+
+  pt = LogNormal(pt, res * pt );
+  
+  //if(pt <= 0.0) continue;
+
+  mother = candidate;
+  candidate = static_cast<Candidate*>(candidate->Clone());
+  eta = candidateMomentum.Eta();
+  phi = candidateMomentum.Phi();
+  candidate->Momentum.SetPtEtaPhiE(pt, eta, phi, pt*TMath::CosH(eta));
+  //candidate->TrackResolution = fFormula->Eval(pt, eta, phi, e);
+  candidate->TrackResolution = res;
+  candidate->AddCandidate(mother);
+
+  return candidate;
+}
 //----------------------------------------------------------------
 
 Double_t MomentumSmearing::LogNormal(Double_t mean, Double_t sigma)
@@ -29,6 +29,10 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesResolutionTable.h"
+#endif
+
 class TIterator;
 class TObjArray;
 class DelphesFormula;
@@ -44,12 +48,22 @@ public:
   void Process();
   void Finish();
 
+  void SaveState(TDirectory *directory);
+
+  Bool_t IsElementWise() const { return kTRUE; }
+
+  Candidate *ProcessCandidate(Candidate *candidate);
+
 private:
 
   Double_t LogNormal(Double_t mean, Double_t sigma);
 
   DelphesFormula *fFormula; //!
 
+#if !defined(__CINT__) && !defined(__CLING__)
+  DelphesResolutionTable fResolutionTable; //!
+#endif
+
   TIterator *fItInputArray; //!
 
   const TObjArray *fInputArray; //!
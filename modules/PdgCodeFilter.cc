@@ -112,26 +112,36 @@ void PdgCodeFilter::Finish()
 void PdgCodeFilter::Process()
 {
   Candidate *candidate;
-  Int_t pdgCode;
-  Bool_t pass;
-  Double_t pt;
 
   fItInputArray->Reset();
   while((candidate = static_cast<Candidate*>(fItInputArray->Next())))
   {
-    pdgCode = candidate->PID;
-    const TLorentzVector &candidateMomentum = candidate->Momentum;
-    pt = candidateMomentum.Pt();
+    candidate = ProcessCandidate(candidate);
+    if(candidate) fOutputArray->Add(candidate);
+  }
+}
 
-    if(pt < fPTMin) continue;
-    if(fRequireStatus && (candidate->Status != fStatus)) continue;
-    if(fRequireCharge && (candidate->Charge != fCharge)) continue;
+//------------------------------------------------------------------------------
 
-    pass = kTRUE;
-    if(find(fPdgCodes.begin(), fPdgCodes.end(), pdgCode) != fPdgCodes.end()) pass = kFALSE;
+Candidate *PdgCodeFilter::ProcessCandidate(Candidate *candidate)
+{
+  Int_t pdgCode;
+  Bool_t pass;
+  Double_t pt;
 
-    if(fInvert) pass = !pass;
-    if(pass) fOutputArray->Add(candidate);
-  }
+  pdgCode = candidate->PID;
+  const TLorentzVector &candidateMomentum = candidate->Momentum;
+  pt = candidateMomentum.Pt();
+
+  if(pt < fPTMin) return 0;
+  if(fRequireStatus && (candidate->Status != fStatus)) return 0;
+  if(fRequireCharge && (candidate->Charge != fCharge)) return 0;
+
+  pass = kTRUE;
+  if(find(fPdgCodes.begin(), fPdgCodes.end(), pdgCode) != fPdgCodes.end()) pass = kFALSE;
+
+  if(fInvert) pass = !pass;
+
+  return pass ? candidate : 0;
 }
 
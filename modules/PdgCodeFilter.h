@@ -46,6 +46,11 @@ public:
   void Process();
   void Finish();
 
+  Bool_t IsElementWise() const { return kTRUE; }
+  Bool_t IsConcurrent() const { return kTRUE; }
+
+  Candidate *ProcessCandidate(Candidate *candidate);
+
 private:
 
   Double_t fPTMin; //!
@@ -30,6 +30,7 @@
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesTF2.h"
 #include "classes/DelphesPileUpReader.h"
+#include "classes/DelphesSnapshot.h"
 
 #include "ExRootAnalysis/ExRootResult.h"
 #include "ExRootAnalysis/ExRootFilter.h"
@@ -37,6 +38,7 @@
 
 #include "TMath.h"
 #include "TString.h"
+#include "TDirectory.h"
 #include "TFormula.h"
 #include "TRandom3.h"
 #include "TObjArray.h"
@@ -71,6 +73,7 @@ PileUpMerger::~PileUpMerger()
 void PileUpMerger::Init()
 {
   const char *fileName;
+  vector< char > *index = 0;
 
   fPileUpDistribution = GetInt("PileUpDistribution", 0);
 
@@ -90,7 +93,18 @@ void PileUpMerger::Init()
   fFunction->SetRange(-fZVertexSpread, -fTVertexSpread, fZVertexSpread, fTVertexSpread);
 
   fileName = GetString("PileUpFile", "MinBias.pileup");
-  fReader = new DelphesPileUpReader(fileName);
+  fReader = new DelphesPileUpReader(fileName, kFALSE);
+
+  // read index of pile-up events, from the snapshot if the file is unchanged
+  if(DelphesSnapshot::CheckFileStamp(GetSnapshot(), fileName))
+  {
+    GetSnapshot()->GetObject("Index", index);
+  }
+  if(!index || index->empty() || !fReader->SetIndex(reinterpret_cast< uint8_t * >(&(*index)[0]), index->size()))
+  {
+    fReader->ReadIndex();
+  }
+  delete index;
 
   // import input array
   fInputArray = ImportArray(GetString("InputArray", "Delphes/stableParticles"));
@@ -103,6 +117,17 @@ void PileUpMerger::Init()
 
 //------------------------------------------------------------------------------
 
+void PileUpMerger::SaveState(TDirectory *directory)
+{
+  const char *index = reinterpret_cast< const char * >(fReader->GetIndex());
+  vector< char > buffer(index, index + fReader->GetIndexSize());
+
+  DelphesSnapshot::WriteFileStamp(directory, GetString("PileUpFile", "MinBias.pileup"));
+  directory->WriteObject(&buffer, "Index");
+}
+
+//------------------------------------------------------------------------------
+
 void PileUpMerger::Finish()
 {
   if(fReader) delete fReader;
@@ -44,6 +44,8 @@ public:
   void Process();
   void Finish();
 
+  void SaveState(TDirectory *directory);
+
 private:
 
   Int_t fPileUpDistribution;
@@ -0,0 +1,280 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/** \class Pipeline
+ *
+ *  Runs element-wise modules in a single pass per candidate.
+ *
+ */
+
+#include "modules/Pipeline.h"
+
+#include "classes/DelphesClasses.h"
+
+#include "TFolder.h"
+#include "TObjArray.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+Pipeline::Pipeline() :
+  fConsumersFound(kFALSE)
+{
+}
+
+//------------------------------------------------------------------------------
+
+Pipeline::~Pipeline()
+{
+}
+
+//------------------------------------------------------------------------------
+
+void Pipeline::Init()
+{
+  stringstream message;
+  ExRootConfParam param = GetParam("Modules");
+  Long_t i, size = param.GetSize();
+  const ExRootConfReader::ExRootTaskMap *modules = GetModules();
+  ExRootConfReader::ExRootTaskMap::const_iterator itModules;
+  ExRootTask *task;
+  DelphesModule *module;
+  TObject *object;
+  TString name;
+  Int_t stage, j, k;
+  vector< vector< Int_t > > sources;
+
+  fStages.clear();
+  fOutputArrays.clear();
+  fConsumers.clear();
+  fSources.clear();
+  fConsumersFound = kFALSE;
+
+  for(i = 0; i < size; ++i)
+  {
+    name = param[i].GetString();
+    itModules = modules->find(name);
+    if(itModules == modules->end())
+    {
+      message << "module '" << name;
+      message << "' is specified in Pipeline '" << GetName() << "' but not configured.";
+      throw runtime_error(message.str());
+    }
+
+    task = NewTask(itModules->second, itModules->first);
+    if(!task->InheritsFrom(DelphesModule::Class()) || !static_cast<DelphesModule *>(task)->IsElementWise())
+    {
+      delete task;
+      message << "module '" << name;
+      message << "' in Pipeline '" << GetName() << "' does not process candidates one by one";
+      throw runtime_error(message.str());
+    }
+
+    // the stages are inactive subtasks, they are only run by the pipeline
+    module = static_cast<DelphesModule *>(task);
+    module->SetActive(kFALSE);
+    Add(module);
+
+    cout << left;
+    cout << setw(30) << "** INFO: initializing module";
+    cout << setw(25) << name << endl;
+    module->Init();
+
+    if(!module->GetImportFolder() || !module->GetExportFolder())
+    {
+      message << "module '" << name;
+      message << "' in Pipeline '" << GetName() << "' has no input or output array";
+      throw runtime_error(message.str());
+    }
+
+    stage = fStages.size();
+    fStages.push_back(module);
+    TIter itOutputs(module->GetExportFolder()->GetListOfFolders());
+    fOutputArrays.push_back(static_cast<TObjArray *>(itOutputs()));
+    fConsumers.push_back(-1);
+    sources.push_back(vector< Int_t >());
+
+    // inputs are the outputs of earlier stages or arrays from outside
+    TIter itInputs(module->GetImportFolder()->GetListOfFolders());
+    while((object = itInputs()))
+    {
+      for(j = 0; j < stage && fOutputArrays[j] != object; ++j);
+
+      if(j < stage)
+      {
+        if(fConsumers[j] >= 0)
+        {
+          message << "output of module '" << fStages[j]->GetName();
+          message << "' is used twice in Pipeline '" << GetName() << "'";
+          throw runtime_error(message.str());
+        }
+        fConsumers[j] = stage;
+        sources[stage].insert(sources[stage].end(), sources[j].begin(), sources[j].end());
+      }
+      else
+      {
+        sources[stage].push_back(fSources.size());
+        fSources.push_back(make_pair(static_cast<const TObjArray *>(object), stage));
+      }
+    }
+
+    // the candidates arrive in the order of the sources
+    for(k = 1; k < Int_t(sources[stage].size()); ++k)
+    {
+      if(sources[stage][k - 1] < sources[stage][k]) continue;
+      message << "inputs of module '" << name;
+      message << "' do not follow the order of Pipeline '" << GetName() << "'";
+      throw runtime_error(message.str());
+    }
+  }
+
+  fFilled.assign(fStages.size(), kTRUE);
+}
+
+//------------------------------------------------------------------------------
+
+void Pipeline::Finish()
+{
+  vector< DelphesModule * >::iterator itStages;
+
+  for(itStages = fStages.begin(); itStages != fStages.end(); ++itStages)
+  {
+    (*itStages)->Finish();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void Pipeline::FindConsumers()
+{
+  TFolder *folder, *importFolder;
+  TObject *object;
+  UInt_t i;
+
+  // all modules have imported their arrays in Init
+  importFolder = static_cast<TFolder *>(GetFolder()->FindObject("Import"));
+
+  for(i = 0; i < fStages.size(); ++i) fFilled[i] = (fConsumers[i] < 0);
+
+  TIter itFolders(importFolder ? importFolder->GetListOfFolders() : 0);
+  while((folder = static_cast<TFolder *>(itFolders())))
+  {
+    for(i = 0; i < fStages.size() && folder != fStages[i]->GetImportFolder(); ++i);
+    if(i < fStages.size()) continue;
+
+    TIter itArrays(folder->GetListOfFolders());
+    while((object = itArrays()))
+    {
+      for(i = 0; i < fStages.size(); ++i)
+      {
+        if(object == fOutputArrays[i]) fFilled[i] = kTRUE;
+      }
+    }
+  }
+
+  for(i = 0; i < fStages.size(); ++i)
+  {
+    if(fFilled[i]) continue;
+    cout << "** INFO: Pipeline " << GetName() << " doesn't fill ";
+    cout << fStages[i]->GetName() << "/" << fOutputArrays[i]->GetName() << endl;
+  }
+
+  fConsumersFound = kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
+void Pipeline::Push(Int_t stage, Candidate *candidate)
+{
+  while(stage >= 0)
+  {
+    candidate = fStages[stage]->ProcessCandidate(candidate);
+    if(!candidate) return;
+
+    if(fFilled[stage]) fOutputArrays[stage]->Add(candidate);
+
+    stage = fConsumers[stage];
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void Pipeline::Process()
+{
+  vector< DelphesModule * >::iterator itStages;
+  vector< pair< const TObjArray *, Int_t > >::iterator itSources;
+  Candidate *candidate;
+
+  if(!fConsumersFound) FindConsumers();
+
+  for(itStages = fStages.begin(); itStages != fStages.end(); ++itStages)
+  {
+    (*itStages)->StartEvent();
+  }
+
+  for(itSources = fSources.begin(); itSources != fSources.end(); ++itSources)
+  {
+    TIter itInputArray(itSources->first);
+    while((candidate = static_cast<Candidate *>(itInputArray())))
+    {
+      Push(itSources->second, candidate);
+    }
+  }
+
+  for(itStages = fStages.begin(); itStages != fStages.end(); ++itStages)
+  {
+    (*itStages)->FinishEvent();
+  }
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t Pipeline::IsConcurrent() const
+{
+  vector< DelphesModule * >::const_iterator itStages;
+
+  for(itStages = fStages.begin(); itStages != fStages.end(); ++itStages)
+  {
+    if(!(*itStages)->IsConcurrent()) return kFALSE;
+  }
+
+  return kTRUE;
+}
+
+//------------------------------------------------------------------------------
+
+Bool_t Pipeline::ModifiesInputs() const
+{
+  vector< DelphesModule * >::const_iterator itStages;
+
+  for(itStages = fStages.begin(); itStages != fStages.end(); ++itStages)
+  {
+    if((*itStages)->ModifiesInputs()) return kTRUE;
+  }
+
+  return kFALSE;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+/*
+ *  Delphes: a framework for fast simulation of a generic collider experiment
+ *  Copyright (C) 2012-2014  Universite catholique de Louvain (UCL), Belgium
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Pipeline_h
+#define Pipeline_h
+
+/** \class Pipeline
+ *
+ *  Runs element-wise modules (Efficiency, MomentumSmearing, EnergyScale,
+ *  PdgCodeFilter, Merger) in a single pass per candidate. The modules are
+ *  configured as usual and listed in the Modules parameter, in the order
+ *  they would have in the ExecutionPath, instead of the ExecutionPath:
+ *
+ *    module Pipeline TrackPipeline {
+ *      set Modules {ChargedHadronTrackingEfficiency ChargedHadronMomentumSmearing}
+ *    }
+ *
+ *  A module importing the output of an earlier module of the pipeline gets
+ *  its candidates directly, this output array is only filled if it is
+ *  imported by a module outside of the pipeline or if no module of the
+ *  pipeline uses it. The random numbers are drawn candidate by candidate,
+ *  in a different order than with separate modules.
+ *
+ */
+
+#include "classes/DelphesModule.h"
+
+#include <vector>
+#include <utility>
+
+class TObjArray;
+class Candidate;
+
+class Pipeline: public DelphesModule
+{
+public:
+
+  Pipeline();
+  ~Pipeline();
+
+  void Init();
+  void Process();
+  void Finish();
+
+  // the pipeline is concurrent when all its stages are
+  Bool_t IsConcurrent() const;
+
+  // the pipeline modifies its inputs when one of its stages does
+  Bool_t ModifiesInputs() const;
+
+private:
+
+  void FindConsumers();
+  void Push(Int_t stage, Candidate *candidate);
+
+  std::vector< DelphesModule * > fStages; //!
+
+  std::vector< TObjArray * > fOutputArrays; //!
+
+  // stage fed by the output of each stage, -1 if none
+  std::vector< Int_t > fConsumers; //!
+  std::vector< Bool_t > fFilled; //!
+
+#if !defined(__CINT__) && !defined(__CLING__)
+  // arrays from outside of the pipeline and stages reading them
+  std::vector< std::pair< const TObjArray *, Int_t > > fSources; //!
+#endif
+
+  Bool_t fConsumersFound; //!
+
+  ClassDef(Pipeline, 1)
+};
+
+#endif
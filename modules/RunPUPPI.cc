@@ -159,16 +159,14 @@ void RunPUPPI::Process(){
   fItNeutralInputArray ->Reset();
   fPVItInputArray      ->Reset();
 
-  std::vector<Candidate *> InputParticles;
-  InputParticles.clear();
+  fInputParticles.clear();
 
   // take the leading vertex 
   float PVZ = 0.;
   Candidate *pv = static_cast<Candidate*>(fPVItInputArray->Next());
   if (pv) PVZ = pv->Position.Z();
   // Fill input particles for puppi
-  std::vector<RecoObj> puppiInputVector;
-  puppiInputVector.clear();
+  fPuppiInputVector.clear();
   int lNBad  = 0; 
   // Loop on charge track candidate
   while((candidate = static_cast<Candidate*>(fItTrackInputArray->Next()))){   
@@ -204,8 +202,8 @@ void RunPUPPI::Process(){
         continue;
       }
 
-      puppiInputVector.push_back(curRecoObj);
-      InputParticles.push_back(candidate);
+      fPuppiInputVector.push_back(curRecoObj);
+      fInputParticles.push_back(candidate);
   }
 
   // Loop on neutral calo cells 
@@ -231,22 +229,22 @@ void RunPUPPI::Process(){
 	std::cerr<<" RunPUPPI: problem with a neutrals cells --> it has charge !=0 "<<std::endl;
         continue;
       }
-      puppiInputVector.push_back(curRecoObj);
-      InputParticles.push_back(candidate);
+      fPuppiInputVector.push_back(curRecoObj);
+      fInputParticles.push_back(candidate);
   }
   // Create PUPPI container
-  fPuppi->initialize(puppiInputVector);
+  fPuppi->initialize(fPuppiInputVector);
   fPuppi->puppiWeights();
-  std::vector<PseudoJet> puppiParticles = fPuppi->puppiParticles();
+  const std::vector<PseudoJet> &puppiParticles = fPuppi->puppiParticles();
 
   // Loop on final particles
-  for (std::vector<PseudoJet>::iterator it = puppiParticles.begin() ; it != puppiParticles.end() ; it++) {
-    if(it->user_index() <= int(InputParticles.size())){      
-      candidate = static_cast<Candidate *>(InputParticles.at(it->user_index())->Clone());
+  for (std::vector<PseudoJet>::const_iterator it = puppiParticles.begin() ; it != puppiParticles.end() ; it++) {
+    if(it->user_index() <= int(fInputParticles.size())){      
+      candidate = static_cast<Candidate *>(fInputParticles.at(it->user_index())->Clone());
       candidate->Momentum.SetPxPyPzE(it->px(),it->py(),it->pz(),it->e());
       fOutputArray->Add(candidate);
-      if( puppiInputVector.at(it->user_index()).id == 1 or puppiInputVector.at(it->user_index()).id == 2) fOutputTrackArray->Add(candidate);
-      else if (puppiInputVector.at(it->user_index()).id == 0) fOutputNeutralArray->Add(candidate);
+      if( fPuppiInputVector.at(it->user_index()).id == 1 or fPuppiInputVector.at(it->user_index()).id == 2) fOutputTrackArray->Add(candidate);
+      else if (fPuppiInputVector.at(it->user_index()).id == 0) fOutputNeutralArray->Add(candidate);
     }
     else{ 
       std::cerr<<" particle not found in the input Array --> skip "<<std::endl;
@@ -2,10 +2,12 @@
 #define RunPUPPI_h
 
 #include "classes/DelphesModule.h"
+#include "PUPPI/RecoObj2.hh"
 #include <vector>
 
 class TObjArray;
 class TIterator;
+class Candidate;
 class PuppiContainer;
 
 class RunPUPPI: public DelphesModule {
@@ -29,6 +31,9 @@ class RunPUPPI: public DelphesModule {
   const TObjArray *fNeutralInputArray; //!
   const TObjArray *fPVInputArray; //!                                                                                                                                                     
   PuppiContainer* fPuppi;
+  // inputs of puppi, kept from event to event
+  std::vector<Candidate *> fInputParticles; //!
+  std::vector<RecoObj> fPuppiInputVector; //!
   // puppi parameters
   bool fApplyNoLep;
   double fMinPuppiWeight;
@@ -31,12 +31,14 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesFormula.h"
+#include "classes/DelphesSnapshot.h"
 
 #include "ExRootAnalysis/ExRootResult.h"
 #include "ExRootAnalysis/ExRootFilter.h"
 #include "ExRootAnalysis/ExRootClassifier.h"
 
 #include "TMath.h"
+#include "TDirectory.h"
 #include "TString.h"
 #include "TFormula.h"
 #include "TRandom3.h"
@@ -85,40 +87,45 @@ void SimpleCalorimeter::Init()
   TBinMap::iterator itEtaBin;
   set< Double_t >::iterator itPhiBin;
   vector< Double_t > *phiBins;
+  vector< Double_t > towerEta;
+  Bool_t tabulate;
 
-  // read eta and phi bins
-  param = GetParam("EtaPhiBins");
-  size = param.GetSize();
+  // read eta and phi bins, from the snapshot if there is one
   fBinMap.clear();
   fEtaBins.clear();
   fPhiBins.clear();
-  for(i = 0; i < size/2; ++i)
+  if(!DelphesSnapshot::ReadBins(GetSnapshot(), fEtaBins, fPhiBins))
   {
-    paramEtaBins = param[i*2];
-    sizeEtaBins = paramEtaBins.GetSize();
-    paramPhiBins = param[i*2 + 1];
-    sizePhiBins = paramPhiBins.GetSize();
-
-    for(j = 0; j < sizeEtaBins; ++j)
+    param = GetParam("EtaPhiBins");
+    size = param.GetSize();
+    for(i = 0; i < size/2; ++i)
     {
-      for(k = 0; k < sizePhiBins; ++k)
+      paramEtaBins = param[i*2];
+      sizeEtaBins = paramEtaBins.GetSize();
+      paramPhiBins = param[i*2 + 1];
+      sizePhiBins = paramPhiBins.GetSize();
+
+      for(j = 0; j < sizeEtaBins; ++j)
       {
-        fBinMap[paramEtaBins[j].GetDouble()].insert(paramPhiBins[k].GetDouble());
+        for(k = 0; k < sizePhiBins; ++k)
+        {
+          fBinMap[paramEtaBins[j].GetDouble()].insert(paramPhiBins[k].GetDouble());
+        }
       }
     }
-  }
 
-  // for better performance we transform map of sets to parallel vectors:
-  // vector< double > and vector< vector< double >* >
-  for(itEtaBin = fBinMap.begin(); itEtaBin != fBinMap.end(); ++itEtaBin)
-  {
-    fEtaBins.push_back(itEtaBin->first);
-    phiBins = new vector< double >(itEtaBin->second.size());
-    fPhiBins.push_back(phiBins);
-    phiBins->clear();
-    for(itPhiBin = itEtaBin->second.begin(); itPhiBin != itEtaBin->second.end(); ++itPhiBin)
+    // for better performance we transform map of sets to parallel vectors:
+    // vector< double > and vector< vector< double >* >
+    for(itEtaBin = fBinMap.begin(); itEtaBin != fBinMap.end(); ++itEtaBin)
     {
-      phiBins->push_back(*itPhiBin);
+      fEtaBins.push_back(itEtaBin->first);
+      phiBins = new vector< double >(itEtaBin->second.size());
+      fPhiBins.push_back(phiBins);
+      phiBins->clear();
+      for(itPhiBin = itEtaBin->second.begin(); itPhiBin != itEtaBin->second.end(); ++itPhiBin)
+      {
+        phiBins->push_back(*itPhiBin);
+      }
     }
   }
 
@@ -148,8 +155,21 @@ void SimpleCalorimeter::Init()
   // switch on or off the dithering of the center of calorimeter towers
   fSmearTowerCenter = GetBool("SmearTowerCenter", true);
 
-  // read resolution formulas
-  fResolutionFormula->Compile(GetString("ResolutionFormula", "0"));
+  // read resolution formula, with a snapshot its table is read back and
+  // the formula is compiled only if it has to be evaluated
+  fResolutionFormula->CompileLater(GetString("ResolutionFormula", "0"));
+
+  // tabulate it at the eta of the towers, TabulateResolution false
+  // always evaluates the formula
+  tabulate = GetBool("TabulateResolution", true);
+  if(!tabulate || !fResolutionTable.Read(GetSnapshot(), "ResolutionTable", fResolutionFormula))
+  {
+    for(i = 1; i < Long_t(fEtaBins.size()); ++i)
+    {
+      towerEta.push_back(0.5*(fEtaBins[i - 1] + fEtaBins[i]));
+    }
+    fResolutionTable.Build(fResolutionFormula, towerEta, tabulate);
+  }
 
   // import array with output from other modules
   fParticleInputArray = ImportArray(GetString("ParticleInputArray", "ParticlePropagator/particles"));
@@ -167,6 +187,14 @@ void SimpleCalorimeter::Init()
 
 //------------------------------------------------------------------------------
 
+void SimpleCalorimeter::SaveState(TDirectory *directory)
+{
+  DelphesSnapshot::WriteBins(directory, fEtaBins, fPhiBins);
+  fResolutionTable.Write(directory, "ResolutionTable");
+}
+
+//------------------------------------------------------------------------------
+
 void SimpleCalorimeter::Finish()
 {
   vector< vector< Double_t >* >::iterator itPhiBin;
@@ -323,6 +351,7 @@ void SimpleCalorimeter::Process()
       phiBins = fPhiBins[etaBin];
 
       // calculate eta and phi of the tower's center
+      fTowerEtaBin = etaBin;
       fTowerEta = 0.5*(fEtaBins[etaBin - 1] + fEtaBins[etaBin]);
       fTowerPhi = 0.5*((*phiBins)[phiBin - 1] + (*phiBins)[phiBin]);
 
@@ -366,7 +395,7 @@ void SimpleCalorimeter::Process()
              
        // compute total charged energy	 
        fTrackEnergy += energy;
-       sigma = fResolutionFormula->Eval(0.0, fTowerEta, 0.0, momentum.E());
+       sigma = fResolutionTable.Eval(fTowerEtaBin - 1, momentum.E());
        if(sigma/momentum.E() < track->TrackResolution) energyGuess = energy;
        else energyGuess = momentum.E();
 
@@ -420,13 +449,13 @@ void SimpleCalorimeter::FinalizeTower()
 
   if(!fTower) return;
 
-  sigma = fResolutionFormula->Eval(0.0, fTowerEta, 0.0, fTowerEnergy);
+  sigma = fResolutionTable.Eval(fTowerEtaBin - 1, fTowerEnergy);
 
   energy = LogNormal(fTowerEnergy, sigma);
 
   time = (fTowerTimeWeight < 1.0E-09 ) ? 0.0 : fTowerTime/fTowerTimeWeight;
 
-  sigma = fResolutionFormula->Eval(0.0, fTowerEta, 0.0, energy);
+  sigma = fResolutionTable.Eval(fTowerEtaBin - 1, energy);
 
   if(energy < fEnergyMin || energy < fEnergySignificanceMin*sigma) energy = 0.0;
 
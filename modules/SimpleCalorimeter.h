@@ -31,11 +31,16 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesResolutionTable.h"
+#endif
+
 #include <map>
 #include <set>
 #include <vector>
 
 class TObjArray;
+class TDirectory;
 class DelphesFormula;
 class Candidate;
 
@@ -50,12 +55,15 @@ public:
   void Process();
   void Finish();
 
+  void SaveState(TDirectory *directory);
+
 private:
 
   typedef std::map< Long64_t, Double_t > TFractionMap; //!
   typedef std::map< Double_t, std::set< Double_t > > TBinMap; //!
 
   Candidate *fTower;
+  Short_t fTowerEtaBin;
   Double_t fTowerEta, fTowerPhi, fTowerEdges[4];
   Double_t fTowerEnergy;
   Double_t fTrackEnergy;
@@ -92,6 +100,11 @@ private:
 
   DelphesFormula *fResolutionFormula; //!
 
+#if !defined(__CINT__) && !defined(__CLING__)
+  // resolution formula at the eta of the towers
+  DelphesResolutionTable fResolutionTable; //!
+#endif
+
   TIterator *fItParticleInputArray; //!
   TIterator *fItTrackInputArray; //!
 
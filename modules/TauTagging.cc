@@ -105,7 +105,7 @@ Int_t TauTaggingPartonClassifier::GetCategory(TObject *object)
 //------------------------------------------------------------------------------
 
 TauTagging::TauTagging() :
-  fClassifier(0), fFilter(0),
+  fDefaultFormula(0), fClassifier(0), fFilter(0),
   fItPartonInputArray(0), fItJetInputArray(0)
 {
 }
@@ -152,6 +152,14 @@ void TauTagging::Init()
     fEfficiencyMap[0] = formula;
   }
 
+  // fill the PID lookup table used for every jet
+  fEfficiencyTable.Clear();
+  for(itEfficiencyMap = fEfficiencyMap.begin(); itEfficiencyMap != fEfficiencyMap.end(); ++itEfficiencyMap)
+  {
+    fEfficiencyTable.Insert(itEfficiencyMap->first, itEfficiencyMap->second);
+  }
+  fDefaultFormula = fEfficiencyMap[0];
+
   // import input array(s)
 
   fParticleInputArray = ImportArray(GetString("ParticleInputArray", "Delphes/allParticles"));
@@ -196,7 +204,6 @@ void TauTagging::Process()
   TLorentzVector tauMomentum;
   Double_t pt, eta, phi, e, eff;
   TObjArray *tauArray;
-  map< Int_t, DelphesFormula * >::iterator itEfficiencyMap;
   DelphesFormula *formula;
   Int_t pdgCode, charge, i;
 
@@ -246,12 +253,7 @@ void TauTagging::Process()
       }
     }
     // find an efficency formula
-    itEfficiencyMap = fEfficiencyMap.find(pdgCode);
-    if(itEfficiencyMap == fEfficiencyMap.end())
-    {
-      itEfficiencyMap = fEfficiencyMap.find(0);
-    }
-    formula = itEfficiencyMap->second;
+    formula = fEfficiencyTable.Get(pdgCode, fDefaultFormula);
 
     // apply an efficency formula
     eff = formula->Eval(pt, eta, phi, e);
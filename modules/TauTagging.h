@@ -34,6 +34,10 @@
 #include "ExRootAnalysis/ExRootFilter.h"
 #include "ExRootAnalysis/ExRootClassifier.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesPIDTable.h"
+#endif
+
 #include <map>
 
 class TObjArray;
@@ -53,6 +57,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
 private:
   
   Int_t fBitNumber;
@@ -61,6 +67,9 @@ private:
 
 #if !defined(__CINT__) && !defined(__CLING__)
   std::map< Int_t, DelphesFormula * > fEfficiencyMap; //!
+
+  DelphesPIDTable< DelphesFormula * > fEfficiencyTable; //!
+  DelphesFormula *fDefaultFormula; //!
 #endif
   
   TauTaggingPartonClassifier *fClassifier; //!
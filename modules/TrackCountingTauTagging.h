@@ -36,6 +36,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
 private:
 
   Int_t fBitNumber;
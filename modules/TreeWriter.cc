@@ -20,6 +20,7 @@
 /** \class TreeWriter
  *
  *  Fills ROOT tree branches.
+ *  With Columnar set, branches are written as flat per-member arrays.
  *
  *  \author P. Demin - UCL, Louvain-la-Neuve
  *
@@ -35,6 +36,8 @@
 #include "ExRootAnalysis/ExRootFilter.h"
 #include "ExRootAnalysis/ExRootClassifier.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
+#include "ExRootAnalysis/ExRootTreeWriter.h"
+#include "ExRootAnalysis/ExRootTreeLinkBranch.h"
 
 #include "TROOT.h"
 #include "TMath.h"
@@ -85,6 +88,24 @@ void TreeWriter::Init()
   TBranchMap::iterator itBranchMap;
   map< TClass *, TProcessMethod >::iterator itClassMap;
 
+  // read output tree settings
+
+  Bool_t columnar = GetBool("Columnar", false);
+  Int_t basketSize = GetInt("BasketSize", 0);
+  Int_t compressionSettings = GetInt("CompressionSettings", -1);
+  Long_t autoFlush = GetLong("AutoFlush", 0);
+  Long_t autoSave = GetLong("AutoSave", 10000000);
+  Int_t compressionThreads = GetInt("CompressionThreads", 0);
+  Bool_t indexProvenance = GetBool("IndexProvenance", false);
+
+  ExRootTreeWriter *treeWriter = GetTreeWriter();
+
+  if(basketSize > 0) treeWriter->SetBasketSize(basketSize);
+  if(compressionSettings >= 0) treeWriter->SetCompressionSettings(compressionSettings);
+  if(autoFlush != 0) treeWriter->SetAutoFlush(autoFlush);
+  treeWriter->SetAutoSave(autoSave);
+  treeWriter->SetCompressionThreads(compressionThreads);
+
   // read branch configuration and
   // import array with output from filter/classifier/jetfinder modules
 
@@ -94,6 +115,8 @@ void TreeWriter::Init()
   TClass *branchClass;
   TObjArray *array;
   ExRootTreeBranch *branch;
+  ExRootTreeLinkBranch *particleLinks, *constituentLinks;
+  map< TString, ExRootTreeBranch * > branchMap;
 
   size = param.GetSize();
   for(i = 0; i < size/3; ++i)
@@ -118,11 +141,75 @@ void TreeWriter::Init()
     }
 
     array = ImportArray(branchInputArray);
-    branch = NewBranch(branchName, branchClass);
+    branch = columnar ? treeWriter->NewFlatBranch(branchName, branchClass, !indexProvenance) : NewBranch(branchName, branchClass);
 
     fBranchMap.insert(make_pair(branch, make_pair(itClassMap->second, array)));
+    branchMap[branchName] = branch;
+
+    // links to generated particles and constituents written as entry indices
+    if(indexProvenance)
+    {
+      particleLinks = 0;
+      constituentLinks = 0;
+
+      if(branchClass == Track::Class() || branchClass == Electron::Class() ||
+        branchClass == Muon::Class() || branchClass == HectorHit::Class())
+      {
+        particleLinks = treeWriter->NewLinkBranch(branchName, "Particle", kTRUE);
+      }
+      else if(branchClass == Tower::Class() || branchClass == Photon::Class() || branchClass == Jet::Class())
+      {
+        particleLinks = treeWriter->NewLinkBranch(branchName, "Particles", kFALSE);
+      }
+
+      if(branchClass == Jet::Class() || branchClass == Vertex::Class())
+      {
+        constituentLinks = treeWriter->NewLinkBranch(branchName, "Constituents", kFALSE);
+      }
+
+      fLinkMap[branch] = make_pair(particleLinks, constituentLinks);
+    }
   }
 
+  // read object selections applied before filling the branches
+
+  TSelection selection;
+  map< TString, ExRootTreeBranch * >::iterator itNameMap;
+
+  param = GetParam("Selection");
+  size = param.GetSize();
+  for(i = 0; i < size/4; ++i)
+  {
+    branchName = param[i*4].GetString();
+
+    itNameMap = branchMap.find(branchName);
+    if(itNameMap == branchMap.end())
+    {
+      cout << "** ERROR: cannot find branch '" << branchName << "' for selection" << endl;
+      continue;
+    }
+
+    selection.array = GetFactory()->NewPermanentArray();
+    selection.minPT = param[i*4 + 1].GetDouble();
+    selection.maxAbsEta = param[i*4 + 2].GetDouble();
+    selection.size = param[i*4 + 3].GetInt();
+
+    fSelectionMap[itNameMap->second] = selection;
+  }
+
+  // read event filters, events failing any of them are not written
+
+  param = GetParam("EventFilter");
+  size = param.GetSize();
+  for(i = 0; i < size/4; ++i)
+  {
+    selection.array = ImportArray(param[i*4].GetString());
+    selection.minPT = param[i*4 + 1].GetDouble();
+    selection.maxAbsEta = param[i*4 + 2].GetDouble();
+    selection.size = param[i*4 + 3].GetInt();
+
+    fEventFilters.push_back(selection);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -133,36 +220,79 @@ void TreeWriter::Finish()
 
 //------------------------------------------------------------------------------
 
-void TreeWriter::FillParticles(Candidate *candidate, TRefArray *array)
+Bool_t TreeWriter::IsSelected(Candidate *candidate, const TSelection &selection)
 {
-  TIter it1(candidate->GetCandidates());
-  it1.Reset();
-  array->Clear();
-  while((candidate = static_cast<Candidate*>(it1.Next())))
+  const TLorentzVector &momentum = candidate->Momentum;
+
+  if(momentum.Pt() < selection.minPT) return kFALSE;
+
+  // MaxAbsEta <= 0 disables the eta cut
+  if(selection.maxAbsEta <= 0.0) return kTRUE;
+
+  // objects along the beam axis have an infinite |eta|
+  if(TMath::Abs(momentum.CosTheta()) == 1.0) return kFALSE;
+
+  return TMath::Abs(momentum.Eta()) <= selection.maxAbsEta;
+}
+
+//------------------------------------------------------------------------------
+
+TObjArray *TreeWriter::Select(TObjArray *array, TSelection &selection)
+{
+  TIter iterator(array);
+  Candidate *candidate = 0;
+  Int_t i;
+
+  selection.array->Clear();
+
+  while((candidate = static_cast<Candidate*>(iterator.Next())))
   {
-    TIter it2(candidate->GetCandidates());
+    if(IsSelected(candidate, selection)) selection.array->Add(candidate);
+  }
 
-    // particle
-    if(candidate->GetCandidates()->GetEntriesFast() == 0)
+  // keep the highest pT objects if the multiplicity is limited, the imported
+  // array is shared with other modules and is never reordered
+  if(selection.size > 0 && selection.array->GetEntriesFast() > selection.size)
+  {
+    selection.array->Sort();
+    for(i = selection.array->GetEntriesFast() - 1; i >= selection.size; --i)
     {
-      array->Add(candidate);
-      continue;
+      selection.array->RemoveAt(i);
     }
+  }
 
-    // track
-    candidate = static_cast<Candidate*>(candidate->GetCandidates()->At(0));
-    if(candidate->GetCandidates()->GetEntriesFast() == 0)
-    {
-      array->Add(candidate);
-      continue;
-    }
+  return selection.array;
+}
 
-    // tower
-    it2.Reset();
-    while((candidate = static_cast<Candidate*>(it2.Next())))
-    {
-      array->Add(candidate->GetCandidates()->At(0));
-    }
+//------------------------------------------------------------------------------
+
+void TreeWriter::AddLink(TObject *object, TRefArray *array, ExRootTreeLinkBranch *links)
+{
+  if(links)
+  {
+    links->Add(object->GetUniqueID());
+  }
+  else
+  {
+    array->Add(object);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+void TreeWriter::FillParticles(Candidate *candidate, TRefArray *array, ExRootTreeLinkBranch *links)
+{
+  Int_t i, size;
+
+  array->Clear();
+  if(links) links->NewEntry();
+  if(!candidate->HasCandidates()) return;
+
+  // generated particles at the leaves of the particles, tracks and towers
+  size = candidate->GetNLeaves();
+  for(i = 0; i < size; ++i)
+  {
+    AddLink(candidate->GetLeaf(i), array, links);
   }
 }
 
@@ -241,6 +371,7 @@ void TreeWriter::ProcessVertices(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0, *constituent = 0;
   Vertex *entry = 0;
+  ExRootTreeLinkBranch *constituentLinks = fLinkMap[branch].second;
 
   const Double_t c_light = 2.99792458E8;
 
@@ -299,9 +430,10 @@ void TreeWriter::ProcessVertices(ExRootTreeBranch *branch, TObjArray *array)
     TIter itConstituents(candidate->GetCandidates());
     itConstituents.Reset();
     entry->Constituents.Clear();
+    if(constituentLinks) constituentLinks->NewEntry();
     while((constituent = static_cast<Candidate*>(itConstituents.Next())))
     {
-      entry->Constituents.Add(constituent);
+      AddLink(constituent, &entry->Constituents, constituentLinks);
     }
 
   }
@@ -316,6 +448,7 @@ void TreeWriter::ProcessTracks(ExRootTreeBranch *branch, TObjArray *array)
   Candidate *candidate = 0;
   Candidate *particle = 0;
   Track *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
   Double_t pt, signz, cosTheta, eta, rapidity, p, ctgTheta, phi;
   const Double_t c_light = 2.99792458E8;
 
@@ -389,7 +522,15 @@ void TreeWriter::ProcessTracks(ExRootTreeBranch *branch, TObjArray *array)
     entry->Z = initialPosition.Z();
     entry->T = initialPosition.T()*1.0E-3/c_light;
 
-    entry->Particle = particle;
+    if(particleLinks)
+    {
+      particleLinks->NewEntry();
+      particleLinks->Add(particle->GetUniqueID());
+    }
+    else
+    {
+      entry->Particle = particle;
+    }
 
     entry->VertexIndex = candidate->ClusterIndex;
 
@@ -403,6 +544,7 @@ void TreeWriter::ProcessTowers(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Tower *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
   Double_t pt, signPz, cosTheta, eta, rapidity;
   const Double_t c_light = 2.99792458E8;
 
@@ -438,7 +580,7 @@ void TreeWriter::ProcessTowers(ExRootTreeBranch *branch, TObjArray *array)
     entry->T = position.T()*1.0E-3/c_light;
     entry->NTimeHits = candidate->NTimeHits;
 
-    FillParticles(candidate, &entry->Particles);
+    FillParticles(candidate, &entry->Particles, particleLinks);
   }
 }
 
@@ -449,6 +591,7 @@ void TreeWriter::ProcessPhotons(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Photon *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
   Double_t pt, signPz, cosTheta, eta, rapidity;
   const Double_t c_light = 2.99792458E8;
 
@@ -490,7 +633,7 @@ void TreeWriter::ProcessPhotons(ExRootTreeBranch *branch, TObjArray *array)
     // 1: prompt -- 2: non prompt -- 3: fake
     entry->Status = candidate->Status;
 
-    FillParticles(candidate, &entry->Particles);
+    FillParticles(candidate, &entry->Particles, particleLinks);
   }
 }
 
@@ -501,6 +644,7 @@ void TreeWriter::ProcessElectrons(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Electron *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
   Double_t pt, signPz, cosTheta, eta, rapidity;
   const Double_t c_light = 2.99792458E8;
 
@@ -541,7 +685,15 @@ void TreeWriter::ProcessElectrons(ExRootTreeBranch *branch, TObjArray *array)
 
     entry->EhadOverEem = 0.0;
 
-    entry->Particle = candidate->GetCandidates()->At(0);
+    if(particleLinks)
+    {
+      particleLinks->NewEntry();
+      particleLinks->Add(candidate->GetCandidates()->At(0)->GetUniqueID());
+    }
+    else
+    {
+      entry->Particle = candidate->GetCandidates()->At(0);
+    }
   }
 }
 
@@ -552,6 +704,7 @@ void TreeWriter::ProcessMuons(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   Muon *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
   Double_t pt, signPz, cosTheta, eta, rapidity;
 
   const Double_t c_light = 2.99792458E8;
@@ -593,7 +746,15 @@ void TreeWriter::ProcessMuons(ExRootTreeBranch *branch, TObjArray *array)
 
     entry->Charge = candidate->Charge;
 
-    entry->Particle = candidate->GetCandidates()->At(0);
+    if(particleLinks)
+    {
+      particleLinks->NewEntry();
+      particleLinks->Add(candidate->GetCandidates()->At(0)->GetUniqueID());
+    }
+    else
+    {
+      entry->Particle = candidate->GetCandidates()->At(0);
+    }
   }
 }
 
@@ -604,6 +765,8 @@ void TreeWriter::ProcessJets(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0, *constituent = 0;
   Jet *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
+  ExRootTreeLinkBranch *constituentLinks = fLinkMap[branch].second;
   Double_t pt, signPz, cosTheta, eta, rapidity;
   Double_t ecalEnergy, hcalEnergy;
   const Double_t c_light = 2.99792458E8;
@@ -657,11 +820,12 @@ void TreeWriter::ProcessJets(ExRootTreeBranch *branch, TObjArray *array)
 
     itConstituents.Reset();
     entry->Constituents.Clear();
+    if(constituentLinks) constituentLinks->NewEntry();
     ecalEnergy = 0.0;
     hcalEnergy = 0.0;
     while((constituent = static_cast<Candidate*>(itConstituents.Next())))
     {
-      entry->Constituents.Add(constituent);
+      AddLink(constituent, &entry->Constituents, constituentLinks);
       ecalEnergy += constituent->Eem;
       hcalEnergy += constituent->Ehad;
     }
@@ -704,7 +868,7 @@ void TreeWriter::ProcessJets(ExRootTreeBranch *branch, TObjArray *array)
     entry->ExclYmerge56 = candidate->ExclYmerge56;    
 
 
-    FillParticles(candidate, &entry->Particles);
+    FillParticles(candidate, &entry->Particles, particleLinks);
   }
 }
 
@@ -793,6 +957,7 @@ void TreeWriter::ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array)
   TIter iterator(array);
   Candidate *candidate = 0;
   HectorHit *entry = 0;
+  ExRootTreeLinkBranch *particleLinks = fLinkMap[branch].first;
 
   // loop over all roman pot hits
   iterator.Reset();
@@ -814,7 +979,15 @@ void TreeWriter::ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array)
     entry->Y = position.Y();
     entry->S = position.Z();
 
-    entry->Particle = candidate->GetCandidates()->At(0);
+    if(particleLinks)
+    {
+      particleLinks->NewEntry();
+      particleLinks->Add(candidate->GetCandidates()->At(0)->GetUniqueID());
+    }
+    else
+    {
+      entry->Particle = candidate->GetCandidates()->At(0);
+    }
   }
 }
 
@@ -823,9 +996,29 @@ void TreeWriter::ProcessHectorHit(ExRootTreeBranch *branch, TObjArray *array)
 void TreeWriter::Process()
 {
   TBranchMap::iterator itBranchMap;
+  map< ExRootTreeBranch *, TSelection >::iterator itSelectionMap;
+  vector< TSelection >::iterator itEventFilters;
   ExRootTreeBranch *branch;
   TProcessMethod method;
   TObjArray *array;
+  Candidate *candidate;
+  Int_t counter;
+
+  // check event filters before filling any branch
+  for(itEventFilters = fEventFilters.begin(); itEventFilters != fEventFilters.end(); ++itEventFilters)
+  {
+    TIter iterator(itEventFilters->array);
+    counter = 0;
+    while(counter < itEventFilters->size && (candidate = static_cast<Candidate*>(iterator.Next())))
+    {
+      if(IsSelected(candidate, *itEventFilters)) ++counter;
+    }
+    if(counter < itEventFilters->size)
+    {
+      GetTreeWriter()->SkipEvent();
+      return;
+    }
+  }
 
   for(itBranchMap = fBranchMap.begin(); itBranchMap != fBranchMap.end(); ++itBranchMap)
   {
@@ -833,6 +1026,9 @@ void TreeWriter::Process()
     method = itBranchMap->second.first;
     array = itBranchMap->second.second;
 
+    itSelectionMap = fSelectionMap.find(branch);
+    if(itSelectionMap != fSelectionMap.end()) array = Select(array, itSelectionMap->second);
+
     (this->*method)(branch, array);
   }
 }
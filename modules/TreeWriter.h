@@ -22,6 +22,7 @@
 /** \class TreeWriter
  *
  *  Fills ROOT tree branches.
+ *  With Columnar set, branches are written as flat per-member arrays.
  *
  *  \author P. Demin - UCL, Louvain-la-Neuve
  *
@@ -30,13 +31,16 @@
 #include "classes/DelphesModule.h"
 
 #include <map>
+#include <vector>
 
 class TClass;
+class TObject;
 class TObjArray;
 class TRefArray;
 
 class Candidate;
 class ExRootTreeBranch;
+class ExRootTreeLinkBranch;
 
 class TreeWriter: public DelphesModule
 {
@@ -51,7 +55,18 @@ public:
 
 private:
 
-  void FillParticles(Candidate *candidate, TRefArray *array);
+  struct TSelection
+  {
+    TObjArray *array;
+    Double_t minPT, maxAbsEta;
+    Int_t size;
+  };
+
+  Bool_t IsSelected(Candidate *candidate, const TSelection &selection);
+  TObjArray *Select(TObjArray *array, TSelection &selection);
+
+  void AddLink(TObject *object, TRefArray *array, ExRootTreeLinkBranch *links);
+  void FillParticles(Candidate *candidate, TRefArray *array, ExRootTreeLinkBranch *links);
 
   void ProcessParticles(ExRootTreeBranch *branch, TObjArray *array);
   void ProcessVertices(ExRootTreeBranch *branch, TObjArray *array);
@@ -76,6 +91,15 @@ private:
   TBranchMap fBranchMap; //!
 
   std::map< TClass *, TProcessMethod > fClassMap; //!
+
+  std::map< ExRootTreeBranch *, TSelection > fSelectionMap; //!
+
+  typedef std::pair< ExRootTreeLinkBranch *, ExRootTreeLinkBranch * > TLinkPair; //!
+
+  // particle and constituent links of each branch, written instead of TRef/TRefArray
+  std::map< ExRootTreeBranch *, TLinkPair > fLinkMap; //!
+
+  std::vector< TSelection > fEventFilters; //!
 #endif
 
   ClassDef(TreeWriter, 1)
@@ -108,6 +108,9 @@ void UniqueObjectFinder::Process()
   vector< pair< TIterator *, TObjArray * > >::iterator itInputMap;
   TIterator *iterator;
   TObjArray *array;
+  Int_t i;
+
+  fLeaves.clear();
 
   // loop over all input arrays
   for(itInputMap = fInputMap.begin(); itInputMap != fInputMap.end(); ++itInputMap)
@@ -119,40 +122,53 @@ void UniqueObjectFinder::Process()
     iterator->Reset();
     while((candidate = static_cast<Candidate*>(iterator->Next())))
     {
-      if(Unique(candidate, itInputMap))
+      if(Unique(candidate))
       {
         array->Add(candidate);
       }
     }
+
+    // candidates are only compared with the objects of the previous arrays
+    if(itInputMap + 1 == fInputMap.end()) break;
+
+    for(i = 0; i < array->GetEntriesFast(); ++i)
+    {
+      AddLeaves(static_cast<Candidate*>(array->At(i)));
+    }
   }
 }
 
 //------------------------------------------------------------------------------
 
-Bool_t UniqueObjectFinder::Unique(Candidate *candidate, vector< pair< TIterator *, TObjArray * > >::iterator itInputMap)
+// Two candidates overlap when their trees share a candidate,
+// and then they share all the leaves below it
+
+Bool_t UniqueObjectFinder::Unique(Candidate *candidate)
 {
-  Candidate *previousCandidate;
-  vector< pair< TIterator *, TObjArray * > >::iterator previousItInputMap;
-  TObjArray *array;
+  Int_t i, size;
 
-  // loop over previous arrays
-  for(previousItInputMap = fInputMap.begin(); previousItInputMap != itInputMap; ++previousItInputMap)
-  {
-    array = previousItInputMap->second;
-    TIter iterator(array);
+  if(fLeaves.empty()) return kTRUE;
 
-    // loop over all candidates
-    iterator.Reset();
-    while((previousCandidate = static_cast<Candidate*>(iterator.Next())))
-    {
-      if(candidate->Overlaps(previousCandidate))
-      {
-        return kFALSE;
-      }
-    }
+  size = candidate->GetNLeaves();
+  for(i = 0; i < size; ++i)
+  {
+    if(fLeaves.count(candidate->GetLeaf(i)->GetUniqueID())) return kFALSE;
   }
 
   return kTRUE;
 }
 
 //------------------------------------------------------------------------------
+
+void UniqueObjectFinder::AddLeaves(Candidate *candidate)
+{
+  Int_t i, size;
+
+  size = candidate->GetNLeaves();
+  for(i = 0; i < size; ++i)
+  {
+    fLeaves.insert(candidate->GetLeaf(i)->GetUniqueID());
+  }
+}
+
+//------------------------------------------------------------------------------
@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <utility>
+#include <unordered_set>
 
 class TIterator;
 class TObjArray;
@@ -49,10 +50,14 @@ public:
 
 private:
 
-  Bool_t Unique(Candidate *candidate, std::vector< std::pair< TIterator *, TObjArray * > >::iterator itInputMap);
+  Bool_t Unique(Candidate *candidate);
+  void AddLeaves(Candidate *candidate);
 
   std::vector< std::pair< TIterator *, TObjArray * > > fInputMap; //!
 
+  // unique IDs of the leaf constituents of the objects accepted from the previous arrays
+  std::unordered_set< UInt_t > fLeaves; //!
+
   ClassDef(UniqueObjectFinder, 1)
 };
 
@@ -56,38 +56,195 @@ struct track_t
   double phi;
 };
 
-struct vertex_t
+// structure of arrays used by the annealing kernels, tracks are sorted in z
+
+struct tracks_t
 {
-  double z;
-  double t;
-  double pk;     // vertex weight for "constrained" clustering
+  vector<double> z;        // z-coordinate at point of closest approach to the beamline
+  vector<double> t;        // t-coordinate at point of closest approach to the beamline
+  vector<double> dz2;      // square of the error of z(pca)
+  vector<double> dt2;      // square of the error of t(pca)
+  vector<double> dz2inv;   // 1/dz2
+  vector<double> dt2inv;   // 1/dt2
+  vector<double> Z;        // Z[i]   for DA clustering
+  vector<double> pi;       // track weight
+  vector<Candidate *> tt;  // a pointer to the Candidate Track
+
+  // range [kmin, kmax) of vertex prototypes within the z window of each track
+  vector<unsigned int> kmin;
+  vector<unsigned int> kmax;
+
+  unsigned int size() const { return z.size(); }
+
+  void add(const track_t &tr)
+  {
+    z.push_back(tr.z);
+    t.push_back(tr.t);
+    dz2.push_back(tr.dz2);
+    dt2.push_back(tr.dt2);
+    dz2inv.push_back(1.0/tr.dz2);
+    dt2inv.push_back(1.0/tr.dt2);
+    Z.push_back(tr.Z);
+    pi.push_back(tr.pi);
+    tt.push_back(tr.tt);
+    kmin.push_back(0);
+    kmax.push_back(0);
+  }
+};
+
+struct vertices_t
+{
+  vector<double> z;
+  vector<double> t;
+  vector<double> pk;     // vertex weight for "constrained" clustering
   // --- temporary numbers, used during update
-  double ei;
-  double sw;
-  double swz;
-  double swt;
-  double se;
+  vector<double> ei;
+  vector<double> sw;
+  vector<double> swz;
+  vector<double> swt;
+  vector<double> se;
   // ---for Tc
-  double swE;
-  double Tc;
+  vector<double> swE;
+  vector<double> Tc;
+
+  unsigned int size() const { return z.size(); }
+
+  void insert(unsigned int k, double zk, double tk, double pkk)
+  {
+    z.insert(z.begin() + k, zk);
+    t.insert(t.begin() + k, tk);
+    pk.insert(pk.begin() + k, pkk);
+    ei.insert(ei.begin() + k, 0.0);
+    sw.insert(sw.begin() + k, 0.0);
+    swz.insert(swz.begin() + k, 0.0);
+    swt.insert(swt.begin() + k, 0.0);
+    se.insert(se.begin() + k, 0.0);
+    swE.insert(swE.begin() + k, 0.0);
+    Tc.insert(Tc.begin() + k, 0.0);
+  }
+
+  void add(double zk, double tk, double pkk) { insert(size(), zk, tk, pkk); }
+
+  void erase(unsigned int k)
+  {
+    z.erase(z.begin() + k);
+    t.erase(t.begin() + k);
+    pk.erase(pk.begin() + k);
+    ei.erase(ei.begin() + k);
+    sw.erase(sw.begin() + k);
+    swz.erase(swz.begin() + k);
+    swt.erase(swt.begin() + k);
+    se.erase(se.begin() + k);
+    swE.erase(swE.begin() + k);
+    Tc.erase(Tc.begin() + k);
+  }
+};
+
+// annealing parameters shared by all z regions
+
+struct annealing_t
+{
+  bool verbose;
+  bool useTc;
+  bool useZWindow;
+  double betaMax;
+  double betaStop;
+  double coolingFactor;
+  int maxIterations;
+  double dzCutOff;
+};
+
+// vertex found in one z region, together with its assigned tracks
+
+struct cluster_t
+{
+  double z;
+  double t;
+  double errorT;
+  vector<Candidate *> tracks;
 };
 
-static bool split(double beta, std::vector<track_t> &tks, std::vector<vertex_t> &y);
-static double update1(double beta, std::vector<track_t> &tks, std::vector<vertex_t> &y);
-static double update2(double beta, std::vector<track_t> &tks, std::vector<vertex_t> &y, double &rho0, const double dzCutOff);
-static void dump(const double beta, const std::vector<vertex_t> & y, const std::vector<track_t> & tks);
-static bool merge(std::vector<vertex_t> &);
-static bool merge(std::vector<vertex_t> &, double &);
-static bool purge(std::vector<vertex_t> &, std::vector<track_t> & , double &, const double, const double);
-static void splitAll(std::vector<vertex_t> &y);
-static double beta0(const double betamax, std::vector<track_t> &tks, std::vector<vertex_t> &y, const double coolingFactor);
-static double Eik(const track_t &t, const vertex_t &k);
+static void anneal(const annealing_t &config, const vector<track_t> &input, unsigned int first, unsigned int last, unsigned int ntotal, vector<cluster_t> &clusters);
+static void setVertexRange(double beta, tracks_t &tks, const vertices_t &y, const annealing_t &config);
+static bool split(double beta, tracks_t &tks, vertices_t &y, const annealing_t &config);
+static double update1(double beta, tracks_t &tks, vertices_t &y, const annealing_t &config);
+static double update2(double beta, tracks_t &tks, vertices_t &y, double &rho0, const annealing_t &config);
+static void dump(const double beta, const vertices_t &y, const tracks_t &tks);
+static bool merge(vertices_t &);
+static bool merge(vertices_t &, double &);
+static bool purge(vertices_t &, tracks_t &, double &, const double, const annealing_t &);
+static void splitAll(vertices_t &y);
+static double beta0(const double betamax, tracks_t &tks, vertices_t &y, const double coolingFactor);
+static double Eik(const tracks_t &tks, unsigned int i, const vertices_t &y, unsigned int k);
 
 static bool recTrackLessZ1(const track_t & tk1, const track_t & tk2)
 {
   return tk1.z < tk2.z;
 }
 
+//------------------------------------------------------------------------------
+
+// exp(x) for x <= 0 following the Cephes/VDT approach: a Pade approximant
+// on the reduced argument and an exponent built with integer arithmetic,
+// branch-free so that the loops in expList can be vectorised
+
+static inline double fastExp(double x)
+{
+  const double log2e = 1.4426950408889634073599;
+  const double c1 = 6.93145751953125e-1;
+  const double c2 = 1.42860682030941723212e-6;
+
+  const double p0 = 1.26177193074810590878e-4;
+  const double p1 = 3.02994407707441961300e-2;
+  const double p2 = 9.99999999999999999910e-1;
+
+  const double q0 = 3.00198505138664455042e-6;
+  const double q1 = 2.52448340349684104192e-3;
+  const double q2 = 2.27265548208155028766e-1;
+  const double q3 = 2.00000000000000000009e0;
+
+  const double xmin = -708.39641853226408;
+
+  const double xc = (x < xmin) ? xmin : x;
+  const double n = std::floor(log2e * xc + 0.5);
+  double r = xc - n * c1;
+  r -= n * c2;
+
+  const double r2 = r * r;
+  const double px = r * ((p0 * r2 + p1) * r2 + p2);
+  const double qx = ((q0 * r2 + q1) * r2 + q2) * r2 + q3;
+  double result = 1.0 + 2.0 * px / (qx - px);
+
+  // multiply by 2^n
+  union { double d; Long64_t i; } scale;
+  scale.i = (Long64_t(n) + 1023) << 52;
+  result *= scale.d;
+
+  return (x < xmin) ? 0.0 : result;
+}
+
+//------------------------------------------------------------------------------
+
+static inline void expList(double *values, unsigned int n)
+{
+  for(unsigned int i = 0; i < n; ++i)
+  {
+    values[i] = fastExp(values[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+// track i and a prototype at zk are evaluated together only when
+// beta*(zi - zk)^2/dz2 < DzCutOff^2, the neglected terms are below exp(-DzCutOff^2)
+
+static inline bool inWindow(double beta, const tracks_t &tks, unsigned int i, double zk, const annealing_t &config)
+{
+  if(!config.useZWindow) return true;
+  const double dz = tks.z[i] - zk;
+  return beta * dz * dz * tks.dz2inv[i] < config.dzCutOff * config.dzCutOff;
+}
+
 using namespace std;
 
 //------------------------------------------------------------------------------
@@ -95,7 +252,8 @@ using namespace std;
 VertexFinderDA4D::VertexFinderDA4D() :
   fVerbose(0), fMinPT(0), fVertexSpaceSize(0), fVertexTimeSize(0),
   fUseTc(0), fBetaMax(0), fBetaStop(0), fCoolingFactor(0),
-  fMaxIterations(0), fDzCutOff(0), fD0CutOff(0), fDtCutOff(0)
+  fMaxIterations(0), fDzCutOff(0), fD0CutOff(0), fDtCutOff(0),
+  fUseZWindow(0), fZRegionGap(0)
 {
 }
 
@@ -123,11 +281,17 @@ void VertexFinderDA4D::Init()
   fD0CutOff      = GetDouble("D0CutOff", 30);
   fDtCutOff      = GetDouble("DtCutOff", 100E-12);  // dummy
 
+  // only evaluate track-vertex pairs within DzCutOff (in units of the track z error)
+  fUseZWindow    = GetBool("UseZWindow", 1);
+  // tracks separated by more than ZRegionGap in z are annealed independently (0 = single region)
+  fZRegionGap    = GetDouble("ZRegionGap", 0.0); // in mm
+
   // convert stuff in cm, ns
   fVertexSpaceSize /= 10.0;
   fVertexTimeSize *= 1E9;
   fDzCutOff       /= 10.0;   // Adaptive Fitter uses 3.0 but that appears to be a bit tight here sometimes
   fD0CutOff       /= 10.0;
+  fZRegionGap     /= 10.0;
 
   fInputArray = ImportArray(GetString("InputArray", "TrackSmearing/tracks"));
   fItInputArray = fInputArray->MakeIterator();
@@ -420,87 +584,157 @@ vector< Candidate* > VertexFinderDA4D::vertices()
   }
 
   unsigned int nt=tks.size();
-  double rho0=0.0;  // start with no outlier rejection
 
   if (tks.empty()) return clusters;
 
-  vector<vertex_t> y; // the vertex prototypes
+  // sort tracks in z and split them into z regions that can be annealed independently
+  std::stable_sort(tks.begin(), tks.end(), recTrackLessZ1);
+
+  vector< pair<unsigned int, unsigned int> > regions;
+  unsigned int first = 0;
+  for(unsigned int i=1; i<nt; i++){
+    if(fZRegionGap > 0 && tks[i].z - tks[i-1].z > fZRegionGap){
+      regions.push_back(make_pair(first, i));
+      first = i;
+    }
+  }
+  regions.push_back(make_pair(first, nt));
+
+  if(fVerbose){ cout << "# VertexFinderDA4D::vertices   regions=" << regions.size() << endl; }
+
+  annealing_t config;
+  config.verbose       = fVerbose;
+  config.useTc         = fUseTc;
+  config.useZWindow    = fUseZWindow;
+  config.betaMax       = fBetaMax;
+  config.betaStop      = fBetaStop;
+  config.coolingFactor = fCoolingFactor;
+  config.maxIterations = fMaxIterations;
+  config.dzCutOff      = fDzCutOff;
+
+  vector< vector<cluster_t> > regionClusters(regions.size());
+
+  // the regions share no state, so they can run on separate threads
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int ir=0; ir<int(regions.size()); ir++){
+    anneal(config, tks, regions[ir].first, regions[ir].second, nt, regionClusters[ir]);
+  }
+
+  // candidates are created sequentially, DelphesFactory is not thread-safe
+  DelphesFactory *factory = GetFactory();
+  for(unsigned int ir=0; ir<regionClusters.size(); ir++){
+    for(vector<cluster_t>::const_iterator k=regionClusters[ir].begin(); k!=regionClusters[ir].end(); k++){
+
+      candidate = factory->NewCandidate();
+
+      for(vector<Candidate *>::const_iterator it=k->tracks.begin(); it!=k->tracks.end(); it++){
+        candidate->AddCandidate(*it);
+      }
+
+      candidate->ClusterIndex = clusterIndex++;;
+      candidate->Position.SetXYZT(0.0, 0.0, k->z*10.0 , k->t*c_light);
+
+      // TBC - fill error later ...
+      candidate->PositionError.SetXYZT(0.0, 0.0, 0.0 , k->errorT*c_light);
+
+      clusterIndex++;
+      clusters.push_back(candidate);
+    }
+  }
+
+  return clusters;
+
+}
+
+//------------------------------------------------------------------------------
+
+static void anneal(const annealing_t &config, const vector<track_t> &input, unsigned int first, unsigned int last, unsigned int ntotal, vector<cluster_t> &clusters)
+{
+  // deterministic annealing of the tracks [first, last) of the z-sorted input
+
+  tracks_t tks;
+  for(unsigned int i=first; i<last; i++){
+    tks.add(input[i]);
+  }
+
+  unsigned int nt=tks.size();
+  double rho0=0.0;  // start with no outlier rejection
+
+  vertices_t y; // the vertex prototypes
 
   // initialize:single vertex at infinite temperature
-  vertex_t vstart;
-  vstart.z=0.;
-  vstart.t=0.;
-  vstart.pk=1.;
-  y.push_back(vstart);
+  y.add(0., 0., 1.);
   int niter=0;      // number of iterations
 
   // estimate first critical temperature
-  double beta=beta0(fBetaMax, tks, y, fCoolingFactor);
-  niter=0; while((update1(beta, tks,y)>1.e-6)  && (niter++ < fMaxIterations)){ }
+  double beta=beta0(config.betaMax, tks, y, config.coolingFactor);
+  niter=0; while((update1(beta, tks,y, config)>1.e-6)  && (niter++ < config.maxIterations)){ }
 
   // annealing loop, stop when T<Tmin  (i.e. beta>1/Tmin)
-  while(beta<fBetaMax){
+  while(beta<config.betaMax){
 
-    if(fUseTc){
-      update1(beta, tks,y);
-      while(merge(y,beta)){update1(beta, tks,y);}
-      split(beta, tks,y);
-      beta=beta/fCoolingFactor;
+    if(config.useTc){
+      update1(beta, tks,y, config);
+      while(merge(y,beta)){update1(beta, tks,y, config);}
+      split(beta, tks,y, config);
+      beta=beta/config.coolingFactor;
     }else{
-      beta=beta/fCoolingFactor;
+      beta=beta/config.coolingFactor;
       splitAll(y);
     }
 
    // make sure we are not too far from equilibrium before cooling further
-   niter=0; while((update1(beta, tks,y)>1.e-6)  && (niter++ < fMaxIterations)){ }
+   niter=0; while((update1(beta, tks,y, config)>1.e-6)  && (niter++ < config.maxIterations)){ }
 
   }
 
-  if(fUseTc){
+  if(config.useTc){
     // last round of splitting, make sure no critical clusters are left
-    update1(beta, tks,y);
-    while(merge(y,beta)){update1(beta, tks,y);}
+    update1(beta, tks,y, config);
+    while(merge(y,beta)){update1(beta, tks,y, config);}
     unsigned int ntry=0;
-    while( split(beta, tks,y) && (ntry++<10) ){
+    while( split(beta, tks,y, config) && (ntry++<10) ){
       niter=0;
-      while((update1(beta, tks,y)>1.e-6)  && (niter++ < fMaxIterations)){}
+      while((update1(beta, tks,y, config)>1.e-6)  && (niter++ < config.maxIterations)){}
       merge(y,beta);
-      update1(beta, tks,y);
+      update1(beta, tks,y, config);
     }
   }else{
     // merge collapsed clusters
-    while(merge(y,beta)){update1(beta, tks,y);}
-    if(fVerbose ){ cout << "dump after 1st merging " << endl;  dump(beta,y,tks);}
+    while(merge(y,beta)){update1(beta, tks,y, config);}
+    if(config.verbose ){ cout << "dump after 1st merging " << endl;  dump(beta,y,tks);}
   }
 
-  // switch on outlier rejection
-  rho0=1./nt; for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){ k->pk =1.; }  // democratic
-  niter=0; while((update2(beta, tks,y,rho0, fDzCutOff) > 1.e-8)  && (niter++ < fMaxIterations)){  }
-  if(fVerbose  ){ cout << "rho0=" << rho0 <<   " niter=" << niter <<  endl; dump(beta,y,tks);}
+  // switch on outlier rejection, normalised to the total number of tracks of the event
+  rho0=1./ntotal; for(unsigned int k=0; k<y.size(); k++){ y.pk[k] =1.; }  // democratic
+  niter=0; while((update2(beta, tks,y,rho0, config) > 1.e-8)  && (niter++ < config.maxIterations)){  }
+  if(config.verbose  ){ cout << "rho0=" << rho0 <<   " niter=" << niter <<  endl; dump(beta,y,tks);}
 
 
   // merge again  (some cluster split by outliers collapse here)
   while(merge(y)){}
-  if(fVerbose  ){ cout << "dump after 2nd merging " << endl;  dump(beta,y,tks);}
+  if(config.verbose  ){ cout << "dump after 2nd merging " << endl;  dump(beta,y,tks);}
 
 
   // continue from freeze-out to Tstop (=1) without splitting, eliminate insignificant vertices
-  while(beta<=fBetaStop){
-    while(purge(y,tks,rho0, beta, fDzCutOff)){
-      niter=0; while((update2(beta, tks, y, rho0, fDzCutOff) > 1.e-6)  && (niter++ < fMaxIterations)){  }
+  while(beta<=config.betaStop){
+    while(purge(y,tks,rho0, beta, config)){
+      niter=0; while((update2(beta, tks, y, rho0, config) > 1.e-6)  && (niter++ < config.maxIterations)){  }
     }
-    beta/=fCoolingFactor;
-    niter=0; while((update2(beta, tks, y, rho0, fDzCutOff) > 1.e-6)  && (niter++ < fMaxIterations)){  }
+    beta/=config.coolingFactor;
+    niter=0; while((update2(beta, tks, y, rho0, config) > 1.e-6)  && (niter++ < config.maxIterations)){  }
   }
 
 
 //   // new, one last round of cleaning at T=Tstop
 //   while(purge(y,tks,rho0, beta)){
-//     niter=0; while((update2(beta, tks,y,rho0, fDzCutOff) > 1.e-6)  && (niter++ < fMaxIterations)){  }
+//     niter=0; while((update2(beta, tks,y,rho0, config) > 1.e-6)  && (niter++ < config.maxIterations)){  }
 //   }
 
 
-  if(fVerbose){
+  if(config.verbose){
    cout << "Final result, rho0=" << rho0 << endl;
    dump(beta,y,tks);
   }
@@ -510,39 +744,46 @@ vector< Candidate* > VertexFinderDA4D::vertices()
   //GlobalError dummyError;
 
   // ensure correct normalization of probabilities, should make double assginment reasonably impossible
+  setVertexRange(beta, tks, y, config);
   for(unsigned int i=0; i<nt; i++){
-    tks[i].Z=rho0*exp(-beta*( fDzCutOff*fDzCutOff));
-    for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-      tks[i].Z += k->pk * exp(-beta*Eik(tks[i],*k));
+    const unsigned int kmin = tks.kmin[i], kmax = tks.kmax[i];
+    for(unsigned int k=kmin; k<kmax; k++){
+      y.ei[k] = -beta*Eik(tks, i, y, k);
     }
+    expList(&y.ei[0] + kmin, kmax - kmin);
+
+    double Zi = rho0*fastExp(-beta*(config.dzCutOff*config.dzCutOff));
+    for(unsigned int k=kmin; k<kmax; k++){
+      Zi += y.pk[k] * y.ei[k];
+    }
+    tks.Z[i] = Zi;
   }
 
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
+  for(unsigned int k=0; k<y.size(); k++){
 
-    DelphesFactory *factory = GetFactory();
-    candidate = factory->NewCandidate();
+    cluster_t cluster;
 
     //cout<<"new vertex"<<endl;
     //GlobalPoint pos(0, 0, k->z);
-    double time = k->t;
-    double z = k->z;
+    double time = y.t[k];
+    double z = y.z[k];
     //vector< reco::TransientTrack > vertexTracks;
     //double max_track_time_err2 = 0;
     double mean = 0.;
     double expv_x2 = 0.;
     double normw = 0.;
     for(unsigned int i=0; i<nt; i++){
-      const double invdt = 1.0/std::sqrt(tks[i].dt2);
-      if(tks[i].Z>0){
-  double p = k->pk * exp(-beta*Eik(tks[i],*k)) / tks[i].Z;
-  if( (tks[i].pi>0) && ( p > 0.5 ) ){
-          //std::cout << "pushing back " << i << ' ' << tks[i].tt << std::endl;
-          //vertexTracks.push_back(*(tks[i].tt)); tks[i].Z=0;
+      const double invdt = 1.0/std::sqrt(tks.dt2[i]);
+      if(tks.Z[i]>0 && inWindow(beta, tks, i, z, config)){
+        double p = y.pk[k] * fastExp(-beta*Eik(tks, i, y, k)) / tks.Z[i];
+        if( (tks.pi[i]>0) && ( p > 0.5 ) ){
+          //std::cout << "pushing back " << i << ' ' << tks.tt[i] << std::endl;
+          //vertexTracks.push_back(*(tks.tt[i])); tks.Z[i]=0;
 
-          candidate->AddCandidate(tks[i].tt); tks[i].Z=0;
+          cluster.tracks.push_back(tks.tt[i]); tks.Z[i]=0;
 
-          mean     += tks[i].t*invdt*p;
-          expv_x2  += tks[i].t*tks[i].t*invdt*p;
+          mean     += tks.t[i]*invdt*p;
+          expv_x2  += tks.t[i]*tks.t[i]*invdt*p;
           normw    += invdt*p;
         } // setting Z=0 excludes double assignment
       }
@@ -558,59 +799,75 @@ vector< Candidate* > VertexFinderDA4D::vertices()
                                    0,0,0,crappy_error_guess);*/
     //TransientVertex v(pos, time, dummyErrorWithTime, vertexTracks, 5);
 
+    cluster.z = z;
+    cluster.t = time;
+    cluster.errorT = crappy_error_guess;
 
-    candidate->ClusterIndex = clusterIndex++;;
-    candidate->Position.SetXYZT(0.0, 0.0, z*10.0 , time*c_light);
-
-    // TBC - fill error later ...
-    candidate->PositionError.SetXYZT(0.0, 0.0, 0.0 , crappy_error_guess*c_light);
-
-    clusterIndex++;
-    clusters.push_back(candidate);
+    clusters.push_back(cluster);
   }
+}
 
+//------------------------------------------------------------------------------
 
-  return clusters;
-
+static double Eik(const tracks_t &tks, unsigned int i, const vertices_t &y, unsigned int k)
+{
+  const double dz = tks.z[i] - y.z[k];
+  const double dt = tks.t[i] - y.t[k];
+  return dz*dz*tks.dz2inv[i] + dt*dt*tks.dt2inv[i];
 }
 
 //------------------------------------------------------------------------------
 
-static double Eik(const track_t & t, const vertex_t &k)
+static void setVertexRange(double beta, tracks_t &tks, const vertices_t &y, const annealing_t &config)
 {
-  return std::pow(t.z-k.z,2.)/t.dz2 + std::pow(t.t - k.t,2.)/t.dt2;
+  // find for every track the range of prototypes inside its z window,
+  // the prototypes are kept ordered in z by split and merge
+
+  const unsigned int nt = tks.size();
+  const unsigned int nv = y.size();
+
+  if(!config.useZWindow || beta <= 0 || !std::is_sorted(y.z.begin(), y.z.end())){
+    for(unsigned int i=0; i<nt; i++){
+      tks.kmin[i] = 0;
+      tks.kmax[i] = nv;
+    }
+    return;
+  }
+
+  for(unsigned int i=0; i<nt; i++){
+    const double zrange = config.dzCutOff*std::sqrt(tks.dz2[i]/beta);
+    tks.kmin[i] = std::lower_bound(y.z.begin(), y.z.end(), tks.z[i] - zrange) - y.z.begin();
+    tks.kmax[i] = std::upper_bound(y.z.begin(), y.z.end(), tks.z[i] + zrange) - y.z.begin();
+  }
 }
 
 //------------------------------------------------------------------------------
 
-static void dump(const double beta, const vector<vertex_t> &y, const vector<track_t> &tks0)
+static void dump(const double beta, const vertices_t &y, const tracks_t &tks)
 {
-  // copy and sort for nicer printout
-  vector<track_t> tks;
-  for(vector<track_t>::const_iterator t=tks0.begin(); t!=tks0.end(); t++){tks.push_back(*t); }
-  std::stable_sort(tks.begin(), tks.end(), recTrackLessZ1);
+  // tracks are already sorted in z for a nicer printout
 
   cout << "-----DAClusterizerInZT::dump ----" << endl;
   cout << " beta=" << beta << endl;
   cout << "                                                               z= ";
   cout.precision(4);
-  for(vector<vertex_t>::const_iterator k=y.begin(); k!=y.end(); k++){
-    //cout  <<  setw(8) << fixed << k->z;
+  for(unsigned int k=0; k<y.size(); k++){
+    //cout  <<  setw(8) << fixed << y.z[k];
   }
   cout << endl << "                                                               t= ";
-  for(vector<vertex_t>::const_iterator k=y.begin(); k!=y.end(); k++){
-    //cout  <<  setw(8) << fixed << k->t;
+  for(unsigned int k=0; k<y.size(); k++){
+    //cout  <<  setw(8) << fixed << y.t[k];
   }
   //cout << endl << "T=" << setw(15) << 1./beta <<"                                             Tc= ";
-  for(vector<vertex_t>::const_iterator k=y.begin(); k!=y.end(); k++){
-    //cout  <<  setw(8) << fixed << k->Tc ;
+  for(unsigned int k=0; k<y.size(); k++){
+    //cout  <<  setw(8) << fixed << y.Tc[k] ;
   }
 
   cout << endl << "                                                              pk=";
   double sumpk=0;
-  for(vector<vertex_t>::const_iterator k=y.begin(); k!=y.end(); k++){
-    //cout <<  setw(8) <<  setprecision(3) <<  fixed << k->pk;
-    sumpk+=k->pk;
+  for(unsigned int k=0; k<y.size(); k++){
+    //cout <<  setw(8) <<  setprecision(3) <<  fixed << y.pk[k];
+    sumpk+=y.pk[k];
   }
   cout  << endl;
 
@@ -619,23 +876,23 @@ static void dump(const double beta, const vector<vertex_t> &y, const vector<trac
   cout << "----       z +/- dz        t +/- dt        ip +/-dip       pt    phi  eta    weights  ----" << endl;
   cout.precision(4);
   for(unsigned int i=0; i<tks.size(); i++){
-    if (tks[i].Z>0){  F-=log(tks[i].Z)/beta;}
-    double tz= tks[i].z;
-    double tt= tks[i].t;
-    //cout <<  setw (3)<< i << ")" <<  setw (8) << fixed << setprecision(4)<<  tz << " +/-" <<  setw (6)<< sqrt(tks[i].dz2)
-    //     << setw(8) << fixed << setprecision(4) << tt << " +/-" << setw(6) << std::sqrt(tks[i].dt2)  ;
+    if (tks.Z[i]>0){  F-=log(tks.Z[i])/beta;}
+    double tz= tks.z[i];
+    double tt= tks.t[i];
+    //cout <<  setw (3)<< i << ")" <<  setw (8) << fixed << setprecision(4)<<  tz << " +/-" <<  setw (6)<< sqrt(tks.dz2[i])
+    //     << setw(8) << fixed << setprecision(4) << tt << " +/-" << setw(6) << std::sqrt(tks.dt2[i])  ;
 
     double sump=0.;
-    for(vector<vertex_t>::const_iterator k=y.begin(); k!=y.end(); k++){
-    if((tks[i].pi>0)&&(tks[i].Z>0)){
-    //double p=pik(beta,tks[i],*k);
-    double p=k->pk * std::exp(-beta*Eik(tks[i],*k)) / tks[i].Z;
+    for(unsigned int k=0; k<y.size(); k++){
+    if((tks.pi[i]>0)&&(tks.Z[i]>0)){
+    //double p=pik(beta,tks,i,y,k);
+    double p=y.pk[k] * std::exp(-beta*Eik(tks, i, y, k)) / tks.Z[i];
     if( p > 0.0001){
       //cout <<  setw (8) <<  setprecision(3) << p;
     }else{
       cout << "    .   ";
     }
-    E+=p*Eik(tks[i],*k);
+    E+=p*Eik(tks, i, y, k);
     sump+=p;
   }else{
       cout << "        ";
@@ -648,47 +905,56 @@ static void dump(const double beta, const vector<vertex_t> &y, const vector<trac
 
 //------------------------------------------------------------------------------
 
-static double update1(double beta, vector<track_t> &tks, vector<vertex_t> &y)
+static double update1(double beta, tracks_t &tks, vertices_t &y, const annealing_t &config)
 {
   //update weights and vertex positions
   // mass constrained annealing without noise
   // returns the squared sum of changes of vertex positions
 
   unsigned int nt=tks.size();
+  unsigned int nv=y.size();
 
   //initialize sums
   double sumpi=0;
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); ++k){
-    k->sw=0.; k->swz=0.; k->swt = 0.; k->se=0.;
-    k->swE=0.;  k->Tc=0.;
+  for(unsigned int k=0; k<nv; k++){
+    y.sw[k]=0.; y.swz[k]=0.; y.swt[k] = 0.; y.se[k]=0.;
+    y.swE[k]=0.;  y.Tc[k]=0.;
   }
 
+  setVertexRange(beta, tks, y, config);
 
   // loop over tracks
   for(unsigned int i=0; i<nt; i++){
 
+    const unsigned int kmin = tks.kmin[i], kmax = tks.kmax[i];
+
     // update pik and Zi
+    for(unsigned int k=kmin; k<kmax; k++){
+      y.ei[k] = -beta*Eik(tks, i, y, k);
+    }
+    expList(&y.ei[0] + kmin, kmax - kmin); // cache exponential for one track at a time
+
     double Zi = 0.;
-    for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); ++k){
-      k->ei = std::exp(-beta*Eik(tks[i],*k));// cache exponential for one track at a time
-      Zi   += k->pk * k->ei;
+    for(unsigned int k=kmin; k<kmax; k++){
+      Zi   += y.pk[k] * y.ei[k];
     }
-    tks[i].Z=Zi;
+    tks.Z[i]=Zi;
 
     // normalization for pk
-    if (tks[i].Z>0){
-      sumpi += tks[i].pi;
+    sumpi += tks.pi[i];
+    if (Zi>0){
       // accumulate weighted z and weights for vertex update
-      for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); ++k){
-  k->se  += tks[i].pi* k->ei / Zi;
-  const double w = k->pk * tks[i].pi* k->ei / ( Zi * ( tks[i].dz2 * tks[i].dt2 ) );
-  k->sw  += w;
-  k->swz += w * tks[i].z;
-        k->swt += w * tks[i].t;
-  k->swE += w * Eik(tks[i],*k);
+      const double zi = tks.z[i], ti = tks.t[i];
+      const double pZi = tks.pi[i] / Zi;
+      const double wi = pZi * tks.dz2inv[i] * tks.dt2inv[i];
+      for(unsigned int k=kmin; k<kmax; k++){
+        y.se[k]  += pZi * y.ei[k];
+        const double w = y.pk[k] * wi * y.ei[k];
+        y.sw[k]  += w;
+        y.swz[k] += w * zi;
+        y.swt[k] += w * ti;
+        y.swE[k] += w * Eik(tks, i, y, k);
       }
-    }else{
-      sumpi += tks[i].pi;
     }
 
 
@@ -697,20 +963,20 @@ static double update1(double beta, vector<track_t> &tks, vector<vertex_t> &y)
 
   // now update z and pk
   double delta=0;
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-    if ( k->sw > 0){
-      const double znew = k->swz/k->sw;
-      const double tnew = k->swt/k->sw;
-      delta += std::pow(k->z-znew,2.) + std::pow(k->t-tnew,2.);
-      k->z  = znew;
-      k->t  = tnew;
-      k->Tc = 2.*k->swE/k->sw;
+  for(unsigned int k=0; k<nv; k++){
+    if ( y.sw[k] > 0){
+      const double znew = y.swz[k]/y.sw[k];
+      const double tnew = y.swt[k]/y.sw[k];
+      delta += std::pow(y.z[k]-znew,2.) + std::pow(y.t[k]-tnew,2.);
+      y.z[k]  = znew;
+      y.t[k]  = tnew;
+      y.Tc[k] = 2.*y.swE[k]/y.sw[k];
     }else{
-      // cout << " a cluster melted away ?  pk=" << k->pk <<  " sumw=" << k->sw <<  endl
-      k->Tc=-1;
+      // cout << " a cluster melted away ?  pk=" << y.pk[k] <<  " sumw=" << y.sw[k] <<  endl
+      y.Tc[k]=-1;
     }
 
-    k->pk = k->pk * k->se / sumpi;
+    y.pk[k] = y.pk[k] * y.se[k] / sumpi;
   }
 
   // return how much the prototypes moved
@@ -719,42 +985,55 @@ static double update1(double beta, vector<track_t> &tks, vector<vertex_t> &y)
 
 //------------------------------------------------------------------------------
 
-static double update2(double beta, vector<track_t> &tks, vector<vertex_t> &y, double &rho0, double dzCutOff)
+static double update2(double beta, tracks_t &tks, vertices_t &y, double &rho0, const annealing_t &config)
 {
   // MVF style, no more vertex weights, update tracks weights and vertex positions, with noise
   // returns the squared sum of changes of vertex positions
 
   unsigned int nt=tks.size();
+  unsigned int nv=y.size();
 
   //initialize sums
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-    k->sw = 0.;   k->swz = 0.; k->swt = 0.; k->se = 0.;
-    k->swE = 0.;  k->Tc=0.;
+  for(unsigned int k=0; k<nv; k++){
+    y.sw[k] = 0.;   y.swz[k] = 0.; y.swt[k] = 0.; y.se[k] = 0.;
+    y.swE[k] = 0.;  y.Tc[k]=0.;
   }
 
+  setVertexRange(beta, tks, y, config);
+
+  const double Z0 = rho0*fastExp(-beta*(config.dzCutOff*config.dzCutOff));// cut-off (eventually add finite size in time)
 
   // loop over tracks
   for(unsigned int i=0; i<nt; i++){
 
+    const unsigned int kmin = tks.kmin[i], kmax = tks.kmax[i];
+
     // update pik and Zi and Ti
-    double Zi = rho0*std::exp(-beta*(dzCutOff*dzCutOff));// cut-off (eventually add finite size in time)
+    for(unsigned int k=kmin; k<kmax; k++){
+      y.ei[k] = -beta*Eik(tks, i, y, k);
+    }
+    expList(&y.ei[0] + kmin, kmax - kmin); // cache exponential for one track at a time
+
+    double Zi = Z0;
     //double Ti = 0.; // dt0*std::exp(-beta*fDtCutOff);
-    for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-      k->ei = std::exp(-beta*Eik(tks[i],*k));// cache exponential for one track at a time
-      Zi   += k->pk * k->ei;
+    for(unsigned int k=kmin; k<kmax; k++){
+      Zi   += y.pk[k] * y.ei[k];
     }
-    tks[i].Z=Zi;
+    tks.Z[i]=Zi;
 
     // normalization
-    if (tks[i].Z>0){
-       // accumulate weighted z and weights for vertex update
-      for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-  k->se += tks[i].pi* k->ei / Zi;
-  double w = k->pk * tks[i].pi * k->ei /( Zi * ( tks[i].dz2 * tks[i].dt2 ) );
-  k->sw  += w;
-  k->swz += w * tks[i].z;
-        k->swt += w * tks[i].t;
-  k->swE += w * Eik(tks[i],*k);
+    if (Zi>0){
+      // accumulate weighted z and weights for vertex update
+      const double zi = tks.z[i], ti = tks.t[i];
+      const double pZi = tks.pi[i] / Zi;
+      const double wi = pZi * tks.dz2inv[i] * tks.dt2inv[i];
+      for(unsigned int k=kmin; k<kmax; k++){
+        y.se[k] += pZi * y.ei[k];
+        const double w = y.pk[k] * wi * y.ei[k];
+        y.sw[k]  += w;
+        y.swz[k] += w * zi;
+        y.swt[k] += w * ti;
+        y.swE[k] += w * Eik(tks, i, y, k);
       }
     }
 
@@ -762,17 +1041,17 @@ static double update2(double beta, vector<track_t> &tks, vector<vertex_t> &y, do
 
   // now update z
   double delta=0;
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-    if ( k->sw > 0){
-      const double znew=k->swz/k->sw;
-      const double tnew=k->swt/k->sw;
-      delta += std::pow(k->z-znew,2.) + std::pow(k->t-tnew,2.);
-      k->z   = znew;
-      k->t   = tnew;
-      k->Tc  = 2*k->swE/k->sw;
+  for(unsigned int k=0; k<nv; k++){
+    if ( y.sw[k] > 0){
+      const double znew=y.swz[k]/y.sw[k];
+      const double tnew=y.swt[k]/y.sw[k];
+      delta += std::pow(y.z[k]-znew,2.) + std::pow(y.t[k]-tnew,2.);
+      y.z[k]   = znew;
+      y.t[k]   = tnew;
+      y.Tc[k]  = 2*y.swE[k]/y.sw[k];
     }else{
-      // cout << " a cluster melted away ?  pk=" << k->pk <<  " sumw=" << k->sw <<  endl;
-      k->Tc = 0;
+      // cout << " a cluster melted away ?  pk=" << y.pk[k] <<  " sumw=" << y.sw[k] <<  endl;
+      y.Tc[k] = 0;
     }
 
   }
@@ -783,24 +1062,24 @@ static double update2(double beta, vector<track_t> &tks, vector<vertex_t> &y, do
 
 //------------------------------------------------------------------------------
 
-static bool merge(vector<vertex_t> &y)
+static bool merge(vertices_t &y)
 {
   // merge clusters that collapsed or never separated, return true if vertices were merged, false otherwise
 
   if(y.size()<2)  return false;
 
-  for(vector<vertex_t>::iterator k=y.begin(); (k+1)!=y.end(); k++){
-    if( std::abs( (k+1)->z - k->z ) < 1.e-3 &&
-        std::abs( (k+1)->t - k->t ) < 1.e-3    ){  // with fabs if only called after freeze-out (splitAll() at highter T)
-      double rho = k->pk + (k+1)->pk;
+  for(unsigned int k=0; k+1<y.size(); k++){
+    if( std::abs( y.z[k+1] - y.z[k] ) < 1.e-3 &&
+        std::abs( y.t[k+1] - y.t[k] ) < 1.e-3    ){  // with fabs if only called after freeze-out (splitAll() at highter T)
+      double rho = y.pk[k] + y.pk[k+1];
       if(rho>0){
-        k->z = ( k->pk * k->z + (k+1)->z * (k+1)->pk)/rho;
-        k->t = ( k->pk * k->t + (k+1)->t * (k+1)->pk)/rho;
+        y.z[k] = ( y.pk[k] * y.z[k] + y.z[k+1] * y.pk[k+1])/rho;
+        y.t[k] = ( y.pk[k] * y.t[k] + y.t[k+1] * y.pk[k+1])/rho;
       }else{
-        k->z = 0.5*(k->z + (k+1)->z);
-        k->t = 0.5*(k->t + (k+1)->t);
+        y.z[k] = 0.5*(y.z[k] + y.z[k+1]);
+        y.t[k] = 0.5*(y.t[k] + y.t[k+1]);
       }
-      k->pk = rho;
+      y.pk[k] = rho;
 
       y.erase(k+1);
       return true;
@@ -812,33 +1091,33 @@ static bool merge(vector<vertex_t> &y)
 
 //------------------------------------------------------------------------------
 
-static bool merge(vector<vertex_t> &y, double &beta)
+static bool merge(vertices_t &y, double &beta)
 {
   // merge clusters that collapsed or never separated,
   // only merge if the estimated critical temperature of the merged vertex is below the current temperature
   // return true if vertices were merged, false otherwise
   if(y.size()<2)  return false;
 
-  for(vector<vertex_t>::iterator k=y.begin(); (k+1)!=y.end(); k++){
-    if ( std::abs((k+1)->z - k->z) < 2.e-3 &&
-         std::abs((k+1)->t - k->t) < 2.e-3    ) {
-      double rho=k->pk + (k+1)->pk;
-      double swE=k->swE+(k+1)->swE - k->pk * (k+1)->pk / rho * ( std::pow((k+1)->z - k->z,2.) +
-                                                                 std::pow((k+1)->t - k->t,2.)   );
-      double Tc=2*swE/(k->sw+(k+1)->sw);
+  for(unsigned int k=0; k+1<y.size(); k++){
+    if ( std::abs(y.z[k+1] - y.z[k]) < 2.e-3 &&
+         std::abs(y.t[k+1] - y.t[k]) < 2.e-3    ) {
+      double rho=y.pk[k] + y.pk[k+1];
+      double swE=y.swE[k]+y.swE[k+1] - y.pk[k] * y.pk[k+1] / rho * ( std::pow(y.z[k+1] - y.z[k],2.) +
+                                                                     std::pow(y.t[k+1] - y.t[k],2.)   );
+      double Tc=2*swE/(y.sw[k]+y.sw[k+1]);
 
       if(Tc*beta<1){
   if(rho>0){
-    k->z = ( k->pk * k->z + (k+1)->z * (k+1)->pk)/rho;
-          k->t = ( k->pk * k->t + (k+1)->t * (k+1)->pk)/rho;
+    y.z[k] = ( y.pk[k] * y.z[k] + y.z[k+1] * y.pk[k+1])/rho;
+          y.t[k] = ( y.pk[k] * y.t[k] + y.t[k+1] * y.pk[k+1])/rho;
   }else{
-    k->z = 0.5*(k->z + (k+1)->z);
-          k->t = 0.5*(k->t + (k+1)->t);
+    y.z[k] = 0.5*(y.z[k] + y.z[k+1]);
+          y.t[k] = 0.5*(y.t[k] + y.t[k+1]);
   }
-  k->pk  = rho;
-  k->sw += (k+1)->sw;
-  k->swE = swE;
-  k->Tc  = Tc;
+  y.pk[k]  = rho;
+  y.sw[k] += y.sw[k+1];
+  y.swE[k] = swE;
+  y.Tc[k]  = Tc;
   y.erase(k+1);
   return true;
       }
@@ -850,23 +1129,23 @@ static bool merge(vector<vertex_t> &y, double &beta)
 
 //------------------------------------------------------------------------------
 
-static bool purge(vector<vertex_t> &y, vector<track_t> &tks, double & rho0, const double beta, const double dzCutOff)
+static bool purge(vertices_t &y, tracks_t &tks, double & rho0, const double beta, const annealing_t &config)
 {
   // eliminate clusters with only one significant/unique track
   if(y.size()<2)  return false;
 
   unsigned int nt=tks.size();
   double sumpmin=nt;
-  vector<vertex_t>::iterator k0=y.end();
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
+  int k0=-1;
+  for(unsigned int k=0; k<y.size(); k++){
     int nUnique=0;
     double sump=0;
-    double pmax=k->pk/(k->pk+rho0*exp(-beta*dzCutOff*dzCutOff));
+    double pmax=y.pk[k]/(y.pk[k]+rho0*exp(-beta*config.dzCutOff*config.dzCutOff));
     for(unsigned int i=0; i<nt; i++){
-      if(tks[i].Z > 0){
-  double p = k->pk * std::exp(-beta*Eik(tks[i],*k)) / tks[i].Z ;
+      if(tks.Z[i] > 0 && inWindow(beta, tks, i, y.z[k], config)){
+  double p = y.pk[k] * fastExp(-beta*Eik(tks, i, y, k)) / tks.Z[i] ;
   sump+=p;
-  if( (p > 0.9*pmax) && (tks[i].pi>0) ){ nUnique++; }
+  if( (p > 0.9*pmax) && (tks.pi[i]>0) ){ nUnique++; }
       }
     }
 
@@ -876,9 +1155,9 @@ static bool purge(vector<vertex_t> &y, vector<track_t> &tks, double & rho0, cons
     }
   }
 
-  if(k0!=y.end()){
-    //cout << "eliminating prototype at " << k0->z << "," << k0->t << " with sump=" << sumpmin << endl;
-    //rho0+=k0->pk;
+  if(k0>=0){
+    //cout << "eliminating prototype at " << y.z[k0] << "," << y.t[k0] << " with sump=" << sumpmin << endl;
+    //rho0+=y.pk[k0];
     y.erase(k0);
     return true;
   }else{
@@ -888,35 +1167,35 @@ static bool purge(vector<vertex_t> &y, vector<track_t> &tks, double & rho0, cons
 
 //------------------------------------------------------------------------------
 
-static double beta0(double betamax, vector<track_t> &tks, vector<vertex_t> &y, const double coolingFactor)
+static double beta0(double betamax, tracks_t &tks, vertices_t &y, const double coolingFactor)
 {
 
   double T0=0;  // max Tc for beta=0
   // estimate critical temperature from beta=0 (T=inf)
   unsigned int nt=tks.size();
 
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
+  for(unsigned int k=0; k<y.size(); k++){
 
     // vertex fit at T=inf
     double sumwz=0.;
     double sumwt=0.;
     double sumw=0.;
     for(unsigned int i=0; i<nt; i++){
-      double w = tks[i].pi/(tks[i].dz2 * tks[i].dt2);
-      sumwz += w*tks[i].z;
-      sumwt += w*tks[i].t;
+      double w = tks.pi[i]*tks.dz2inv[i]*tks.dt2inv[i];
+      sumwz += w*tks.z[i];
+      sumwt += w*tks.t[i];
       sumw  += w;
     }
-    k->z = sumwz/sumw;
-    k->t = sumwt/sumw;
+    y.z[k] = sumwz/sumw;
+    y.t[k] = sumwt/sumw;
 
     // estimate Tcrit, eventually do this in the same loop
     double a=0, b=0;
     for(unsigned int i=0; i<nt; i++){
-      double dx = tks[i].z-(k->z);
-      double dt = tks[i].t-(k->t);
-      double w  = tks[i].pi/(tks[i].dz2 * tks[i].dt2);
-      a += w*(std::pow(dx,2.)/tks[i].dz2 + std::pow(dt,2.)/tks[i].dt2);
+      double dx = tks.z[i]-y.z[k];
+      double dt = tks.t[i]-y.t[k];
+      double w  = tks.pi[i]*tks.dz2inv[i]*tks.dt2inv[i];
+      a += w*(dx*dx*tks.dz2inv[i] + dt*dt*tks.dt2inv[i]);
       b += w;
     }
     double Tc= 2.*a/b;  // the critical temperature of this vertex
@@ -933,7 +1212,7 @@ static double beta0(double betamax, vector<track_t> &tks, vector<vertex_t> &y, c
 
 //------------------------------------------------------------------------------
 
-static bool split(double beta, vector<track_t> &tks, vector<vertex_t> &y)
+static bool split(double beta, tracks_t &tks, vertices_t &y, const annealing_t &config)
 {
   // split only critical vertices (Tc >~ T=1/beta   <==>   beta*Tc>~1)
   // an update must have been made just before doing this (same beta, no merging)
@@ -946,8 +1225,8 @@ static bool split(double beta, vector<track_t> &tks, vector<vertex_t> &y)
 
   std::vector<std::pair<double, unsigned int> > critical;
   for(unsigned int ik=0; ik<y.size(); ik++){
-    if (beta*y[ik].Tc > 1.){
-      critical.push_back( make_pair(y[ik].Tc, ik));
+    if (beta*y.Tc[ik] > 1.){
+      critical.push_back( make_pair(y.Tc[ik], ik));
     }
   }
   std::stable_sort(critical.begin(), critical.end(), std::greater<std::pair<double, unsigned int> >() );
@@ -959,35 +1238,32 @@ static bool split(double beta, vector<track_t> &tks, vector<vertex_t> &y)
     double p2=0, z2=0, t2=0, w2=0;
     //double sumpi=0;
     for(unsigned int i=0; i<tks.size(); i++){
-      if(tks[i].Z>0){
-  //sumpi+=tks[i].pi;
-  double p=y[ik].pk * exp(-beta*Eik(tks[i],y[ik])) / tks[i].Z*tks[i].pi;
-  double w=p/(tks[i].dz2 * tks[i].dt2);
-  if(tks[i].z < y[ik].z){
-    p1+=p; z1+=w*tks[i].z; t1+=w*tks[i].t; w1+=w;
+      if(tks.Z[i]>0 && inWindow(beta, tks, i, y.z[ik], config)){
+  //sumpi+=tks.pi[i];
+  double p=y.pk[ik] * fastExp(-beta*Eik(tks, i, y, ik)) / tks.Z[i]*tks.pi[i];
+  double w=p*tks.dz2inv[i]*tks.dt2inv[i];
+  if(tks.z[i] < y.z[ik]){
+    p1+=p; z1+=w*tks.z[i]; t1+=w*tks.t[i]; w1+=w;
   }else{
-    p2+=p; z2+=w*tks[i].z; t2+=w*tks[i].t; w2+=w;
+    p2+=p; z2+=w*tks.z[i]; t2+=w*tks.t[i]; w2+=w;
   }
       }
     }
-    if(w1>0){  z1=z1/w1; t1=t1/w1;} else{ z1=y[ik].z-epsilon; t1=y[ik].t-epsilon; }
-    if(w2>0){  z2=z2/w2; t2=t2/w2;} else{ z2=y[ik].z+epsilon; t2=y[ik].t+epsilon;}
+    if(w1>0){  z1=z1/w1; t1=t1/w1;} else{ z1=y.z[ik]-epsilon; t1=y.t[ik]-epsilon; }
+    if(w2>0){  z2=z2/w2; t2=t2/w2;} else{ z2=y.z[ik]+epsilon; t2=y.t[ik]+epsilon;}
 
     // reduce split size if there is not enough room
-    if( ( ik   > 0       ) && ( y[ik-1].z>=z1 ) ){ z1=0.5*(y[ik].z+y[ik-1].z); t1=0.5*(y[ik].t+y[ik-1].t); }
-    if( ( ik+1 < y.size()) && ( y[ik+1].z<=z2 ) ){ z2=0.5*(y[ik].z+y[ik+1].z); t2=0.5*(y[ik].t+y[ik+1].t); }
+    if( ( ik   > 0       ) && ( y.z[ik-1]>=z1 ) ){ z1=0.5*(y.z[ik]+y.z[ik-1]); t1=0.5*(y.t[ik]+y.t[ik-1]); }
+    if( ( ik+1 < y.size()) && ( y.z[ik+1]<=z2 ) ){ z2=0.5*(y.z[ik]+y.z[ik+1]); t2=0.5*(y.t[ik]+y.t[ik+1]); }
 
     // split if the new subclusters are significantly separated
     if( (z2-z1)>epsilon || std::abs(t2-t1) > epsilon){
       split=true;
-      vertex_t vnew;
-      vnew.pk = p1*y[ik].pk/(p1+p2);
-      y[ik].pk= p2*y[ik].pk/(p1+p2);
-      vnew.z  = z1;
-      vnew.t  = t1;
-      y[ik].z = z2;
-      y[ik].t = t2;
-      y.insert(y.begin()+ik, vnew);
+      double pk1 = p1*y.pk[ik]/(p1+p2);
+      y.pk[ik]= p2*y.pk[ik]/(p1+p2);
+      y.z[ik] = z2;
+      y.t[ik] = t2;
+      y.insert(ik, z1, t1, pk1);
 
      // adjust remaining pointers
       for(unsigned int jc=ic; jc<critical.size(); jc++){
@@ -1002,7 +1278,7 @@ static bool split(double beta, vector<track_t> &tks, vector<vertex_t> &y)
 
 //------------------------------------------------------------------------------
 
-void splitAll(vector<vertex_t> &y)
+void splitAll(vertices_t &y)
 {
 
 
@@ -1010,34 +1286,27 @@ void splitAll(vector<vertex_t> &y)
   const double zsep=2*epsilon;    // split vertices that are isolated by at least zsep (vertices that haven't collapsed)
   const double tsep=2*epsilon;    // check t as well
 
-  vector<vertex_t> y1;
+  vertices_t y1;
 
-  for(vector<vertex_t>::iterator k=y.begin(); k!=y.end(); k++){
-    if ( ( (k==y.begin())|| (k-1)->z < k->z - zsep) && (((k+1)==y.end()  )|| (k+1)->z > k->z + zsep)) {
+  for(unsigned int k=0; k<y.size(); k++){
+    if ( ( (k==0)|| y.z[k-1] < y.z[k] - zsep) && (((k+1)==y.size()  )|| y.z[k+1] > y.z[k] + zsep)) {
       // isolated prototype, split
-      vertex_t vnew;
-      vnew.z  = k->z - epsilon;
-      vnew.t  = k->t - epsilon;
-      (*k).z  = k->z + epsilon;
-      (*k).t  = k->t + epsilon;
-      vnew.pk= 0.5* (*k).pk;
-      (*k).pk= 0.5* (*k).pk;
-      y1.push_back(vnew);
-      y1.push_back(*k);
-
-    }else if( y1.empty() || (y1.back().z < k->z -zsep) || (y1.back().t < k->t - tsep) ){
-      y1.push_back(*k);
+      y1.add(y.z[k] - epsilon, y.t[k] - epsilon, 0.5*y.pk[k]);
+      y.z[k]  = y.z[k] + epsilon;
+      y.t[k]  = y.t[k] + epsilon;
+      y.pk[k] = 0.5*y.pk[k];
+      y1.add(y.z[k], y.t[k], y.pk[k]);
+
+    }else if( y1.size()==0 || (y1.z.back() < y.z[k] -zsep) || (y1.t.back() < y.t[k] - tsep) ){
+      y1.add(y.z[k], y.t[k], y.pk[k]);
     }else{
-      y1.back().z -= epsilon;
-      y1.back().t -= epsilon;
-      k->z += epsilon;
-      k->t += epsilon;
-      y1.push_back(*k);
+      y1.z.back() -= epsilon;
+      y1.t.back() -= epsilon;
+      y.z[k] += epsilon;
+      y.t[k] += epsilon;
+      y1.add(y.z[k], y.t[k], y.pk[k]);
     }
   }// vertex loop
 
   y=y1;
 }
-
-
-
@@ -29,6 +29,8 @@ public:
   void Process();
   void Finish();
 
+  Bool_t ModifiesInputs() const { return kTRUE; }
+
   void clusterize(const TObjArray &tracks, TObjArray &clusters);
   std::vector< Candidate* > vertices();
 
@@ -48,6 +50,9 @@ private:
   Double_t fD0CutOff;
   Double_t fDtCutOff; // for when the beamspot has time
 
+  Bool_t fUseZWindow;
+  Double_t fZRegionGap;
+
   TObjArray *fInputArray;
   TIterator *fItInputArray;
 
@@ -87,7 +87,7 @@ void Weighter::Init()
   TIndexStruct index;
   Double_t weight;
 
-  fWeightSet.clear();
+  fWeightTable.Clear();
 
 
   // set default weight value
@@ -115,7 +115,7 @@ void Weighter::Init()
     {
       code = paramCodes[j].GetInt();
       index.codes[j] = code;
-      fWeightSet.insert(code);
+      fWeightTable.Insert(code, 1);
     }
 
     sort(index.codes, index.codes + 4);
@@ -160,7 +160,7 @@ void Weighter::Process()
   {
     if(candidate->Status != 3) continue;
 
-    if(fWeightSet.find(candidate->PID) == fWeightSet.end()) continue;
+    if(!fWeightTable.Find(candidate->PID)) continue;
 
     fCodeSet.insert(candidate->PID);
   }
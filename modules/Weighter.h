@@ -29,6 +29,10 @@
 
 #include "classes/DelphesModule.h"
 
+#if !defined(__CINT__) && !defined(__CLING__)
+#include "classes/DelphesPIDTable.h"
+#endif
+
 #include <set>
 #include <map>
 
@@ -54,7 +58,8 @@ private:
     bool operator< (const TIndexStruct &value) const;
   };
 
-  std::set<Int_t> fWeightSet, fCodeSet;
+  DelphesPIDTable<Int_t> fWeightTable;
+  std::set<Int_t> fCodeSet;
   std::map<TIndexStruct, Double_t> fWeightMap;
 #endif
 
@@ -26,6 +26,7 @@
 #include "TApplication.h"
 
 #include "TFile.h"
+#include "TRandom.h"
 #include "TObjArray.h"
 #include "TStopwatch.h"
 #include "TDatabasePDG.h"
@@ -36,6 +37,9 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesHepMCReader.h"
+#include "classes/DelphesWorkers.h"
+#include "classes/DelphesInputFile.h"
+#include "classes/DelphesEventIndex.h"
 
 #include "ExRootAnalysis/ExRootTreeWriter.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
@@ -68,12 +72,19 @@ int main(int argc, char *argv[])
   DelphesFactory *factory = 0;
   TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
   DelphesHepMCReader *reader = 0;
-  Int_t i, maxEvents, skipEvents;
-  Long64_t length, eventCounter;
+  DelphesWorkers *workerPool = 0;
+  DelphesInputFile inputStream;
+  DelphesEventIndex eventIndex;
+  Int_t i, maxEvents, skipEvents, indexStep, seed, workers, worker = -1;
+  Bool_t splitFiles = kFALSE, indexed, ranged;
+  Long64_t length, eventCounter, firstEvent, lastEvent;
 
-  if(argc < 3)
+  workers = DelphesWorkers::ReadOption(argc, argv);
+
+  if(argc < 3 || workers < 1)
   {
-    cout << " Usage: " << appName << " config_file" << " output_file" << " [input_file(s)]" << endl;
+    cout << " Usage: " << appName << " [--workers N]" << " config_file" << " output_file" << " [input_file(s)]" << endl;
+    cout << " --workers N - number of processes forked after initialisation," << endl;
     cout << " config_file - configuration file in Tcl format," << endl;
     cout << " output_file - output file in ROOT format," << endl;
     cout << " input_file(s) - input file(s) in HepMC format," << endl;
@@ -109,6 +120,7 @@ int main(int argc, char *argv[])
 
     maxEvents = confReader->GetInt("::MaxEvents", 0);
     skipEvents = confReader->GetInt("::SkipEvents", 0);
+    indexStep = confReader->GetInt("::EventIndex", 0);
 
     if(maxEvents < 0)
     {
@@ -133,6 +145,85 @@ int main(int argc, char *argv[])
 
     modularDelphes->InitTask();
 
+    if(workers > 1)
+    {
+      for(i = 3; i < argc; ++i)
+      {
+        if(strncmp(argv[i], "-", 2) == 0) break;
+      }
+
+      if(argc == 3 || i < argc)
+      {
+        throw runtime_error("standard input can't be shared by several workers");
+      }
+
+      // index the input files once for all workers
+      if(indexStep > 0)
+      {
+        for(i = 3; i < argc; ++i)
+        {
+          if(inputStream.Open(argv[i]) && inputStream.IsSeekable()) eventIndex.Load(argv[i], "E ", indexStep);
+          inputStream.Close();
+        }
+      }
+
+      workerPool = new DelphesWorkers(workers);
+      worker = workerPool->Fork();
+
+      if(worker < 0)
+      {
+        // parent process, the workers have written their own output files
+        modularDelphes->FinishTask();
+
+        delete reader;
+        delete modularDelphes;
+        delete confReader;
+        delete treeWriter;
+        delete outputFile;
+        treeWriter = 0;
+        outputFile = 0;
+
+        if(workerPool->GetFailures() > 0)
+        {
+          message << workerPool->GetFailures() << " of " << workers << " workers failed";
+          throw runtime_error(message.str());
+        }
+
+        cout << "** Merging outputs of " << workers << " workers" << endl;
+
+        if(!workerPool->Merge(argv[2]))
+        {
+          message << "can't merge outputs of workers into " << argv[2];
+          message << ", they are kept in " << DelphesWorkers::GetOutputName(argv[2], 0);
+          message << " to " << DelphesWorkers::GetOutputName(argv[2], workers - 1);
+          throw runtime_error(message.str());
+        }
+
+        delete workerPool;
+
+        cout << "** Exiting..." << endl;
+
+        return 0;
+      }
+
+      // worker process, with its own output file and random numbers
+      outputFile = TFile::Open(DelphesWorkers::GetOutputName(argv[2], worker), "RECREATE");
+
+      if(outputFile == NULL)
+      {
+        message << "can't create output file " << DelphesWorkers::GetOutputName(argv[2], worker);
+        throw runtime_error(message.str());
+      }
+
+      treeWriter->ChangeFile(outputFile);
+
+      seed = confReader->GetInt("::RandomSeed", 0);
+      gRandom->SetSeed(seed > 0 ? seed + worker : 0);
+
+      // without event limits every worker reads its own part of each file
+      splitFiles = (maxEvents <= 0 && skipEvents <= 0);
+    }
+
     i = 3;
     do
     {
@@ -141,43 +232,72 @@ int main(int argc, char *argv[])
       if(i == argc || strncmp(argv[i], "-", 2) == 0)
       {
         cout << "** Reading standard input" << endl;
-        inputFile = stdin;
-        length = -1;
+        inputFile = inputStream.Open(0);
       }
       else
       {
         cout << "** Reading " << argv[i] << endl;
-        inputFile = fopen(argv[i], "r");
+        inputFile = inputStream.Open(argv[i]);
+      }
 
-        if(inputFile == NULL)
-        {
-          message << "can't open " << argv[i];
-          throw runtime_error(message.str());
-        }
+      if(inputFile == NULL)
+      {
+        message << "can't open " << (i < argc ? argv[i] : "standard input");
+        throw runtime_error(message.str());
+      }
 
-        fseek(inputFile, 0L, SEEK_END);
-        length = ftello(inputFile);
-        fseek(inputFile, 0L, SEEK_SET);
+      // size of the file before decompression, -1 for pipes
+      length = inputStream.GetLength();
 
-        if(length <= 0)
-        {
-          fclose(inputFile);
-          ++i;
-          continue;
-        }
+      if(length == 0)
+      {
+        inputStream.Close();
+        ++i;
+        continue;
       }
 
       reader->SetInputFile(inputFile);
 
-      ExRootProgressBar progressBar(length);
+      // events [firstEvent, lastEvent) of the file, all events if lastEvent < 0
+      firstEvent = skipEvents;
+      lastEvent = maxEvents > 0 ? skipEvents + maxEvents : -1;
+      eventCounter = 0;
+
+      indexed = (indexStep > 0 && inputStream.IsSeekable() && eventIndex.Load(argv[i], "E ", indexStep));
+
+      // compressed files are read by all workers, which process every N-th event
+      ranged = indexed || (splitFiles && inputStream.IsSeekable());
+
+      if(indexed)
+      {
+        if(lastEvent < 0 || lastEvent > eventIndex.GetEvents()) lastEvent = eventIndex.GetEvents();
+        if(firstEvent > lastEvent) firstEvent = lastEvent;
+
+        // workers process consecutive blocks of events
+        if(worker >= 0)
+        {
+          eventCounter = eventIndex.GetPartStart(firstEvent, lastEvent, worker, workers);
+          lastEvent = eventIndex.GetPartStart(firstEvent, lastEvent, worker + 1, workers);
+          firstEvent = eventCounter;
+        }
+
+        // seek to the last indexed event before the first event
+        eventCounter = eventIndex.GetIndexedEvent(firstEvent);
+        reader->SetInputRange(eventIndex.GetOffset(eventCounter), -1);
+      }
+      else if(ranged)
+      {
+        reader->SetInputRange(length*worker/workers, length*(worker + 1)/workers);
+      }
+
+      ExRootProgressBar progressBar(indexed ? lastEvent : length);
 
       // Loop over all objects
-      eventCounter = 0;
       treeWriter->Clear();
       modularDelphes->Clear();
       reader->Clear();
       readStopWatch.Start();
-      while((maxEvents <= 0 || eventCounter - skipEvents < maxEvents) &&
+      while((lastEvent < 0 || eventCounter < lastEvent) &&
         reader->ReadBlock(factory, allParticleOutputArray,
         stableParticleOutputArray, partonOutputArray) && !interrupted)
       {
@@ -187,7 +307,8 @@ int main(int argc, char *argv[])
 
           readStopWatch.Stop();
 
-          if(eventCounter > skipEvents)
+          // otherwise workers process every N-th event
+          if(eventCounter > firstEvent && (worker < 0 || ranged || (eventCounter - firstEvent - 1) % workers == worker))
           {
             procStopWatch.Start();
             modularDelphes->ProcessTask();
@@ -206,14 +327,16 @@ int main(int argc, char *argv[])
 
           readStopWatch.Start();
         }
-        progressBar.Update(ftello(inputFile), eventCounter);
+        if(worker <= 0) progressBar.Update(indexed ? eventCounter : inputStream.GetPosition(), eventCounter);
       }
 
-      fseek(inputFile, 0L, SEEK_END);
-      progressBar.Update(ftello(inputFile), eventCounter, kTRUE);
-      progressBar.Finish();
+      if(worker <= 0)
+      {
+        progressBar.Update(indexed ? lastEvent : length, eventCounter, kTRUE);
+        progressBar.Finish();
+      }
 
-      if(inputFile != stdin) fclose(inputFile);
+      inputStream.Close();
 
       ++i;
     }
@@ -230,13 +353,16 @@ int main(int argc, char *argv[])
     delete treeWriter;
     delete outputFile;
 
+    if(worker >= 0) DelphesWorkers::Exit(0);
+
     return 0;
   }
   catch(runtime_error &e)
   {
+    cerr << "** ERROR: " << e.what() << endl;
+    if(worker >= 0) DelphesWorkers::Exit(1);
     if(treeWriter) delete treeWriter;
     if(outputFile) delete outputFile;
-    cerr << "** ERROR: " << e.what() << endl;
     return 1;
   }
 }
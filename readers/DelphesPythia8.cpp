@@ -227,6 +227,8 @@ int main(int argc, char *argv[])
   TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
   TObjArray *stableParticleOutputArrayLHEF = 0, *allParticleOutputArrayLHEF = 0, *partonOutputArrayLHEF = 0;
   DelphesLHEFReader *reader = 0;
+  ExRootConfParam param;
+  Int_t i;
   Long64_t eventCounter, errorCounter;
   Long64_t numberOfEvents, timesAllowErrors;
   Bool_t spareFlag1;
@@ -324,6 +326,13 @@ int main(int argc, char *argv[])
         reader = new DelphesLHEFReader;
         reader->SetInputFile(inputFile);
 
+        if(confReader->GetBool("::SkipWeights", false)) reader->SkipWeights();
+        param = confReader->GetParam("::WeightIDs");
+        for(i = 0; i < param.GetSize(); ++i)
+        {
+          reader->SelectWeight(param[i].GetString());
+        }
+
         branchEventLHEF = treeWriter->NewBranch("EventLHEF", LHEFEvent::Class());
         branchWeightLHEF = treeWriter->NewBranch("WeightLHEF", LHEFWeight::Class());
 
@@ -26,6 +26,7 @@
 #include "TApplication.h"
 
 #include "TFile.h"
+#include "TRandom.h"
 #include "TObjArray.h"
 #include "TStopwatch.h"
 #include "TDatabasePDG.h"
@@ -36,6 +37,8 @@
 #include "classes/DelphesClasses.h"
 #include "classes/DelphesFactory.h"
 #include "classes/DelphesSTDHEPReader.h"
+#include "classes/DelphesWorkers.h"
+#include "classes/DelphesInputFile.h"
 
 #include "ExRootAnalysis/ExRootTreeWriter.h"
 #include "ExRootAnalysis/ExRootTreeBranch.h"
@@ -68,12 +71,17 @@ int main(int argc, char *argv[])
   DelphesFactory *factory = 0;
   TObjArray *stableParticleOutputArray = 0, *allParticleOutputArray = 0, *partonOutputArray = 0;
   DelphesSTDHEPReader *reader = 0;
-  Int_t i, maxEvents, skipEvents;
+  DelphesWorkers *workerPool = 0;
+  DelphesInputFile inputStream;
+  Int_t i, maxEvents, skipEvents, seed, workers, worker = -1;
   Long64_t length, eventCounter;
 
-  if(argc < 3)
+  workers = DelphesWorkers::ReadOption(argc, argv);
+
+  if(argc < 3 || workers < 1)
   {
-    cout << " Usage: " << appName << " config_file" << " output_file" << " [input_file(s)]" << endl;
+    cout << " Usage: " << appName << " [--workers N]" << " config_file" << " output_file" << " [input_file(s)]" << endl;
+    cout << " --workers N - number of processes forked after initialisation," << endl;
     cout << " config_file - configuration file in Tcl format," << endl;
     cout << " output_file - output file in ROOT format," << endl;
     cout << " input_file(s) - input file(s) in STDHEP format," << endl;
@@ -132,6 +140,72 @@ int main(int argc, char *argv[])
 
     modularDelphes->InitTask();
 
+    if(workers > 1)
+    {
+      for(i = 3; i < argc; ++i)
+      {
+        if(strncmp(argv[i], "-", 2) == 0) break;
+      }
+
+      if(argc == 3 || i < argc)
+      {
+        throw runtime_error("standard input can't be shared by several workers");
+      }
+
+      workerPool = new DelphesWorkers(workers);
+      worker = workerPool->Fork();
+
+      if(worker < 0)
+      {
+        // parent process, the workers have written their own output files
+        modularDelphes->FinishTask();
+
+        delete reader;
+        delete modularDelphes;
+        delete confReader;
+        delete treeWriter;
+        delete outputFile;
+        treeWriter = 0;
+        outputFile = 0;
+
+        if(workerPool->GetFailures() > 0)
+        {
+          message << workerPool->GetFailures() << " of " << workers << " workers failed";
+          throw runtime_error(message.str());
+        }
+
+        cout << "** Merging outputs of " << workers << " workers" << endl;
+
+        if(!workerPool->Merge(argv[2]))
+        {
+          message << "can't merge outputs of workers into " << argv[2];
+          message << ", they are kept in " << DelphesWorkers::GetOutputName(argv[2], 0);
+          message << " to " << DelphesWorkers::GetOutputName(argv[2], workers - 1);
+          throw runtime_error(message.str());
+        }
+
+        delete workerPool;
+
+        cout << "** Exiting..." << endl;
+
+        return 0;
+      }
+
+      // worker process, with its own output file and random numbers
+      outputFile = TFile::Open(DelphesWorkers::GetOutputName(argv[2], worker), "RECREATE");
+
+      if(outputFile == NULL)
+      {
+        message << "can't create output file " << DelphesWorkers::GetOutputName(argv[2], worker);
+        throw runtime_error(message.str());
+      }
+
+      treeWriter->ChangeFile(outputFile);
+
+      seed = confReader->GetInt("::RandomSeed", 0);
+      gRandom->SetSeed(seed > 0 ? seed + worker : 0);
+    }
+
     i = 3;
     do
     {
@@ -140,30 +214,28 @@ int main(int argc, char *argv[])
       if(i == argc || strncmp(argv[i], "-", 2) == 0)
       {
         cout << "** Reading standard input" << endl;
-        inputFile = stdin;
-        length = -1;
+        inputFile = inputStream.Open(0);
       }
       else
       {
         cout << "** Reading " << argv[i] << endl;
-        inputFile = fopen(argv[i], "rb");
+        inputFile = inputStream.Open(argv[i]);
+      }
 
-        if(inputFile == NULL)
-        {
-          message << "can't open " << argv[i];
-          throw runtime_error(message.str());
-        }
+      if(inputFile == NULL)
+      {
+        message << "can't open " << (i < argc ? argv[i] : "standard input");
+        throw runtime_error(message.str());
+      }
 
-        fseek(inputFile, 0L, SEEK_END);
-        length = ftello(inputFile);
-        fseek(inputFile, 0L, SEEK_SET);
+      // size of the file before decompression, -1 for pipes
+      length = inputStream.GetLength();
 
-        if(length <= 0)
-        {
-          fclose(inputFile);
-          ++i;
-          continue;
-        }
+      if(length == 0)
+      {
+        inputStream.Close();
+        ++i;
+        continue;
       }
 
       reader->SetInputFile(inputFile);
@@ -186,7 +258,8 @@ int main(int argc, char *argv[])
 
           readStopWatch.Stop();
 
-          if(eventCounter > skipEvents)
+          // workers process every N-th event
+          if(eventCounter > skipEvents && (worker < 0 || (eventCounter - skipEvents - 1) % workers == worker))
           {
             procStopWatch.Start();
             modularDelphes->ProcessTask();
@@ -204,14 +277,16 @@ int main(int argc, char *argv[])
 
           readStopWatch.Start();
         }
-        progressBar.Update(ftello(inputFile), eventCounter);
+        if(worker <= 0) progressBar.Update(inputStream.GetPosition(), eventCounter);
       }
 
-      fseek(inputFile, 0L, SEEK_END);
-      progressBar.Update(ftello(inputFile), eventCounter, kTRUE);
-      progressBar.Finish();
+      if(worker <= 0)
+      {
+        progressBar.Update(length, eventCounter, kTRUE);
+        progressBar.Finish();
+      }
 
-      if(inputFile != stdin) fclose(inputFile);
+      inputStream.Close();
 
       ++i;
     }
@@ -228,13 +303,16 @@ int main(int argc, char *argv[])
     delete treeWriter;
     delete outputFile;
 
+    if(worker >= 0) DelphesWorkers::Exit(0);
+
     return 0;
   }
   catch(runtime_error &e)
   {
+    cerr << "** ERROR: " << e.what() << endl;
+    if(worker >= 0) DelphesWorkers::Exit(1);
     if(treeWriter) delete treeWriter;
     if(outputFile) delete outputFile;
-    cerr << "** ERROR: " << e.what() << endl;
     return 1;
   }
 }